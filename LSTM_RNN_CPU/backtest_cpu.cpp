@@ -0,0 +1,231 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include "data_io.h"
+#include "lstm_cache.h"
+#include "lstm_weight_io.h"
+#include "prediction_metrics.h"
+#include "thread_pool.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Default sequence length
+#define CHUNK_WINDOWS 64  // Consecutive windows per task
+
+// Per-worker model state, built on first use by each worker
+struct BacktestWorker {
+    LstmWorkspace<float> ws;
+    LstmProjectionCache<float> cache;
+    std::vector<float> h, c;
+    PredictionMetrics metrics;   // this worker's windows, merged at the end
+
+    BacktestWorker(const PackedLstmWeights<float> &weights, int seq_length)
+        : ws(weights), cache(weights, seq_length + CHUNK_WINDOWS + LSTM_PROJECT_CHUNK),
+          h(weights.hidden_size), c(weights.hidden_size), metrics(INPUT_SIZE) {}
+};
+
+// Walk-forward backtest over one long history: every window of seq_length
+// bars predicts the bar right after it. Windows are split into chunks that a
+// work-stealing pool spreads across cores; each chunk reuses its worker's
+// projection cache because neighbouring windows share all but one bar.
+// Accuracy, RMSE and hit rate are accumulated per worker as each prediction
+// lands, so --metrics-only reports them without writing the outputs files.
+// Bars are normalized with statistics of the bars up to them (expanding, or
+// trailing with --norm-window), so no window sees later prices;
+// --norm-full-history opts into the whole-history statistics lstm_cpu uses.
+int main(int argc, char **argv) {
+    int hidden_size = 16;
+    int seq_length = SEQ_LENGTH;
+    int threads = 0;
+    long norm_window = 0;
+    bool norm_full_history = false;
+    std::string data_file;
+    std::string stats_file_name = NORMALIZER_FILE;
+    std::string weights_file_name, activation_name;
+    std::string prediction_file_name = "outputs_lstm_cpu.txt";
+    std::string real_file_name = "outputs_real.txt";
+    std::string metrics_file_name = "prediction_accuracy_metrics.txt";
+    bool write_outputs = true;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hidden" && i + 1 < argc) {
+            hidden_size = std::atoi(argv[++i]);
+        } else if (arg == "--seq" && i + 1 < argc) {
+            seq_length = std::atoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--norm-window" && i + 1 < argc) {
+            norm_window = std::atol(argv[++i]);
+        } else if (arg == "--norm-full-history") {
+            norm_full_history = true;
+        } else if (arg == "--stats" && i + 1 < argc) {
+            stats_file_name = argv[++i];
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            prediction_file_name = argv[++i];
+        } else if (arg == "--real" && i + 1 < argc) {
+            real_file_name = argv[++i];
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metrics_file_name = argv[++i];
+        } else if (arg == "--metrics-only") {
+            write_outputs = false;
+        } else {
+            data_file = arg;
+        }
+    }
+
+    if (data_file.empty() || hidden_size < INPUT_SIZE || seq_length <= 0 || norm_window < 0 ||
+        (norm_full_history && norm_window > 0)) {
+        std::cerr << "Usage: " << argv[0] << " [--hidden N] [--seq N] [--threads N] [--norm-window N | --norm-full-history]"
+                  << " [--stats File]"
+                  << " [--weights File] [--act Tier] [--out File] [--real File] [--metrics File] [--metrics-only]"
+                  << " <Data File>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    DataTable table;
+    if (!load_table(data_file, table) || table.num_features != INPUT_SIZE) {
+        std::cerr << "Error: Expected " << INPUT_SIZE << "-feature data in " << data_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    const long rows = table.rows();
+    if (rows <= seq_length) {
+        std::cerr << "Error: Need more than " << seq_length << " rows, got " << rows << std::endl;
+        return EXIT_FAILURE;
+    }
+    const long windows = rows - seq_length;
+
+    // Every bar is normalized by the statistics of the bars up to and
+    // including it: all of them by default, the trailing --norm-window N
+    // otherwise. No window sees later bars, and each prediction is
+    // denormalized with the statistics of the last bar it saw. Whole-history
+    // statistics leak the future into every window and are only used with
+    // --norm-full-history.
+    OnlineNormalizer normalizer(INPUT_SIZE, norm_window);
+    std::vector<float> series(rows * INPUT_SIZE);
+    std::vector<double> bar_means, bar_std_devs;
+    if (!norm_full_history) {
+        bar_means.resize(rows * INPUT_SIZE);
+        bar_std_devs.resize(rows * INPUT_SIZE);
+        for (long i = 0; i < rows; i++) {
+            normalizer.push(table.row(i));
+            normalizer.normalize(table.row(i), &series[i * INPUT_SIZE]);
+            for (int j = 0; j < INPUT_SIZE; j++) {
+                bar_means[i * INPUT_SIZE + j] = normalizer.mean(j);
+                bar_std_devs[i * INPUT_SIZE + j] = normalizer.std_dev(j);
+            }
+        }
+    } else {
+        std::vector<double> normalized_data;
+        normalize_table(table, normalizer, normalized_data);
+        series.assign(normalized_data.begin(), normalized_data.end());
+    }
+    normalizer.save(stats_file_name);
+
+    // Prediction k saw bars up to k + seq_length - 1 and targets the next one
+    auto denormalize = [&](long k, int i, double value) {
+        const long seen = (k + seq_length - 1) * INPUT_SIZE + i;
+        return norm_full_history ? normalizer.denormalize(i, value) : value * bar_std_devs[seen] + bar_means[seen];
+    };
+
+    // Weights from --weights (used in place when packed for float), else the usual initialization
+    WeightFile weight_file;
+    PackedLstmWeights<float> weights;
+    if (!weights_file_name.empty()) {
+        if (!weight_file.open(weights_file_name) || !load_packed_lstm_weights(weight_file, INPUT_SIZE, weights)) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        LstmModelRuntime<float> model(INPUT_SIZE, hidden_size, seq_length);
+        model.initialize_weights_and_biases();
+        weights = pack_lstm_weights(model);
+    }
+    if (!activation_name.empty()) {
+        weights.activation = activation;
+    }
+
+    ThreadPool pool(threads);
+    std::vector<std::unique_ptr<BacktestWorker>> workers(pool.size());
+    std::vector<float> predictions(windows * INPUT_SIZE);
+
+    std::cout << "Debug: Backtesting " << windows << " windows on " << pool.size() << " threads with "
+              << lstm_simd_name(lstm_simd_level()) << " kernels, " << lstm_activation_name(weights.activation)
+              << " activations and "
+              << (norm_full_history ? std::string("whole-history")
+                  : norm_window > 0 ? "trailing " + std::to_string(norm_window) + "-bar"
+                  : std::string("expanding"))
+              << " normalization." << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    parallel_for(pool, 0, windows, CHUNK_WINDOWS, [&](int worker, long lo, long hi) {
+        if (!workers[worker]) {
+            workers[worker].reset(new BacktestWorker(weights, seq_length));
+        }
+        BacktestWorker &w = *workers[worker];
+
+        // Bars [lo, hi + seq_length - 1) cover every window of the chunk
+        w.cache.project(&series[lo * INPUT_SIZE], lo, hi - lo + seq_length - 1, INPUT_SIZE);
+        for (long first = lo; first < hi; first++) {
+            std::fill(w.h.begin(), w.h.end(), 0.0f);
+            std::fill(w.c.begin(), w.c.end(), 0.0f);
+            lstm_sequence_cached(weights, w.cache, w.ws, first, seq_length, w.h.data(), w.c.data(),
+                                 &predictions[first * INPUT_SIZE]);
+
+            double predicted[INPUT_SIZE];
+            for (int i = 0; i < INPUT_SIZE; ++i) {
+                predicted[i] = denormalize(first, i, predictions[first * INPUT_SIZE + i]);
+            }
+            w.metrics.add(predicted, table.row(first + seq_length), table.row(first + seq_length - 1));
+        }
+    });
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "Debug: " << windows << " windows in " << seconds << " s ("
+              << windows / seconds << " windows/s)." << std::endl;
+
+    PredictionMetrics metrics(INPUT_SIZE);
+    for (const auto &worker : workers) {
+        if (worker) {
+            metrics.merge(worker->metrics);
+        }
+    }
+    metrics.write_report(std::cout, "Backtest Predictions", table.feature_names);
+    std::ofstream metrics_file(metrics_file_name);
+    metrics.write_report(metrics_file, "Backtest Predictions", table.feature_names);
+    metrics_file.close();
+    std::cout << "Debug: Metrics written to '" << metrics_file_name << "'." << std::endl;
+
+    if (!write_outputs) {
+        return EXIT_SUCCESS;
+    }
+
+    // Predictions and the bars they target, in the outputs_*.txt layout
+    std::ofstream prediction_file(prediction_file_name), real_file(real_file_name);
+    real_file.precision(16);
+    for (long k = 0; k < windows; k++) {
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            prediction_file << denormalize(k, i, predictions[k * INPUT_SIZE + i]) << " ";
+            real_file << table.row(k + seq_length)[i] << (i + 1 < INPUT_SIZE ? "," : "");
+        }
+        prediction_file << "\n";
+        real_file << "\n";
+    }
+    prediction_file.close();
+    real_file.close();
+    std::cout << "Debug: Results written to '" << prediction_file_name << "' and '" << real_file_name << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+#include <string>
+#include "data_io.h"
+#include "lstm_batch.h"
+#include "lstm_weight_io.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Sequence length
+#define MAX_BATCH 64      // Sequences per GEMM
+
+// Scores several data.txt files in lockstep with the batched engine and writes
+// one denormalized prediction row per file and day, in the outputs_*.txt layout.
+int main(int argc, char **argv) {
+    int hidden_size = 16;
+    std::string output_file_name = "outputs_lstm_cpu.txt";
+    std::string weights_file_name, activation_name;
+    std::vector<std::string> data_files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hidden" && i + 1 < argc) {
+            hidden_size = std::atoi(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            output_file_name = argv[++i];
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else {
+            data_files.push_back(arg);
+        }
+    }
+
+    if (data_files.empty() || hidden_size < INPUT_SIZE) {
+        std::cerr << "Usage: " << argv[0] << " [--hidden N] [--out File] [--weights File] [--act Tier] <Data File> [Data File...]"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    const int batch = data_files.size();
+    std::vector<int> prediction_days(batch, 0);
+    std::vector<OnlineNormalizer> normalizers(batch);
+    std::vector<float> x_seq((size_t)batch * SEQ_LENGTH * INPUT_SIZE, 0.0f);
+    int max_days = 0;
+
+    for (int b = 0; b < batch; b++) {
+        DataTable table;
+        if (!load_table(data_files[b], table) || table.rows() == 0 || table.num_features != INPUT_SIZE) {
+            std::cerr << "Error: No " << INPUT_SIZE << "-feature data loaded from " << data_files[b] << std::endl;
+            return EXIT_FAILURE;
+        }
+        prediction_days[b] = table.prediction_days;
+        std::vector<double> normalized_data;
+        normalize_table(table, normalizers[b], normalized_data);
+
+        float *window = &x_seq[(size_t)b * SEQ_LENGTH * INPUT_SIZE];
+        for (int i = 0; i < SEQ_LENGTH * INPUT_SIZE && i < (int)normalized_data.size(); ++i) {
+            window[i] = normalized_data[i];
+        }
+        if (prediction_days[b] > max_days) {
+            max_days = prediction_days[b];
+        }
+    }
+
+    // Weights from --weights (used in place when packed for float), else the usual initialization
+    WeightFile weight_file;
+    PackedLstmWeights<float> weights;
+    if (!weights_file_name.empty()) {
+        if (!weight_file.open(weights_file_name) || !load_packed_lstm_weights(weight_file, INPUT_SIZE, weights)) {
+            return EXIT_FAILURE;
+        }
+        hidden_size = weights.hidden_size;
+    } else {
+        LstmModelRuntime<float> model(INPUT_SIZE, hidden_size, SEQ_LENGTH);
+        model.initialize_weights_and_biases();
+        weights = pack_lstm_weights(model);
+    }
+    if (!activation_name.empty()) {
+        weights.activation = activation;
+    }
+    LstmBatchWorkspace<float> ws(weights, batch < MAX_BATCH ? batch : MAX_BATCH);
+
+    std::vector<float> h((size_t)batch * hidden_size, 0.0f), c((size_t)batch * hidden_size, 0.0f);
+    std::vector<float> output_data((size_t)batch * INPUT_SIZE);
+    std::vector<std::vector<float>> predictions(batch);
+
+    std::cout << "Debug: Scoring " << batch << " sequences for up to " << max_days << " days with "
+              << lstm_simd_name(lstm_simd_level()) << " kernels and " << lstm_activation_name(weights.activation)
+              << " activations." << std::endl;
+
+    for (int day = 0; day < max_days; ++day) {
+        lstm_sequence_batch(weights, ws, x_seq.data(), SEQ_LENGTH, h.data(), c.data(), output_data.data(), batch);
+
+        for (int b = 0; b < batch; b++) {
+            const float *out = &output_data[(size_t)b * INPUT_SIZE];
+            if (day < prediction_days[b]) {
+                predictions[b].insert(predictions[b].end(), out, out + INPUT_SIZE);
+            }
+
+            // Shift input sequence for the next prediction
+            float *window = &x_seq[(size_t)b * SEQ_LENGTH * INPUT_SIZE];
+            for (int i = 0; i < (SEQ_LENGTH - 1) * INPUT_SIZE; ++i) {
+                window[i] = window[i + INPUT_SIZE];
+            }
+            for (int j = 0; j < INPUT_SIZE; ++j) {
+                window[(SEQ_LENGTH - 1) * INPUT_SIZE + j] = out[j];
+            }
+        }
+    }
+
+    std::ofstream output_file(output_file_name);
+    for (int b = 0; b < batch; b++) {
+        for (size_t row = 0; row < predictions[b].size(); row += INPUT_SIZE) {
+            for (int i = 0; i < INPUT_SIZE; ++i) {
+                output_file << normalizers[b].denormalize(i, predictions[b][row + i]) << " ";
+            }
+            output_file << "\n";
+        }
+    }
+    output_file.close();
+    std::cout << "Debug: Results written to '" << output_file_name << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,382 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "data_io.h"
+#include "lstm_batch.h"
+#include "lstm_packed.h"
+#include "lstm_quant.h"
+#include "rnn_model.h"
+#include "series_store.h"
+
+#define INPUT_SIZE 5      // Input feature size
+
+// Microbenchmarks of the CPU kernels, ingest and normalization. Every case is
+// run until --min-time has passed, three times, and the best trial counts.
+// Results go to a JSON file; with --baseline every case present in both files
+// is compared and the run fails when a case lost more than --threshold of its
+// baseline throughput.
+
+struct BenchResult {
+    std::string name;
+    double bars_per_sec;   // input bars (time steps x sequences, or rows) per second
+    double step_ns;        // wall time per time step (per row for ingest/normalize)
+    long iterations;
+};
+
+struct BenchOptions {
+    double min_time;
+    std::string filter;
+    bool quick;
+};
+
+// Best of three trials of fn, which processes bars_per_call bars in steps_per_call steps
+static BenchResult run_case(const BenchOptions &options, const std::string &name, double bars_per_call,
+                            double steps_per_call, const std::function<void()> &fn) {
+    fn();   // warm caches and lazy dispatch
+    double best = 0.0;
+    long iterations = 0;
+    for (int trial = 0; trial < 3; trial++) {
+        long calls = 0;
+        auto start = std::chrono::steady_clock::now();
+        double elapsed = 0.0;
+        do {
+            fn();
+            calls++;
+            elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        } while (elapsed < options.min_time);
+        const double per_call = elapsed / calls;
+        if (best == 0.0 || per_call < best) {
+            best = per_call;
+        }
+        iterations += calls;
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.bars_per_sec = bars_per_call / best;
+    result.step_ns = best / steps_per_call * 1e9;
+    result.iterations = iterations;
+    std::cout << std::left << std::setw(36) << name << std::right << std::setw(14) << std::setprecision(4)
+              << result.bars_per_sec << " bars/s " << std::setw(12) << result.step_ns << " ns/step" << std::endl;
+    return result;
+}
+
+static bool selected(const BenchOptions &options, const std::string &name) {
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+template <typename T>
+static const char *type_name() {
+    return sizeof(T) == sizeof(float) ? "f32" : "f64";
+}
+
+// Deterministic pseudo-random fill in [-1, 1)
+template <typename T>
+static void fill_random(T *data, size_t n, unsigned seed) {
+    for (size_t i = 0; i < n; i++) {
+        seed = seed * 1664525u + 1013904223u;
+        data[i] = T((seed >> 8) * (2.0 / 16777216.0) - 1.0);
+    }
+}
+
+template <typename T>
+static PackedLstmWeights<T> random_lstm(int hidden) {
+    LstmModelRuntime<T> model(INPUT_SIZE, hidden, 1);
+    std::srand(1);
+    model.initialize_weights_and_biases();
+    return pack_lstm_weights(model);
+}
+
+template <typename T>
+static void bench_lstm(const BenchOptions &options, const std::vector<int> &hidden_sizes,
+                       const std::vector<int> &seq_lengths, std::vector<BenchResult> &results) {
+    for (int hidden : hidden_sizes) {
+        const std::string cell_name = std::string("lstm_cell/") + type_name<T>() + "/h" + std::to_string(hidden);
+        const std::string seq_prefix = std::string("lstm_sequence/") + type_name<T>() + "/h" + std::to_string(hidden);
+        if (!selected(options, cell_name) && !selected(options, seq_prefix)) {
+            continue;
+        }
+        PackedLstmWeights<T> weights = random_lstm<T>(hidden);
+        LstmWorkspace<T> ws(weights);
+        std::vector<T> h(hidden, T(0)), c(hidden, T(0)), x(INPUT_SIZE), out(INPUT_SIZE);
+        fill_random(x.data(), x.size(), 7);
+
+        if (selected(options, cell_name)) {
+            results.push_back(run_case(options, cell_name, 1, 1, [&] {
+                lstm_cell_packed(weights, ws, x.data(), h.data(), c.data(), h.data(), c.data());
+            }));
+        }
+        for (int seq : seq_lengths) {
+            const std::string name = seq_prefix + "/s" + std::to_string(seq);
+            if (!selected(options, name)) {
+                continue;
+            }
+            std::vector<T> x_seq((size_t)seq * INPUT_SIZE);
+            fill_random(x_seq.data(), x_seq.size(), 11);
+            results.push_back(run_case(options, name, seq, seq, [&] {
+                std::fill(h.begin(), h.end(), T(0));
+                std::fill(c.begin(), c.end(), T(0));
+                lstm_sequence_packed(weights, ws, x_seq.data(), seq, h.data(), c.data(), out.data());
+            }));
+        }
+    }
+}
+
+template <typename T>
+static void bench_batch(const BenchOptions &options, const std::vector<int> &hidden_sizes,
+                        const std::vector<int> &batches, int seq, std::vector<BenchResult> &results) {
+    for (int hidden : hidden_sizes) {
+        for (int batch : batches) {
+            const std::string name = std::string("lstm_batch/") + type_name<T>() + "/h" + std::to_string(hidden) +
+                                     "/s" + std::to_string(seq) + "/b" + std::to_string(batch);
+            if (!selected(options, name)) {
+                continue;
+            }
+            PackedLstmWeights<T> weights = random_lstm<T>(hidden);
+            LstmBatchWorkspace<T> ws(weights, batch);
+            std::vector<T> x_seq((size_t)batch * seq * INPUT_SIZE), out((size_t)batch * INPUT_SIZE);
+            std::vector<T> h((size_t)batch * hidden), c((size_t)batch * hidden);
+            fill_random(x_seq.data(), x_seq.size(), 13);
+            results.push_back(run_case(options, name, (double)seq * batch, seq, [&] {
+                std::fill(h.begin(), h.end(), T(0));
+                std::fill(c.begin(), c.end(), T(0));
+                lstm_sequence_batch(weights, ws, x_seq.data(), seq, h.data(), c.data(), out.data(), batch);
+            }));
+        }
+    }
+}
+
+template <typename Q>
+static void bench_quant(const BenchOptions &options, const char *type, const std::vector<int> &hidden_sizes,
+                        int seq, std::vector<BenchResult> &results) {
+    QuantCalibration calibration;
+    calibration.x_max = 1.0;
+    calibration.h_max = 1.0;
+    for (int hidden : hidden_sizes) {
+        const std::string name = std::string("lstm_sequence/") + type + "/h" + std::to_string(hidden) + "/s" +
+                                 std::to_string(seq);
+        if (!selected(options, name)) {
+            continue;
+        }
+        PackedLstmWeights<float> weights = random_lstm<float>(hidden);
+        QuantizedCell<Q> cell = quantize_lstm<Q>(weights, calibration);
+        QuantWorkspace<Q> ws(cell);
+        std::vector<float> x_seq((size_t)seq * INPUT_SIZE), h(hidden), c(hidden), out(INPUT_SIZE);
+        fill_random(x_seq.data(), x_seq.size(), 17);
+        results.push_back(run_case(options, name, seq, seq, [&] {
+            std::fill(h.begin(), h.end(), 0.0f);
+            std::fill(c.begin(), c.end(), 0.0f);
+            lstm_sequence_quant(cell, ws, x_seq.data(), seq, h.data(), c.data(), out.data());
+        }));
+    }
+}
+
+template <typename T>
+static void bench_rnn(const BenchOptions &options, const std::vector<int> &hidden_sizes,
+                      const std::vector<int> &seq_lengths, std::vector<BenchResult> &results) {
+    for (int hidden : hidden_sizes) {
+        RnnModel<T> model(INPUT_SIZE, hidden);
+        fill_random(model.W.data(), model.W.size(), 19);
+        fill_random(model.U.data(), model.U.size(), 23);
+        for (T &u : model.U) {
+            u /= T(hidden);
+        }
+        for (int seq : seq_lengths) {
+            const std::string name = std::string("rnn_sequence/") + type_name<T>() + "/h" + std::to_string(hidden) +
+                                     "/s" + std::to_string(seq);
+            if (!selected(options, name)) {
+                continue;
+            }
+            std::vector<T> x_seq((size_t)seq * INPUT_SIZE), h(hidden);
+            fill_random(x_seq.data(), x_seq.size(), 29);
+            results.push_back(run_case(options, name, seq, seq, [&] {
+                model.rnn_sequence(x_seq.data(), seq, h.data());
+            }));
+        }
+    }
+}
+
+// load_table on a generated CSV export, then normalize_table on the result,
+// and the same through the column store (load_series, normalize_series)
+static void bench_ingest(const BenchOptions &options, long rows, std::vector<BenchResult> &results) {
+    const std::string ingest_name = "load_table/csv/" + std::to_string(rows);
+    const std::string normalize_name = "normalize_table/" + std::to_string(rows);
+    const std::string series_name = "load_series/csv/" + std::to_string(rows);
+    const std::string normalize_series_name = "normalize_series/" + std::to_string(rows);
+    if (!selected(options, ingest_name) && !selected(options, normalize_name) && !selected(options, series_name) &&
+        !selected(options, normalize_series_name)) {
+        return;
+    }
+
+    const std::string file_name = "bench_ingest.tmp.csv";
+    {
+        std::ofstream file(file_name);
+        file << "Price,Open,Close,High,Low,Volume\n";
+        std::vector<double> bar(INPUT_SIZE);
+        for (long i = 0; i < rows; i++) {
+            fill_random(bar.data(), bar.size(), (unsigned)i);
+            file << "2020-01-01," << 300 + bar[0] << "," << 300 + bar[1] << "," << 301 + bar[2] << ","
+                 << 299 + bar[3] << "," << (long)(1e8 + 1e7 * bar[4]) << "\n";
+        }
+    }
+
+    DataTable table;
+    if (selected(options, ingest_name)) {
+        results.push_back(run_case(options, ingest_name, rows, rows, [&] {
+            table = DataTable();
+            load_table(file_name, table);
+        }));
+    } else {
+        load_table(file_name, table);
+    }
+    if (selected(options, normalize_name)) {
+        std::vector<double> normalized;
+        results.push_back(run_case(options, normalize_name, rows, rows, [&] {
+            OnlineNormalizer normalizer(INPUT_SIZE);
+            normalize_table(table, normalizer, normalized);
+        }));
+    }
+
+    SeriesStore<double> series;
+    if (selected(options, series_name)) {
+        results.push_back(run_case(options, series_name, rows, rows, [&] { load_series(file_name, series); }));
+    } else {
+        load_series(file_name, series);
+    }
+    if (selected(options, normalize_series_name)) {
+        // In place, so every repetition z-scores an already normalized store;
+        // the arithmetic per value is the same
+        results.push_back(run_case(options, normalize_series_name, rows, rows, [&] {
+            OnlineNormalizer normalizer(INPUT_SIZE);
+            normalize_series(series, normalizer);
+        }));
+    }
+    std::remove(file_name.c_str());
+}
+
+static bool write_results(const std::string &file_name, const std::vector<BenchResult> &results) {
+    std::ofstream file(file_name);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << file_name << " for writing." << std::endl;
+        return false;
+    }
+    file << "{\n  \"version\": 1,\n  \"simd\": \"" << lstm_simd_name(lstm_simd_level()) << "\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const BenchResult &r = results[i];
+        file << "    {\"name\": \"" << r.name << "\", \"bars_per_sec\": " << std::setprecision(9) << r.bars_per_sec
+             << ", \"step_ns\": " << r.step_ns << ", \"iterations\": " << r.iterations << "}"
+             << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return file.good();
+}
+
+// name -> bars_per_sec from a file write_results produced
+static bool read_baseline(const std::string &file_name, std::map<std::string, double> &baseline) {
+    std::ifstream file(file_name);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open baseline " << file_name << std::endl;
+        return false;
+    }
+    std::string line;
+    const std::string name_key = "\"name\": \"", rate_key = "\"bars_per_sec\": ";
+    while (std::getline(file, line)) {
+        const size_t name_pos = line.find(name_key), rate_pos = line.find(rate_key);
+        if (name_pos == std::string::npos || rate_pos == std::string::npos) {
+            continue;
+        }
+        const size_t begin = name_pos + name_key.size();
+        baseline[line.substr(begin, line.find('"', begin) - begin)] =
+            std::atof(line.c_str() + rate_pos + rate_key.size());
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    options.min_time = 0.05;
+    options.quick = false;
+    double threshold = 0.15;
+    std::string output_file_name = "bench.json";
+    std::string baseline_file_name;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--quick") {
+            options.quick = true;
+        } else if (arg == "--filter" && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (arg == "--min-time" && i + 1 < argc) {
+            options.min_time = std::atof(argv[++i]);
+        } else if (arg == "--out" && i + 1 < argc) {
+            output_file_name = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline_file_name = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--quick] [--filter Text] [--min-time Seconds] [--out File]"
+                      << " [--baseline File] [--threshold Fraction]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const std::vector<int> hidden_sizes = options.quick ? std::vector<int>{16, 64, 512}
+                                                        : std::vector<int>{16, 32, 64, 128, 256, 512};
+    const std::vector<int> seq_lengths = options.quick ? std::vector<int>{60, 2000}
+                                                       : std::vector<int>{60, 250, 1000, 2000};
+    const std::vector<int> batches = options.quick ? std::vector<int>{1, 32} : std::vector<int>{1, 8, 32, 128};
+    const std::vector<int> small_hidden = {16, 64};
+
+    std::cout << "Debug: Benchmarking with " << lstm_simd_name(lstm_simd_level()) << " kernels, " << options.min_time
+              << " s per trial." << std::endl;
+    std::vector<BenchResult> results;
+    bench_lstm<float>(options, hidden_sizes, seq_lengths, results);
+    bench_lstm<double>(options, hidden_sizes, seq_lengths, results);
+    bench_batch<float>(options, small_hidden, batches, 60, results);
+    bench_batch<double>(options, small_hidden, batches, 60, results);
+    bench_quant<int8_t>(options, "i8", small_hidden, 60, results);
+    bench_quant<int16_t>(options, "i16", small_hidden, 60, results);
+    bench_rnn<float>(options, small_hidden, seq_lengths, results);
+    bench_rnn<double>(options, small_hidden, seq_lengths, results);
+    bench_ingest(options, options.quick ? 20000 : 200000, results);
+
+    if (!write_results(output_file_name, results)) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Debug: " << results.size() << " results written to '" << output_file_name << "'." << std::endl;
+
+    if (baseline_file_name.empty()) {
+        return EXIT_SUCCESS;
+    }
+    std::map<std::string, double> baseline;
+    if (!read_baseline(baseline_file_name, baseline)) {
+        return EXIT_FAILURE;
+    }
+    int compared = 0, regressed = 0;
+    for (const BenchResult &r : results) {
+        auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            continue;
+        }
+        compared++;
+        const double ratio = r.bars_per_sec / it->second;
+        if (ratio < 1.0 - threshold) {
+            regressed++;
+            std::cerr << "Error: " << r.name << " regressed to " << std::setprecision(3) << ratio * 100.0
+                      << "% of baseline (" << r.bars_per_sec << " vs " << it->second << " bars/s)" << std::endl;
+        }
+    }
+    std::cout << "Debug: " << compared << " cases compared against '" << baseline_file_name << "', " << regressed
+              << " regressed by more than " << threshold * 100.0 << "%." << std::endl;
+    return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
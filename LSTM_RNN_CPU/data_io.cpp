@@ -0,0 +1,138 @@
+#include "data_io.h"
+#include "ohlcv_file.h"
+#include "series_store.h"
+
+// Header-less files get DEFAULT_FEATURE_NAMES, then Feature<i>
+static void set_default_feature_names(size_t num_features, std::vector<std::string> &names) {
+    if (names.size() == num_features) {
+        return;
+    }
+    static const char *defaults[] = DEFAULT_FEATURE_NAMES;
+    const size_t num_defaults = sizeof(defaults) / sizeof(defaults[0]);
+    names.clear();
+    for (size_t i = 0; i < num_features; i++) {
+        names.push_back(i < num_defaults ? defaults[i] : "Feature" + std::to_string(i));
+    }
+}
+
+// Function to normalize data
+void normalize_table(const DataTable &table, OnlineNormalizer &normalizer, std::vector<double> &normalized) {
+    if (normalizer.num_features() != (int)table.num_features) {
+        normalizer.reset(table.num_features, normalizer.window());
+    }
+    normalizer.push_rows(table.values.data(), table.rows());
+    normalized.resize(table.values.size());
+    normalizer.normalize_rows(table.values.data(), normalized.data(), table.rows());
+}
+
+bool parse_timestamp(const std::string &text, int64_t &seconds) {
+    return ingest_parse_timestamp(text.c_str(), text.c_str() + text.size(), seconds);
+}
+
+// Function to load a data file into a table
+bool load_table(const std::string &file_name, DataTable &table) {
+    if (is_ohlcv_file(file_name)) {
+        return load_ohlcv_table(file_name, table);
+    }
+    if (!ingest_text(file_name, table, 0)) {
+        return false;
+    }
+
+    set_default_feature_names(table.num_features, table.feature_names);
+    return true;
+}
+
+// ingest_rows sink that parses straight into the columns of a store
+struct SeriesSink {
+    SeriesStore<double> &store;
+    std::vector<double *> columns;
+    int64_t *timestamps;
+
+    explicit SeriesSink(SeriesStore<double> &store) : store(store), timestamps(nullptr) {}
+
+    void reserve(const IngestLayout &layout, size_t rows) {
+        store.reset((int)layout.num_features, layout.dated);
+        store.resize(rows);
+        columns.resize(layout.num_features);
+        for (size_t f = 0; f < layout.num_features; f++) {
+            columns[f] = store.column_data((int)f);
+        }
+        timestamps = store.timestamps_data();
+    }
+    void set(size_t row, size_t feature, double value) { columns[feature][row] = value; }
+    void set_timestamp(size_t row, int64_t seconds) { timestamps[row] = seconds; }
+    void move_rows(size_t from, size_t to, size_t count) {
+        for (double *column : columns) {
+            std::memmove(column + to, column + from, count * sizeof(double));
+        }
+        if (timestamps) {
+            std::memmove(timestamps + to, timestamps + from, count * sizeof(int64_t));
+        }
+    }
+};
+
+bool load_series(const std::string &file_name, SeriesStore<double> &store) {
+    if (is_ohlcv_file(file_name)) {
+        OhlcvFile file;
+        if (!file.open(file_name)) {
+            return false;
+        }
+        const size_t rows = file.rows();
+        const ColumnSpan<int64_t> ts = file.timestamps();
+        store.reset(file.num_features(), !ts.empty());
+        store.resize(rows);
+        store.prediction_days = file.header().prediction_days;
+        store.ticker = file.ticker();
+        for (int f = 0; f < file.num_features(); f++) {
+            store.feature_names.push_back(file.feature_name(f));
+            double *column = store.column_data(f);
+            if (file.dtype() == OHLCV_F64) {
+                std::memcpy(column, file.column_f64(f).data, rows * sizeof(double));
+            } else {
+                const ColumnSpan<float> values = file.column_f32(f);
+                std::copy(values.begin(), values.end(), column);
+            }
+        }
+        if (!ts.empty()) {
+            std::memcpy(store.timestamps_data(), ts.data, rows * sizeof(int64_t));
+        }
+        return true;
+    }
+
+    store.reset(0);
+    IngestLayout layout;
+    SeriesSink sink(store);
+    if (!ingest_text(file_name, layout, sink, 0)) {
+        return false;
+    }
+    store.resize(layout.rows);
+    if (store.has_timestamps() && !layout.stamped) {
+        store.clear_timestamps();
+    }
+    store.prediction_days = layout.prediction_days;
+    store.ticker = layout.ticker;
+    store.feature_names = layout.feature_names;
+    set_default_feature_names(layout.num_features, store.feature_names);
+    return true;
+}
+
+void normalize_series(SeriesStore<double> &store, OnlineNormalizer &normalizer) {
+    const int features = store.num_features();
+    if (normalizer.num_features() != features) {
+        normalizer.reset(features, normalizer.window());
+    }
+    std::vector<const double *> columns(features);
+    for (int f = 0; f < features; f++) {
+        columns[f] = store.column_data(f);
+    }
+    normalizer.push_columns(columns.data(), store.rows());
+
+    for (int f = 0; f < features; f++) {
+        // The expression OnlineNormalizer::normalize uses, one column at a time
+        const double mean = normalizer.mean(f), sd = normalizer.std_dev(f);
+        double *column = store.column_data(f);
+        for (size_t r = 0; r < store.rows(); r++) {
+            column[r] = sd > 0.0 ? (column[r] - mean) / sd : 0.0;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef DATA_IO_H
+#define DATA_IO_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "text_ingest.h"
+#include "online_normalizer.h"
+
+// Default feature order of every data.txt in the repo
+#define DEFAULT_FEATURE_NAMES {"Open", "Close", "High", "Low", "Volume"}
+
+// A parsed data file with the metadata the text dialects carry, values are
+// row-major in one contiguous vector
+typedef IngestTable<double> DataTable;
+
+// Load any data file into a table: every text dialect text_ingest.h detects
+// and the binary columnar format from ohlcv_file.h. Feature names fall back to
+// DEFAULT_FEATURE_NAMES when the file has no header row.
+bool load_table(const std::string &file_name, DataTable &table);
+
+// Fold every row of the table into the normalizer, then z-score the rows into
+// normalized ([rows][num_features], contiguous). The normalizer keeps the
+// statistics for denormalizing and for later bars.
+void normalize_table(const DataTable &table, OnlineNormalizer &normalizer, std::vector<double> &normalized);
+
+// "YYYY-MM-DD[ HH:MM:SS][+HH:MM]" to UTC epoch seconds
+bool parse_timestamp(const std::string &text, int64_t &seconds);
+
+#endif // DATA_IO_H
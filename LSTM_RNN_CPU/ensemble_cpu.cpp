@@ -0,0 +1,162 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "data_io.h"
+#include "lstm_ensemble.h"
+#include "lstm_weight_io.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Sequence length
+
+// Multi-day forecast with uncertainty: --paths perturbed rollouts of the
+// testbench forecast (lstm_ensemble.h) advance one day at a time across the
+// pool. Each day's samples become a mean and quantiles per feature, written as
+// soon as the day is done. --noise is the std dev of the per-day innovation in
+// normalized units; the model's validation RMSE from train_cpu is a good value.
+
+static bool parse_quantiles(const std::string &text, std::vector<double> &qs) {
+    std::stringstream ss(text);
+    std::string item;
+    qs.clear();
+    while (std::getline(ss, item, ',')) {
+        const double q = std::atof(item.c_str());
+        if (q < 0.0 || q > 1.0) {
+            return false;
+        }
+        qs.push_back(q);
+    }
+    return !qs.empty();
+}
+
+int main(int argc, char **argv) {
+    int hidden_size = 16;
+    int days = 0;
+    int threads = 0;
+    LstmEnsembleConfig config;
+    config.seq_length = SEQ_LENGTH;
+    std::string quantile_list = "0.05,0.5,0.95";
+    std::string output_file_name = "ensemble.dat";
+    std::string weights_file_name, activation_name, file_name;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--paths" && i + 1 < argc) {
+            config.paths = std::atoi(argv[++i]);
+        } else if (arg == "--days" && i + 1 < argc) {
+            days = std::atoi(argv[++i]);
+        } else if (arg == "--noise" && i + 1 < argc) {
+            config.noise = std::atof(argv[++i]);
+        } else if (arg == "--state-noise" && i + 1 < argc) {
+            config.state_noise = std::atof(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--quantiles" && i + 1 < argc) {
+            quantile_list = argv[++i];
+        } else if (arg == "--hidden" && i + 1 < argc) {
+            hidden_size = std::atoi(argv[++i]);
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            output_file_name = argv[++i];
+        } else {
+            file_name = arg;
+        }
+    }
+
+    std::vector<double> qs;
+    if (file_name.empty() || hidden_size < INPUT_SIZE || config.paths < 1 || days < 0 || config.noise < 0.0 ||
+        config.state_noise < 0.0 || !parse_quantiles(quantile_list, qs)) {
+        std::cerr << "Usage: " << argv[0] << " [--paths N] [--days N] [--noise S] [--state-noise S] [--seed N]"
+                  << " [--threads N] [--quantiles q,q,...] [--hidden N] [--weights File] [--act Tier] [--out File]"
+                  << " <Data File>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    DataTable table;
+    if (!load_table(file_name, table) || table.rows() == 0 || table.num_features != INPUT_SIZE) {
+        std::cerr << "Error: No " << INPUT_SIZE << "-feature data loaded from " << file_name << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (days == 0) {
+        days = table.prediction_days;
+    }
+
+    OnlineNormalizer normalizer(INPUT_SIZE);
+    std::vector<double> normalized_data;
+    normalize_table(table, normalizer, normalized_data);
+    std::vector<float> window(SEQ_LENGTH * INPUT_SIZE, 0.0f);
+    for (int i = 0; i < SEQ_LENGTH * INPUT_SIZE && i < (int)normalized_data.size(); ++i) {
+        window[i] = normalized_data[i];
+    }
+
+    // Weights from --weights (activation recorded in the file), else the usual initialization
+    WeightFile weight_file;
+    PackedLstmWeights<float> weights;
+    if (!weights_file_name.empty()) {
+        if (!weight_file.open(weights_file_name) || !load_packed_lstm_weights(weight_file, INPUT_SIZE, weights)) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        LstmModelRuntime<float> model(INPUT_SIZE, hidden_size, SEQ_LENGTH);
+        model.initialize_weights_and_biases();
+        weights = pack_lstm_weights(model);
+    }
+    if (!activation_name.empty()) {
+        weights.activation = activation;
+    }
+
+    ThreadPool pool(threads);
+    LstmEnsemble<float> ensemble(weights, config, pool);
+    ensemble.reset(window.data());
+    std::cout << "Debug: " << config.paths << " paths for " << days << " days on " << pool.size() << " threads, noise "
+              << config.noise << ", state noise " << config.state_noise << "." << std::endl;
+
+    std::ofstream output_file(output_file_name);
+    output_file << "# day feature mean";
+    for (double q : qs) {
+        output_file << " q" << q;
+    }
+    output_file << "\n";
+
+    std::vector<float> scratch;
+    std::vector<double> quantiles;
+    double mean = 0.0;
+    double step_ms = 0.0;
+    for (int day = 0; day < days; ++day) {
+        const auto start = std::chrono::steady_clock::now();
+        const float *samples = ensemble.step();
+        step_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // z-scoring is monotonic and affine, so quantiles and mean denormalize directly
+        for (int f = 0; f < INPUT_SIZE; ++f) {
+            lstm_ensemble_summary(samples, config.paths, INPUT_SIZE, f, qs, scratch, mean, quantiles);
+            output_file << day + 1 << " " << table.feature_names[f] << " " << normalizer.denormalize(f, mean);
+            for (double q : quantiles) {
+                output_file << " " << normalizer.denormalize(f, q);
+            }
+            output_file << "\n";
+        }
+        output_file.flush();
+    }
+    output_file.close();
+
+    std::cout << "Debug: " << (long)config.paths * days << " path-days in " << step_ms << " ms ("
+              << (step_ms > 0.0 ? config.paths * days / step_ms * 1e3 : 0.0) << " path-days/s)." << std::endl;
+    std::cout << "Debug: Results written to '" << output_file_name << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
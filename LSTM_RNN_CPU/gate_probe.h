@@ -0,0 +1,216 @@
+#ifndef GATE_PROBE_H
+#define GATE_PROBE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Binary capture of every LSTM timestep: the i, f, g and o gate activations
+// and the c and h states, as float32. The probe is compiled into lstm_rnn.cpp
+// and the packed CPU engine (lstm_sequence_packed) only with -DLSTM_PROBE,
+// never for synthesis, and records only when LSTM_PROBE names an output file
+// at run time. Each recording thread keeps its last LSTM_PROBE_RECORDS
+// timesteps (default 65536) in its own ring, so the hot path takes no lock. A
+// GateProbeSession in main merges the rings at exit, keeps the newest
+// LSTM_PROBE_RECORDS by sequence and step, and writes them; probe_decode turns
+// the file into CSV, NumPy or the old debug_output.dat text.
+//
+// File layout (native byte order): GateProbeHeader, then records, each a
+// GateProbeRecord followed by [GATE_PROBE_FIELDS][hidden] floats.
+
+#define GATE_PROBE_MAGIC "GATEPRB1"
+#define GATE_PROBE_VERSION 1
+#define GATE_PROBE_FIELDS 6            // i, f, g, o, c, h
+#define GATE_PROBE_FIELD_NAMES {"i", "f", "g", "o", "c", "h"}
+#define GATE_PROBE_DEFAULT_RECORDS 65536
+
+struct GateProbeHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t hidden_size;
+    uint32_t fields;
+    uint32_t record_bytes;   // GateProbeRecord plus the values
+    uint64_t records;        // records in the file
+    uint64_t dropped;        // older records the ring overwrote
+};
+
+struct GateProbeRecord {
+    uint32_t sequence;   // lstm_sequence call, counted from 0
+    uint32_t step;       // timestep within the call
+};
+
+static_assert(sizeof(GateProbeHeader) == 40 && sizeof(GateProbeRecord) == 8, "probe file layout");
+
+// One thread's records: the last capacity timesteps it recorded, each a
+// GateProbeRecord followed by [GATE_PROBE_FIELDS][hidden] floats
+struct GateProbeBuffer {
+    uint32_t sequence;         // number of the sequence the thread is running
+    uint64_t count;            // timesteps ever recorded, the ring holds the last capacity
+    std::vector<float> ring;   // grows up to capacity records, then wraps
+
+    GateProbeBuffer() : sequence(0), count(0) {}
+};
+
+class GateProbe {
+public:
+    static GateProbe &instance() {
+        static GateProbe probe;
+        return probe;
+    }
+
+    bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // Once, before any timestep is recorded
+    void start(size_t capacity) {
+        capacity_ = capacity > 0 ? capacity : 1;
+        enabled_.store(true);
+    }
+
+    void stop() { enabled_.store(false); }
+
+    // One timestep, values is [GATE_PROBE_FIELDS][hidden_size]. Step 0 starts
+    // a new sequence on the calling thread. Each thread writes its own buffer,
+    // so compute-unit threads never wait on each other.
+    void record(int step, const float *values, int hidden_size) {
+        int expected = 0;
+        if (!hidden_size_.compare_exchange_strong(expected, hidden_size) && expected != hidden_size) {
+            return;
+        }
+        GateProbeBuffer &buffer = thread_buffer();
+        if (step == 0) {
+            buffer.sequence = next_sequence_.fetch_add(1);
+        }
+        const size_t floats = record_floats(hidden_size);
+        const size_t slot = (size_t)(buffer.count % capacity_) * floats;
+        if (slot == buffer.ring.size()) {
+            buffer.ring.resize(slot + floats);
+        }
+        GateProbeRecord record = {buffer.sequence, uint32_t(step)};
+        std::memcpy(&buffer.ring[slot], &record, sizeof(record));
+        std::memcpy(&buffer.ring[slot + sizeof(record) / sizeof(float)], values,
+                    GATE_PROBE_FIELDS * hidden_size * sizeof(float));
+        buffer.count++;
+    }
+
+    // The newest capacity timesteps of all threads, ordered by sequence and
+    // step. Call after stop(), once the recording threads are done.
+    bool write(const std::string &file_name, uint64_t &records, uint64_t &dropped) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::ofstream file(file_name, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open probe file " << file_name << std::endl;
+            return false;
+        }
+        const int hidden_size = hidden_size_.load();
+        const size_t floats = record_floats(hidden_size);
+
+        // Merge the rings by (sequence, step) and keep the newest capacity
+        struct Entry {
+            uint64_t key;
+            const float *record;
+            bool operator<(const Entry &other) const { return key < other.key; }
+        };
+        std::vector<Entry> entries;
+        uint64_t total = 0;
+        for (const auto &buffer : buffers_) {
+            const uint64_t kept = std::min<uint64_t>(buffer->count, capacity_);
+            total += buffer->count;
+            for (uint64_t i = buffer->count - kept; i < buffer->count; i++) {
+                const float *record = &buffer->ring[(size_t)(i % capacity_) * floats];
+                GateProbeRecord header;
+                std::memcpy(&header, record, sizeof(header));
+                entries.push_back(Entry{(uint64_t(header.sequence) << 32) | header.step, record});
+            }
+        }
+        std::sort(entries.begin(), entries.end());
+        const size_t first = entries.size() > capacity_ ? entries.size() - capacity_ : 0;
+        records = entries.size() - first;
+        dropped = total - records;
+
+        GateProbeHeader header;
+        std::memcpy(header.magic, GATE_PROBE_MAGIC, 8);
+        header.version = GATE_PROBE_VERSION;
+        header.hidden_size = hidden_size;
+        header.fields = GATE_PROBE_FIELDS;
+        header.record_bytes = uint32_t(floats * sizeof(float));
+        header.records = records;
+        header.dropped = dropped;
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        for (size_t i = first; i < entries.size(); i++) {
+            file.write(reinterpret_cast<const char *>(entries[i].record), header.record_bytes);
+        }
+        return file.good();
+    }
+
+private:
+    GateProbe() : enabled_(false), capacity_(1), hidden_size_(0), next_sequence_(0) {}
+
+    static size_t record_floats(int hidden_size) {
+        return sizeof(GateProbeRecord) / sizeof(float) + GATE_PROBE_FIELDS * hidden_size;
+    }
+
+    // The calling thread's buffer, registered on first use and kept after the
+    // thread exits so write() still sees it
+    GateProbeBuffer &thread_buffer() {
+        thread_local std::shared_ptr<GateProbeBuffer> buffer;
+        if (!buffer) {
+            buffer = std::make_shared<GateProbeBuffer>();
+            std::lock_guard<std::mutex> lock(mutex_);
+            buffers_.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    std::atomic<bool> enabled_;
+    std::mutex mutex_;   // guards buffers_, taken once per thread and by write()
+    size_t capacity_;
+    std::atomic<int> hidden_size_;
+    std::atomic<uint32_t> next_sequence_;
+    std::vector<std::shared_ptr<GateProbeBuffer>> buffers_;
+};
+
+inline bool gate_probe_enabled() {
+    return GateProbe::instance().enabled();
+}
+
+// Starts the probe when LSTM_PROBE is set and writes the file on destruction.
+// One per process, at the top of main.
+class GateProbeSession {
+public:
+    GateProbeSession() {
+        const char *file_name = std::getenv("LSTM_PROBE");
+        if (file_name && *file_name) {
+            file_name_ = file_name;
+            const char *records = std::getenv("LSTM_PROBE_RECORDS");
+            GateProbe::instance().start(records ? std::strtoull(records, nullptr, 10) : GATE_PROBE_DEFAULT_RECORDS);
+        }
+    }
+
+    ~GateProbeSession() {
+        if (file_name_.empty()) {
+            return;
+        }
+        GateProbe::instance().stop();
+        uint64_t records = 0, dropped = 0;
+        if (GateProbe::instance().write(file_name_, records, dropped)) {
+            std::cout << "Debug: Probe wrote " << records << " timesteps (" << dropped << " dropped) to '"
+                      << file_name_ << "'." << std::endl;
+        }
+    }
+
+    GateProbeSession(const GateProbeSession &) = delete;
+    GateProbeSession &operator=(const GateProbeSession &) = delete;
+
+private:
+    std::string file_name_;
+};
+
+#endif // GATE_PROBE_H
@@ -0,0 +1,365 @@
+#include "lstm_activation.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include "lstm_packed.h"
+
+#ifdef LSTM_HLS_MATH
+#include <hls_math.h>
+#else
+#include "ap_fixed_emu.h"
+#endif
+
+static const char *const activation_names[LSTM_ACT_COUNT] = {"libm", "poly", "rational", "pwl", "hls64", "hls32"};
+
+const char *lstm_activation_name(LstmActivation act) {
+    return act >= 0 && act < LSTM_ACT_COUNT ? activation_names[act] : "unknown";
+}
+
+bool lstm_activation_available(LstmActivation act) {
+    return act >= 0 && act < LSTM_ACT_COUNT;
+}
+
+bool lstm_parse_activation(const char *name, LstmActivation &act) {
+    for (int i = 0; i < LSTM_ACT_COUNT; i++) {
+        if (std::strcmp(name, activation_names[i]) == 0 && lstm_activation_available(LstmActivation(i))) {
+            act = LstmActivation(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+double lstm_activation_max_error(LstmActivation act) {
+    switch (act) {
+    case LSTM_ACT_LIBM: return 1.0e-7;
+    case LSTM_ACT_POLY: return 1.8e-7;
+    case LSTM_ACT_RATIONAL: return 2.9e-7;
+    case LSTM_ACT_PWL: return 9.4e-5;
+    case LSTM_ACT_HLS64: return 3.0e-8;
+    case LSTM_ACT_HLS32: return 3.0e-5;
+    default: return 0.0;
+    }
+}
+
+// What an in-place pass computes
+enum ActKind {
+    ACT_SIGMOID = 0,
+    ACT_TANH = 1,
+    ACT_GATES = 2    // tanh on the LSTM_GATE_C lane of every hidden unit, sigmoid elsewhere
+};
+
+// Sigmoid table for the pwl tier: knots every 1/16 over [-16, 16], value and slope per segment
+#define PWL_RANGE 16
+#define PWL_STEPS 16
+#define PWL_SEGMENTS (2 * PWL_RANGE * PWL_STEPS)
+
+struct PwlTable {
+    alignas(LSTM_ALIGN) float value[PWL_SEGMENTS + 1];
+    alignas(LSTM_ALIGN) float slope[PWL_SEGMENTS];
+
+    PwlTable() {
+        for (int i = 0; i <= PWL_SEGMENTS; i++) {
+            value[i] = float(1.0 / (1.0 + std::exp(-(double(i) / PWL_STEPS - PWL_RANGE))));
+        }
+        for (int i = 0; i < PWL_SEGMENTS; i++) {
+            slope[i] = value[i + 1] - value[i];
+        }
+    }
+};
+
+static const PwlTable &pwl_table() {
+    static const PwlTable table;
+    return table;
+}
+
+// Scalar forms of each tier. The scalar SIMD level and the double engines use
+// these; the vector kernels below evaluate the same formulas.
+struct LibmTier {
+    template <typename T>
+    static T sigmoid(T x) { return T(1) / (T(1) + std::exp(-x)); }
+    template <typename T>
+    static T tanh(T x) { return std::tanh(x); }
+};
+
+struct PolyTier {
+    // Cephes expf: x = n ln2 + r with |r| <= ln2 / 2, exp(r) by a degree 6 polynomial
+    template <typename T>
+    static T exp(T x) {
+        x = std::min(std::max(x, T(-87.3)), T(88.3));
+        const T n = std::nearbyint(x * T(1.44269504088896341));
+        const T r = x - n * T(0.693359375) + n * T(2.12194440e-4);
+        T p = T(1.9875691500e-4);
+        p = p * r + T(1.3981999507e-3);
+        p = p * r + T(8.3334519073e-3);
+        p = p * r + T(4.1665795894e-2);
+        p = p * r + T(1.6666665459e-1);
+        p = p * r + T(5.0000001201e-1);
+        return std::ldexp(p * r * r + r + T(1), int(n));
+    }
+    template <typename T>
+    static T sigmoid(T x) { return T(1) / (T(1) + exp(-x)); }
+    template <typename T>
+    static T tanh(T x) { return T(2) * sigmoid(T(2) * x) - T(1); }
+};
+
+struct RationalTier {
+    // Odd degree 13 over even degree 6, float accurate on [-7.9, 7.9] where tanh
+    // is within half an ulp of +-1
+    template <typename T>
+    static T tanh(T x) {
+        x = std::min(std::max(x, T(-7.90531110763549805)), T(7.90531110763549805));
+        const T x2 = x * x;
+        T p = T(-2.76076847742355e-16);
+        p = p * x2 + T(2.00018790482477e-13);
+        p = p * x2 + T(-8.60467152213735e-11);
+        p = p * x2 + T(5.12229709037114e-08);
+        p = p * x2 + T(1.48572235717979e-05);
+        p = p * x2 + T(6.37261928875436e-04);
+        p = p * x2 + T(4.89352455891786e-03);
+        T q = T(1.19825839466702e-06);
+        q = q * x2 + T(1.18534705686654e-04);
+        q = q * x2 + T(2.26843463243900e-03);
+        q = q * x2 + T(4.89352518554385e-03);
+        return x * p / q;
+    }
+    template <typename T>
+    static T sigmoid(T x) { return T(0.5) + T(0.5) * tanh(T(0.5) * x); }
+};
+
+struct PwlTier {
+    template <typename T>
+    static T sigmoid(T x) {
+        const PwlTable &table = pwl_table();
+        const T u = (std::min(std::max(x, T(-PWL_RANGE)), T(PWL_RANGE)) + T(PWL_RANGE)) * T(PWL_STEPS);
+        const int i = std::min(int(u), PWL_SEGMENTS - 1);
+        return T(table.value[i]) + (u - T(i)) * T(table.slope[i]);
+    }
+    template <typename T>
+    static T tanh(T x) { return T(2) * sigmoid(T(2) * x) - T(1); }
+};
+
+// Same expressions as sigmoid() in LSTM_RNN_HW/lstm_rnn.cpp and the hls::tanh
+// calls of both kernels, on the kernel's fixed_type. Without the Vitis headers
+// they run on ap_fixed_emu and hls_emu, as the -DAP_FIXED_EMU C-simulation does.
+#ifdef LSTM_HLS_MATH
+template <int W, int I>
+using hls_fixed = ap_fixed<W, I>;
+namespace hls_fn = hls;
+#else
+template <int W, int I>
+using hls_fixed = ap_fixed_emu<W, I>;
+namespace hls_fn = hls_emu;
+#endif
+
+template <int W, int I>
+struct HlsTier {
+    typedef hls_fixed<W, I> fixed_type;
+
+    template <typename T>
+    static T sigmoid(T x) {
+        const fixed_type v = x;
+        const fixed_type result = (fixed_type)1.0 / ((fixed_type)1.0 + hls_fn::exp(-v));
+        return T(result.to_double());
+    }
+    template <typename T>
+    static T tanh(T x) {
+        const fixed_type result = hls_fn::tanh(fixed_type(x));
+        return T(result.to_double());
+    }
+};
+
+template <typename Tier, typename T>
+static void apply_scalar(T *x, int n, ActKind kind) {
+    switch (kind) {
+    case ACT_SIGMOID:
+        for (int j = 0; j < n; j++) {
+            x[j] = Tier::sigmoid(x[j]);
+        }
+        break;
+    case ACT_TANH:
+        for (int j = 0; j < n; j++) {
+            x[j] = Tier::tanh(x[j]);
+        }
+        break;
+    case ACT_GATES:
+        for (int j = 0; j < n; j++) {
+            x[j] = j % LSTM_GATES == LSTM_GATE_C ? Tier::tanh(x[j]) : Tier::sigmoid(x[j]);
+        }
+        break;
+    }
+}
+
+template <typename T>
+static void activate_scalar(T *x, int n, LstmActivation act, ActKind kind) {
+    switch (act) {
+    case LSTM_ACT_POLY: apply_scalar<PolyTier>(x, n, kind); break;
+    case LSTM_ACT_RATIONAL: apply_scalar<RationalTier>(x, n, kind); break;
+    case LSTM_ACT_PWL: apply_scalar<PwlTier>(x, n, kind); break;
+    case LSTM_ACT_HLS64: apply_scalar<HlsTier<64, 32> >(x, n, kind); break;
+    case LSTM_ACT_HLS32: apply_scalar<HlsTier<32, 16> >(x, n, kind); break;
+    default: apply_scalar<LibmTier>(x, n, kind); break;
+    }
+}
+
+// AVX2 kernels. Each tier has one base function F (sigmoid for poly and pwl,
+// tanh for rational) and every pass computes x = a * F(k * x) + b with
+// per-lane (k, a, b), so sigmoid, tanh and the interleaved gate vector all run
+// through the same loop: tanh(x) = 2 sigmoid(2x) - 1 and
+// sigmoid(x) = tanh(x/2) / 2 + 1/2.
+struct ActLanes {
+    float k[8];
+    float a[8];
+    float b[8];
+};
+
+static ActLanes make_lanes(bool tanh_base, ActKind kind) {
+    ActLanes lanes;
+    for (int j = 0; j < 8; j++) {
+        const bool tanh_lane = kind == ACT_TANH || (kind == ACT_GATES && j % LSTM_GATES == LSTM_GATE_C);
+        if (tanh_base) {
+            lanes.k[j] = tanh_lane ? 1.0f : 0.5f;
+            lanes.a[j] = tanh_lane ? 1.0f : 0.5f;
+            lanes.b[j] = tanh_lane ? 0.0f : 0.5f;
+        } else {
+            lanes.k[j] = tanh_lane ? 2.0f : 1.0f;
+            lanes.a[j] = tanh_lane ? 2.0f : 1.0f;
+            lanes.b[j] = tanh_lane ? -1.0f : 0.0f;
+        }
+    }
+    return lanes;
+}
+
+struct PolySigmoid8 {
+    __attribute__((target("avx2,fma")))
+    static inline __m256 exp(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-87.3f)), _mm256_set1_ps(88.3f));
+        const __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                                         _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+        r = _mm256_fmadd_ps(n, _mm256_set1_ps(2.12194440e-4f), r);
+        __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+        p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+        const __m256 y = _mm256_add_ps(_mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r), _mm256_set1_ps(1.0f));
+        const __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(scale));
+    }
+
+    __attribute__((target("avx2,fma")))
+    static inline __m256 apply(__m256 x) {
+        const __m256 one = _mm256_set1_ps(1.0f);
+        return _mm256_div_ps(one, _mm256_add_ps(one, exp(_mm256_sub_ps(_mm256_setzero_ps(), x))));
+    }
+};
+
+struct RationalTanh8 {
+    __attribute__((target("avx2,fma")))
+    static inline __m256 apply(__m256 x) {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-7.90531110763549805f)),
+                          _mm256_set1_ps(7.90531110763549805f));
+        const __m256 x2 = _mm256_mul_ps(x, x);
+        __m256 p = _mm256_set1_ps(-2.76076847742355e-16f);
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(2.00018790482477e-13f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(-8.60467152213735e-11f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(5.12229709037114e-08f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(1.48572235717979e-05f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(6.37261928875436e-04f));
+        p = _mm256_fmadd_ps(p, x2, _mm256_set1_ps(4.89352455891786e-03f));
+        __m256 q = _mm256_set1_ps(1.19825839466702e-06f);
+        q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(1.18534705686654e-04f));
+        q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(2.26843463243900e-03f));
+        q = _mm256_fmadd_ps(q, x2, _mm256_set1_ps(4.89352518554385e-03f));
+        return _mm256_div_ps(_mm256_mul_ps(x, p), q);
+    }
+};
+
+struct PwlSigmoid8 {
+    __attribute__((target("avx2,fma")))
+    static inline __m256 apply(__m256 x) {
+        const PwlTable &table = pwl_table();
+        const __m256 range = _mm256_set1_ps(float(PWL_RANGE));
+        const __m256 clamped = _mm256_min_ps(_mm256_max_ps(x, _mm256_sub_ps(_mm256_setzero_ps(), range)), range);
+        const __m256 u = _mm256_mul_ps(_mm256_add_ps(clamped, range), _mm256_set1_ps(float(PWL_STEPS)));
+        const __m256i i = _mm256_min_epi32(_mm256_cvttps_epi32(u), _mm256_set1_epi32(PWL_SEGMENTS - 1));
+        const __m256 t = _mm256_sub_ps(u, _mm256_cvtepi32_ps(i));
+        return _mm256_fmadd_ps(t, _mm256_i32gather_ps(table.slope, i, 4), _mm256_i32gather_ps(table.value, i, 4));
+    }
+};
+
+// The masked tail keeps gate lanes in step, since the pattern repeats every 8
+template <typename F>
+__attribute__((target("avx2,fma")))
+static void affine_avx2(float *x, int n, const ActLanes &lanes) {
+    const __m256 k = _mm256_loadu_ps(lanes.k), a = _mm256_loadu_ps(lanes.a), b = _mm256_loadu_ps(lanes.b);
+    int j = 0;
+    for (; j + 8 <= n; j += 8) {
+        const __m256 v = _mm256_loadu_ps(x + j);
+        _mm256_storeu_ps(x + j, _mm256_fmadd_ps(a, F::apply(_mm256_mul_ps(k, v)), b));
+    }
+    if (j < n) {
+        const __m256i mask = _mm256_cmpgt_epi32(_mm256_set1_epi32(n - j), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+        const __m256 v = _mm256_maskload_ps(x + j, mask);
+        _mm256_maskstore_ps(x + j, mask, _mm256_fmadd_ps(a, F::apply(_mm256_mul_ps(k, v)), b));
+    }
+    _mm256_zeroupper();
+}
+
+// Dispatch: one vector kernel per tier, nullptr where the scalar form runs
+typedef void (*affine_f32_fn)(float *, int, const ActLanes &);
+
+struct VectorTiers {
+    affine_f32_fn fn[LSTM_ACT_COUNT];
+    ActLanes lanes[LSTM_ACT_COUNT][3];
+
+    VectorTiers() {
+        for (int act = 0; act < LSTM_ACT_COUNT; act++) {
+            fn[act] = nullptr;
+            for (int kind = 0; kind < 3; kind++) {
+                lanes[act][kind] = make_lanes(act == LSTM_ACT_RATIONAL, ActKind(kind));
+            }
+        }
+        if (lstm_simd_level() >= LSTM_SIMD_AVX2) {
+            fn[LSTM_ACT_POLY] = affine_avx2<PolySigmoid8>;
+            fn[LSTM_ACT_RATIONAL] = affine_avx2<RationalTanh8>;
+            fn[LSTM_ACT_PWL] = affine_avx2<PwlSigmoid8>;
+        }
+    }
+};
+
+static void activate(float *x, int n, LstmActivation act, ActKind kind) {
+    static const VectorTiers tiers;
+    if (act >= 0 && act < LSTM_ACT_COUNT && tiers.fn[act]) {
+        tiers.fn[act](x, n, tiers.lanes[act][kind]);
+    } else {
+        activate_scalar(x, n, act, kind);
+    }
+}
+
+void lstm_sigmoid_n(float *x, int n, LstmActivation act) {
+    activate(x, n, act, ACT_SIGMOID);
+}
+
+void lstm_sigmoid_n(double *x, int n, LstmActivation act) {
+    activate_scalar(x, n, act, ACT_SIGMOID);
+}
+
+void lstm_tanh_n(float *x, int n, LstmActivation act) {
+    activate(x, n, act, ACT_TANH);
+}
+
+void lstm_tanh_n(double *x, int n, LstmActivation act) {
+    activate_scalar(x, n, act, ACT_TANH);
+}
+
+void lstm_gate_activations(float *gates, int hidden_size, LstmActivation act) {
+    activate(gates, LSTM_GATES * hidden_size, act, ACT_GATES);
+}
+
+void lstm_gate_activations(double *gates, int hidden_size, LstmActivation act) {
+    activate_scalar(gates, LSTM_GATES * hidden_size, act, ACT_GATES);
+}
@@ -0,0 +1,77 @@
+#ifndef LSTM_ACTIVATION_H
+#define LSTM_ACTIVATION_H
+
+// Gate nonlinearities for the packed, batched, cached, stream and quantized
+// engines and the RNN cell. The tier is a property of the loaded model
+// (PackedLstmWeights::activation, RnnModel::activation, the weight file
+// header), so one process can run a model tuned with libm next to one tuned
+// with the fast approximations.
+//
+// Max absolute error of the float kernels (vector and scalar), measured
+// against double libm at the same float inputs on a 2^24 point sweep of
+// [-20, 20]:
+//
+//   tier       sigmoid   tanh      method
+//   libm       8.9e-8    1.0e-7    std::exp / std::tanh, the default
+//   poly       8.9e-8    1.8e-7    exp by 2^n range reduction and a degree 6
+//                                  polynomial, sigmoid = 1 / (1 + exp(-x)),
+//                                  tanh = 2 sigmoid(2x) - 1
+//   rational   1.7e-7    2.9e-7    13/6 odd/even rational tanh clamped at
+//                                  +-7.9, sigmoid = (1 + tanh(x/2)) / 2
+//   pwl        4.7e-5    9.4e-5    linear interpolation of a 513 knot sigmoid
+//                                  table over [-16, 16]
+//   hls64      3.0e-8    3.0e-8    ap_fixed<64, 32> through hls::exp and
+//   hls32      1.9e-5    3.0e-5    hls::tanh, as LSTM_RNN_HW and RNN_HW
+//
+// The double engines run the same formulas in double: poly is then within
+// 5.4e-10 and hls64 within 4.6e-10, rational (float coefficients), pwl (float
+// table) and hls32 (16 fractional bits) keep their float error. On the
+// 64-value gate vector of a 16 unit cell the AVX2 kernels take 60-100 ns
+// against ~600 ns for libm.
+//
+// The hls tiers quantize each input to the kernel's ap_fixed type and apply
+// the kernel's sigmoid()/hls::tanh expressions to it. With the Vitis HLS
+// headers (make HLS_INCLUDE=<Vitis>/include) they use the vendor ap_fixed and
+// hls_math; otherwise ap_fixed_emu and hls_emu, whose exp/tanh only
+// approximate the vendor ones (see ap_fixed_emu.h). Either way they model the
+// activation quantization only: the kernels also accumulate in ap_fixed and
+// update h in place, so they are a way to see the effect of the fixed-point
+// activations on the CPU engines, not a bit match for the FPGA.
+//
+// poly, rational and pwl run 8 lanes at a time on AVX2 and AVX-512 (the gate
+// vectors are 4 * hidden wide, too short for 512-bit lanes to pay off) and
+// fall back to the same formulas one element at a time.
+
+enum LstmActivation {
+    LSTM_ACT_LIBM = 0,
+    LSTM_ACT_POLY = 1,
+    LSTM_ACT_RATIONAL = 2,
+    LSTM_ACT_PWL = 3,
+    LSTM_ACT_HLS64 = 4,
+    LSTM_ACT_HLS32 = 5
+};
+
+#define LSTM_ACT_COUNT 6
+
+const char *lstm_activation_name(LstmActivation act);
+
+// False for unknown tiers; every tier runs in every build
+bool lstm_activation_available(LstmActivation act);
+bool lstm_parse_activation(const char *name, LstmActivation &act);
+
+// Measured max absolute error of the tier's float kernels, the larger of
+// sigmoid and tanh in the table above
+double lstm_activation_max_error(LstmActivation act);
+
+// In place over n values
+void lstm_sigmoid_n(float *x, int n, LstmActivation act);
+void lstm_sigmoid_n(double *x, int n, LstmActivation act);
+void lstm_tanh_n(float *x, int n, LstmActivation act);
+void lstm_tanh_n(double *x, int n, LstmActivation act);
+
+// Interleaved gate pre-activations [hidden][LSTM_GATES] in place: sigmoid on
+// the input, forget and output gates, tanh on the candidate
+void lstm_gate_activations(float *gates, int hidden_size, LstmActivation act);
+void lstm_gate_activations(double *gates, int hidden_size, LstmActivation act);
+
+#endif // LSTM_ACTIVATION_H
@@ -0,0 +1,77 @@
+#ifndef LSTM_BATCH_H
+#define LSTM_BATCH_H
+
+#include "lstm_packed.h"
+
+// Batched LSTM over the packed layout. B independent sequences advance in
+// lockstep, each with its own h/c row, and every timestep is one GEMM of the
+// [4*hidden][stride] weight block against the B stacked [x | h_prev] columns.
+
+// Per-thread scratch for up to max_batch sequences
+template <typename T>
+struct LstmBatchWorkspace {
+    int max_batch;
+    int gate_stride;         // padded 4*hidden
+    AlignedBuffer<T> xh;     // [max_batch][stride]
+    AlignedBuffer<T> gates;  // [max_batch][gate_stride]
+
+    LstmBatchWorkspace(const PackedLstmWeights<T> &weights, int batch)
+        : max_batch(batch), gate_stride(lstm_padded<T>(weights.rows())),
+          xh((size_t)batch * weights.stride), gates((size_t)batch * lstm_padded<T>(weights.rows())) {}
+};
+
+// One step for batch sequences. x is [batch][x_stride] (x_stride 0 feeds the same row to every
+// sequence), h/c are [batch][hidden] and updated in place.
+template <typename T>
+void lstm_cell_batch(const PackedLstmWeights<T> &weights, LstmBatchWorkspace<T> &ws,
+                     const T *x, int x_stride, T *h, T *c, int batch) {
+    const int in = weights.input_size, hid = weights.hidden_size, stride = weights.stride;
+
+    for (int b = 0; b < batch; b++) {
+        T *xh = ws.xh.data() + (size_t)b * stride;
+        const T *xb = x + (size_t)b * x_stride;
+        const T *hb = h + (size_t)b * hid;
+        for (int j = 0; j < in; j++) {
+            xh[j] = xb[j];
+        }
+        for (int j = 0; j < hid; j++) {
+            xh[weights.x_stride + j] = hb[j];
+        }
+    }
+
+    lstm_gemm(weights.weights, weights.bias, ws.xh.data(), stride, ws.gates.data(), ws.gate_stride,
+              weights.rows(), stride, batch);
+
+    for (int b = 0; b < batch; b++) {
+        T *hb = h + (size_t)b * hid;
+        T *cb = c + (size_t)b * hid;
+        lstm_pointwise(ws.gates.data() + (size_t)b * ws.gate_stride, cb, hb, cb, hid, weights.activation);
+    }
+}
+
+// Batched sequence. x_seq is [batch][seq_length][input_size], output_data is [batch][input_size].
+// h/c carry over between calls exactly like lstm_sequence.
+template <typename T>
+void lstm_sequence_batch(const PackedLstmWeights<T> &weights, LstmBatchWorkspace<T> &ws,
+                         const T *x_seq, int seq_length, T *h, T *c, T *output_data, int batch) {
+    const int in = weights.input_size, hid = weights.hidden_size;
+
+    for (int base = 0; base < batch; base += ws.max_batch) {
+        const int n = batch - base < ws.max_batch ? batch - base : ws.max_batch;
+        const T *xs = x_seq + (size_t)base * seq_length * in;
+        T *hs = h + (size_t)base * hid;
+        T *cs = c + (size_t)base * hid;
+
+        for (int t = 0; t < seq_length; t++) {
+            lstm_cell_batch(weights, ws, xs + (size_t)t * in, seq_length * in, hs, cs, n);
+        }
+
+        for (int b = 0; b < n; b++) {
+            for (int i = 0; i < in; i++) {
+                output_data[(size_t)(base + b) * in + i] = hs[(size_t)b * hid + i];
+            }
+        }
+    }
+}
+
+#endif // LSTM_BATCH_H
@@ -0,0 +1,104 @@
+#ifndef LSTM_CACHE_H
+#define LSTM_CACHE_H
+
+#include "lstm_packed.h"
+
+// Two-phase lstm_sequence for overlapping windows over one series.
+// Phase 1 computes P[t] = W_* . x_t + b_* for a run of bars with one GEMM and
+// keeps them in a ring keyed by bar index. Phase 2 only does the U_* . h half
+// per step, so sliding a window by one bar costs one new projection instead of
+// seq_length of them.
+
+#define LSTM_PROJECT_CHUNK 256  // bars per phase-1 GEMM
+
+template <typename T>
+class LstmProjectionCache {
+public:
+    // capacity is the number of bars kept, at least the longest window swept
+    LstmProjectionCache(const PackedLstmWeights<T> &weights, int capacity)
+        : weights_(weights), capacity_(capacity), gate_stride_(lstm_padded<T>(weights.rows())),
+          proj_((size_t)capacity * lstm_padded<T>(weights.rows())),
+          staging_((size_t)LSTM_PROJECT_CHUNK * weights.x_stride), first_bar_(0), end_bar_(0) {}
+
+    // Project bars [start_bar, start_bar + count), series rows are x_stride_in apart.
+    // Bars already cached are skipped; older bars fall out of the ring.
+    void project(const T *series, long start_bar, long count, int x_stride_in) {
+        const int in = weights_.input_size;
+        long bar = start_bar;
+        const long end = start_bar + count;
+
+        if (bar < end_bar_ && bar >= first_bar_) {
+            series += (end_bar_ - bar) * x_stride_in;
+            bar = end_bar_;
+        } else if (bar != end_bar_) {
+            first_bar_ = end_bar_ = bar;
+        }
+
+        while (bar < end) {
+            // Chunks stop at the ring wrap so GEMM output rows stay contiguous
+            const long slot = bar % capacity_;
+            long n = end - bar;
+            if (n > LSTM_PROJECT_CHUNK) n = LSTM_PROJECT_CHUNK;
+            if (n > capacity_ - slot) n = capacity_ - slot;
+
+            for (long r = 0; r < n; r++) {
+                T *dst = staging_.data() + r * weights_.x_stride;
+                const T *src = series + r * x_stride_in;
+                for (int j = 0; j < in; j++) {
+                    dst[j] = src[j];
+                }
+            }
+            lstm_gemm(weights_.weights, weights_.bias, staging_.data(), weights_.x_stride,
+                      proj_.data() + slot * gate_stride_, gate_stride_,
+                      weights_.rows(), weights_.stride, weights_.x_stride, (int)n);
+
+            series += n * x_stride_in;
+            bar += n;
+            end_bar_ = bar;
+            if (end_bar_ - first_bar_ > capacity_) {
+                first_bar_ = end_bar_ - capacity_;
+            }
+        }
+    }
+
+    // Drop everything, e.g. when switching to another series
+    void clear() { first_bar_ = end_bar_ = 0; }
+
+    bool contains(long first, long count) const { return first >= first_bar_ && first + count <= end_bar_; }
+    const T *row(long bar) const { return proj_.data() + (bar % capacity_) * gate_stride_; }
+    long first_bar() const { return first_bar_; }
+    long end_bar() const { return end_bar_; }
+    int capacity() const { return capacity_; }
+
+private:
+    const PackedLstmWeights<T> &weights_;
+    int capacity_;
+    int gate_stride_;
+    AlignedBuffer<T> proj_;     // [capacity][gate_stride]
+    AlignedBuffer<T> staging_;  // [LSTM_PROJECT_CHUNK][x_stride], padded inputs
+    long first_bar_;
+    long end_bar_;
+};
+
+// Phase 2: run the window [first_bar, first_bar + seq_length) from cached projections.
+// The window must be projected already; h/c carry over like lstm_sequence.
+template <typename T>
+void lstm_sequence_cached(const PackedLstmWeights<T> &weights, const LstmProjectionCache<T> &cache,
+                          LstmWorkspace<T> &ws, long first_bar, int seq_length, T *h, T *c, T *output_data) {
+    T *hv = ws.xh.data() + weights.x_stride;
+    const T *U = weights.weights + weights.x_stride;
+
+    for (int t = 0; t < seq_length; t++) {
+        for (int j = 0; j < weights.hidden_size; j++) {
+            hv[j] = h[j];
+        }
+        lstm_gemv(U, cache.row(first_bar + t), hv, ws.gates.data(), weights.rows(), weights.stride, weights.h_stride);
+        lstm_pointwise(ws.gates.data(), c, h, c, weights.hidden_size, weights.activation);
+    }
+
+    for (int i = 0; i < weights.input_size; i++) {
+        output_data[i] = h[i];
+    }
+}
+
+#endif // LSTM_CACHE_H
@@ -0,0 +1,350 @@
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include "data_io.h"
+#include "series_store.h"
+#include "online_normalizer.h"
+#include "lstm_model.h"
+#include "lstm_packed.h"
+#include "lstm_stream.h"
+#include "lstm_cache.h"
+#include "lstm_weight_io.h"
+#ifdef LSTM_PROBE
+#include "gate_probe.h"
+#endif
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Default sequence length
+
+// Rolling prediction loop shared by the compiled and runtime engines.
+// step(window, h, c, output) runs one lstm_sequence over a seq x INPUT_SIZE window.
+template <typename T, typename Step>
+void predict_days(const SeriesStore<double> &normalized_data, int prediction_days,
+                  int hidden_size, int seq_length, const OnlineNormalizer &normalizer,
+                  std::ostream &output_file, Step step) {
+    std::vector<T> input_seq(seq_length * INPUT_SIZE);
+    normalized_data.copy_window(0, seq_length, input_seq.data());
+
+    std::vector<T> h(hidden_size, T(0)), c(hidden_size, T(0));
+    T output_data[INPUT_SIZE] = {0};
+
+    for (int day = 0; day < prediction_days; ++day) {
+        step(input_seq.data(), h.data(), c.data(), output_data);
+
+        output_file << "Day " << day + 1 << ": ";
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            double denormalized_value = normalizer.denormalize(i, double(output_data[i]));
+            output_file << denormalized_value << " ";
+        }
+        output_file << "\n";
+
+        // Shift input sequence for the next prediction
+        for (int i = 0; i < (seq_length - 1) * INPUT_SIZE; ++i) {
+            input_seq[i] = input_seq[i + INPUT_SIZE];
+        }
+        for (int j = 0; j < INPUT_SIZE; ++j) {
+            input_seq[(seq_length - 1) * INPUT_SIZE + j] = output_data[j];
+        }
+    }
+}
+
+// Fused four-gate engine, same weights repacked into one aligned block
+template <typename T>
+void run_packed(const PackedLstmWeights<T> &weights, int seq_length,
+                const SeriesStore<double> &normalized_data, int prediction_days,
+                const OnlineNormalizer &normalizer, std::ostream &out) {
+    LstmWorkspace<T> ws(weights);
+    predict_days<T>(normalized_data, prediction_days, weights.hidden_size, seq_length, normalizer, out,
+                    [&](const T *x_seq, T *h, T *c, T *output_data) {
+                        lstm_sequence_packed(weights, ws, x_seq, seq_length, h, c, output_data);
+                    });
+}
+
+// Cached engine: same rolling windows as predict_days, but the W half of every
+// step comes from the projection cache, so each day projects only the new bar
+template <typename T>
+void run_cached(const PackedLstmWeights<T> &weights, int seq_length,
+                const SeriesStore<double> &normalized_data, int prediction_days,
+                const OnlineNormalizer &normalizer, std::ostream &output_file) {
+    LstmWorkspace<T> ws(weights);
+    LstmProjectionCache<T> cache(weights, 2 * seq_length);
+
+    std::vector<T> series(seq_length * INPUT_SIZE);
+    normalized_data.copy_window(0, seq_length, series.data());
+    cache.project(series.data(), 0, seq_length, INPUT_SIZE);
+
+    std::vector<T> h(weights.hidden_size, T(0)), c(weights.hidden_size, T(0));
+    T output_data[INPUT_SIZE] = {0};
+
+    for (int day = 0; day < prediction_days; ++day) {
+        lstm_sequence_cached(weights, cache, ws, day, seq_length, h.data(), c.data(), output_data);
+
+        output_file << "Day " << day + 1 << ": ";
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            double denormalized_value = normalizer.denormalize(i, double(output_data[i]));
+            output_file << denormalized_value << " ";
+        }
+        output_file << "\n";
+
+        // The prediction becomes the newest bar of the next window
+        cache.project(output_data, day + seq_length, 1, INPUT_SIZE);
+    }
+}
+
+// Streaming engine: the window primes the state once, then every day is a single
+// push() of the previous prediction (one cell step instead of seq_length)
+template <typename T>
+void run_stream(const PackedLstmWeights<T> &weights, int seq_length, const LstmStreamConfig &config,
+                const SeriesStore<double> &normalized_data, int prediction_days,
+                const OnlineNormalizer &normalizer, std::ostream &output_file) {
+    LstmStream<T> stream(weights, config);
+    T bar[INPUT_SIZE] = {0};
+    T output_data[INPUT_SIZE] = {0};
+
+    for (int i = 0; i < seq_length; ++i) {
+        normalized_data.copy_window(i, 1, bar);
+        stream.push(bar, output_data);
+    }
+
+    for (int day = 0; day < prediction_days; ++day) {
+        if (day > 0) {
+            stream.push(output_data, output_data);
+        }
+
+        output_file << "Day " << day + 1 << ": ";
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            double denormalized_value = normalizer.denormalize(i, double(output_data[i]));
+            output_file << denormalized_value << " ";
+        }
+        output_file << "\n";
+    }
+}
+
+// Run one of the packed-layout engines: packed, cached, stream, stream-periodic, stream-staggered.
+// False for any other name.
+template <typename T>
+bool run_packed_engine(const std::string &engine, PackedLstmWeights<T> weights, LstmActivation activation,
+                       int seq_length, const SeriesStore<double> &normalized_data, int prediction_days,
+                       const OnlineNormalizer &normalizer, std::ostream &out) {
+    weights.activation = activation;
+    if (engine == "packed") {
+        run_packed<T>(weights, seq_length, normalized_data, prediction_days, normalizer, out);
+        return true;
+    }
+    if (engine == "cached") {
+        run_cached<T>(weights, seq_length, normalized_data, prediction_days, normalizer, out);
+        return true;
+    }
+
+    LstmStreamConfig config;
+    if (engine == "stream") {
+        config = LstmStreamConfig(LSTM_RESET_NEVER, 0, 0);
+    } else if (engine == "stream-periodic") {
+        config = LstmStreamConfig(LSTM_RESET_PERIODIC, seq_length, 0);
+    } else if (engine == "stream-staggered") {
+        config = LstmStreamConfig(LSTM_RESET_STAGGERED, seq_length, 0);
+    } else {
+        std::cerr << "Error: Unknown engine '" << engine << "'." << std::endl;
+        return false;
+    }
+    run_stream<T>(weights, seq_length, config, normalized_data, prediction_days, normalizer, out);
+    return true;
+}
+
+static bool is_engine(const std::string &engine) {
+    return engine == "packed" || engine == "model" || engine == "cached" || engine == "stream" ||
+           engine == "stream-periodic" || engine == "stream-staggered";
+}
+
+template <int Hidden, typename T>
+bool run_compiled(const std::string &engine, const WeightFile *weights, LstmActivation activation,
+                  const SeriesStore<double> &normalized_data, int prediction_days, const OnlineNormalizer &normalizer,
+                  std::ostream &out) {
+    typedef LstmModel<INPUT_SIZE, Hidden, SEQ_LENGTH, T> Model;
+    std::unique_ptr<Model> model(new Model());
+    if (!weights) {
+        model->initialize_weights_and_biases();
+    } else if (!load_lstm_weights(*weights, *model)) {
+        return false;
+    }
+
+    if (engine != "model") {
+        return run_packed_engine<T>(engine, pack_lstm_weights(*model), activation, SEQ_LENGTH, normalized_data,
+                                    prediction_days, normalizer, out);
+    }
+
+    predict_days<T>(normalized_data, prediction_days, Hidden, SEQ_LENGTH, normalizer, out,
+                    [&](const T *x_seq, T *h, T *c, T *output_data) {
+                        model->lstm_sequence(reinterpret_cast<const T (*)[INPUT_SIZE]>(x_seq), h, c, output_data);
+                    });
+    return true;
+}
+
+template <typename T>
+bool run_runtime(const std::string &engine, const WeightFile *weights, LstmActivation activation, int hidden_size,
+                 int seq_length, const SeriesStore<double> &normalized_data, int prediction_days,
+                 const OnlineNormalizer &normalizer, std::ostream &out) {
+    LstmModelRuntime<T> model(INPUT_SIZE, hidden_size, seq_length);
+    if (!weights) {
+        model.initialize_weights_and_biases();
+    } else if (!load_lstm_weights(*weights, model)) {
+        return false;
+    }
+
+    if (engine != "model") {
+        return run_packed_engine<T>(engine, pack_lstm_weights(model), activation, seq_length, normalized_data,
+                                    prediction_days, normalizer, out);
+    }
+
+    predict_days<T>(normalized_data, prediction_days, hidden_size, seq_length, normalizer, out,
+                    [&](const T *x_seq, T *h, T *c, T *output_data) {
+                        model.lstm_sequence(x_seq, h, c, output_data);
+                    });
+    return true;
+}
+
+// Pick a compile-time specialization for common shapes, fall back to the runtime engine.
+// Packed engines run straight from a weight file, in place when its layout matches.
+template <typename T>
+bool run_model(const std::string &engine, const WeightFile *weights, LstmActivation activation, int hidden_size,
+               int seq_length, const SeriesStore<double> &normalized_data, int prediction_days,
+               const OnlineNormalizer &normalizer, std::ostream &out) {
+    if (weights && engine != "model") {
+        PackedLstmWeights<T> packed;
+        if (!load_packed_lstm_weights(*weights, INPUT_SIZE, packed)) {
+            return false;
+        }
+        std::cout << "Debug: Packed weights " << (packed.storage.data() ? "repacked" : "mapped in place")
+                  << " from the weight file." << std::endl;
+        return run_packed_engine<T>(engine, std::move(packed), activation, seq_length, normalized_data,
+                                    prediction_days, normalizer, out);
+    }
+
+    if (seq_length == SEQ_LENGTH) {
+        switch (hidden_size) {
+        case 16: return run_compiled<16, T>(engine, weights, activation, normalized_data, prediction_days, normalizer, out);
+        case 32: return run_compiled<32, T>(engine, weights, activation, normalized_data, prediction_days, normalizer, out);
+        case 50: return run_compiled<50, T>(engine, weights, activation, normalized_data, prediction_days, normalizer, out);
+        case 64: return run_compiled<64, T>(engine, weights, activation, normalized_data, prediction_days, normalizer, out);
+        default: break;
+        }
+    }
+    std::cout << "Debug: Using runtime-sized engine for hidden " << hidden_size
+              << ", sequence " << seq_length << std::endl;
+    return run_runtime<T>(engine, weights, activation, hidden_size, seq_length, normalized_data, prediction_days,
+                          normalizer, out);
+}
+
+static void print_usage(const char *program) {
+    std::cerr << "Usage: " << program << " <Data File> [hidden size] [sequence length] [float|double]"
+              << " [packed|model|cached|stream|stream-periodic|stream-staggered] [weights file]"
+              << " [libm|poly|rational|pwl|hls64|hls32]" << std::endl;
+}
+
+int main(int argc, char **argv) {
+#ifdef LSTM_PROBE
+    // make PROBE=1: the packed engine's timesteps, written at exit
+    GateProbeSession probe_session;
+#endif
+    if (argc < 2) {
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::string file_name = argv[1];
+    int hidden_size = argc > 2 ? std::atoi(argv[2]) : 16;
+    const int seq_length = argc > 3 ? std::atoi(argv[3]) : SEQ_LENGTH;
+    const std::string dtype = argc > 4 ? argv[4] : "float";
+    const std::string engine = argc > 5 ? argv[5] : "packed";
+    const std::string weights_name = argc > 6 ? argv[6] : "";
+    const std::string activation_name = argc > 7 ? argv[7] : "";
+
+    if (!is_engine(engine)) {
+        std::cerr << "Error: Unknown engine '" << engine << "'." << std::endl;
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (dtype != "float" && dtype != "double") {
+        std::cerr << "Error: Unknown data type '" << dtype << "'." << std::endl;
+        print_usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    if (hidden_size < INPUT_SIZE || seq_length <= 0) {
+        std::cerr << "Error: Hidden size must be at least " << INPUT_SIZE << " and sequence length positive." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    SeriesStore<double> series;
+    if (!load_series(file_name, series) || series.rows() == 0) {
+        std::cerr << "Error: No data loaded!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (series.num_features() != INPUT_SIZE) {
+        std::cerr << "Error: Expected " << INPUT_SIZE << " features, got " << series.num_features() << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int prediction_days = series.prediction_days;
+
+    // The series is z-scored in place; statistics are kept for denormalizing
+    // and for a live process to resume from
+    OnlineNormalizer normalizer(INPUT_SIZE);
+    normalize_series(series, normalizer);
+    normalizer.save(NORMALIZER_FILE);
+
+    if (engine != "model") {
+        std::cout << "Debug: Packed engine using " << lstm_simd_name(lstm_simd_level()) << " kernels." << std::endl;
+    }
+
+    // A weight file is loaded when present, otherwise created from the usual
+    // initialization (same draws for float and double) so later runs reuse it
+    WeightFile weights;
+    if (!weights_name.empty()) {
+        if (!std::ifstream(weights_name).good()) {
+            LstmModelRuntime<double> model(INPUT_SIZE, hidden_size, seq_length);
+            model.initialize_weights_and_biases();
+            if (!save_lstm_weights(weights_name, pack_lstm_weights(model))) {
+                return EXIT_FAILURE;
+            }
+            std::cout << "Debug: Initialized weights saved to '" << weights_name << "'." << std::endl;
+        }
+        if (!weights.open(weights_name) || !check_lstm_weight_file(weights, INPUT_SIZE, 0)) {
+            return EXIT_FAILURE;
+        }
+        hidden_size = weights.header().hidden_size;
+    }
+    const WeightFile *model_weights = weights.is_open() ? &weights : nullptr;
+
+    // Activation tier: the argument, else the one recorded in the weight file
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (model_weights && !weight_file_activation(weights.header(), activation)) {
+        return EXIT_FAILURE;
+    }
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (engine == "model" && activation != LSTM_ACT_LIBM) {
+        std::cout << "Debug: The model engine always uses libm activations." << std::endl;
+    } else {
+        std::cout << "Debug: Using " << lstm_activation_name(activation) << " activations." << std::endl;
+    }
+
+    std::ofstream output_file("out.dat");
+    const bool ok = dtype == "double"
+        ? run_model<double>(engine, model_weights, activation, hidden_size, seq_length, series,
+                            prediction_days, normalizer, output_file)
+        : run_model<float>(engine, model_weights, activation, hidden_size, seq_length, series,
+                           prediction_days, normalizer, output_file);
+    output_file.close();
+    if (!ok) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Debug: Results written to 'out.dat'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
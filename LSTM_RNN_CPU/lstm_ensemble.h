@@ -0,0 +1,167 @@
+#ifndef LSTM_ENSEMBLE_H
+#define LSTM_ENSEMBLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "lstm_batch.h"
+#include "thread_pool.h"
+
+// Monte Carlo ensemble of autoregressive rollouts. Each path is a testbench
+// rollout: every day lstm_sequence runs over its window with h/c carried over,
+// and the prediction becomes the window's next row. Each path adds its own
+// Gaussian innovation to that prediction (noise, in normalized units) before
+// recording it and feeding it back, and can jitter its carried h/c each day
+// (state_noise). Paths are the batch columns of lstm_sequence_batch, in chunks
+// of max_batch spread over the pool. Memory is O(paths) for the current day
+// only, and the caller reduces each day's samples to quantiles before the next.
+//
+// The draws are a counter-based hash of (seed, path, day, index), so a path's
+// noise does not depend on the thread count or the chunking. With both noise
+// terms 0 every path is the deterministic rollout.
+
+struct LstmEnsembleConfig {
+    int paths;
+    int seq_length;
+    int max_batch;        // paths per GEMM
+    double noise;         // innovation std dev added to each predicted feature
+    double state_noise;   // std dev added to h and c before each day
+    uint64_t seed;
+
+    LstmEnsembleConfig()
+        : paths(1000), seq_length(60), max_batch(64), noise(0.1), state_noise(0.0), seed(1) {}
+};
+
+inline uint64_t ensemble_mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+// Standard normal draw number index of a path (Box-Muller on two hashed uniforms)
+inline double ensemble_normal(uint64_t seed, uint64_t path, uint64_t index) {
+    const uint64_t a = ensemble_mix(seed ^ ensemble_mix(path ^ ensemble_mix(index)));
+    const uint64_t b = ensemble_mix(a);
+    const double u1 = ((a >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+    const double u2 = (b >> 11) * (1.0 / 9007199254740992.0);
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(6.283185307179586 * u2);
+}
+
+template <typename T>
+class LstmEnsemble {
+public:
+    LstmEnsemble(const PackedLstmWeights<T> &weights, const LstmEnsembleConfig &config, ThreadPool &pool)
+        : weights_(weights), config_(config), pool_(pool), day_(0),
+          x_seq_((size_t)config.paths * config.seq_length * weights.input_size),
+          h_((size_t)config.paths * weights.hidden_size), c_((size_t)config.paths * weights.hidden_size),
+          samples_((size_t)config.paths * weights.input_size) {
+        for (int w = 0; w < pool.size(); w++) {
+            ws_.emplace_back(new LstmBatchWorkspace<T>(weights, config.max_batch));
+        }
+    }
+
+    int paths() const { return config_.paths; }
+    int day() const { return day_; }
+
+    // Start every path from the same normalized [seq_length][input_size] window and zero state
+    void reset(const T *window) {
+        const size_t window_size = (size_t)config_.seq_length * weights_.input_size;
+        for (int p = 0; p < config_.paths; p++) {
+            std::copy(window, window + window_size, x_seq_.begin() + p * window_size);
+        }
+        std::fill(h_.begin(), h_.end(), T(0));
+        std::fill(c_.begin(), c_.end(), T(0));
+        day_ = 0;
+    }
+
+    // Advance every path one day; returns the day's samples, [paths][input_size]
+    const T *step() {
+        const int chunk = config_.max_batch;
+        const long chunks = (config_.paths + chunk - 1) / chunk;
+        parallel_for(pool_, 0, chunks, 1, [&](int worker, long lo, long hi) {
+            for (long k = lo; k < hi; k++) {
+                const int base = k * chunk;
+                const int n = std::min(chunk, config_.paths - base);
+                advance(*ws_[worker], base, n);
+            }
+        });
+        day_++;
+        return samples_.data();
+    }
+
+private:
+    void advance(LstmBatchWorkspace<T> &ws, int base, int n) {
+        const int in = weights_.input_size, hid = weights_.hidden_size, seq = config_.seq_length;
+        const uint64_t draws = in + 2 * hid;   // per path and day
+        T *xs = &x_seq_[(size_t)base * seq * in];
+        T *hs = &h_[(size_t)base * hid];
+        T *cs = &c_[(size_t)base * hid];
+        T *out = &samples_[(size_t)base * in];
+
+        if (config_.state_noise > 0.0) {
+            for (int b = 0; b < n; b++) {
+                const uint64_t first = day_ * draws + in;
+                for (int j = 0; j < hid; j++) {
+                    hs[b * hid + j] += T(config_.state_noise * ensemble_normal(config_.seed, base + b, first + j));
+                    cs[b * hid + j] += T(config_.state_noise * ensemble_normal(config_.seed, base + b, first + hid + j));
+                }
+            }
+        }
+
+        lstm_sequence_batch(weights_, ws, xs, seq, hs, cs, out, n);
+
+        for (int b = 0; b < n; b++) {
+            T *sample = out + b * in;
+            if (config_.noise > 0.0) {
+                for (int f = 0; f < in; f++) {
+                    sample[f] += T(config_.noise * ensemble_normal(config_.seed, base + b, day_ * draws + f));
+                }
+            }
+
+            // Shift the window and append the sample for the next day
+            T *window = xs + (size_t)b * seq * in;
+            std::copy(window + in, window + (size_t)seq * in, window);
+            std::copy(sample, sample + in, window + (size_t)(seq - 1) * in);
+        }
+    }
+
+    const PackedLstmWeights<T> &weights_;
+    const LstmEnsembleConfig config_;
+    ThreadPool &pool_;
+    int day_;
+    std::vector<T> x_seq_, h_, c_, samples_;
+    std::vector<std::unique_ptr<LstmBatchWorkspace<T>>> ws_;   // one per pool worker
+};
+
+// Mean and quantiles of one feature of a day's samples. Quantiles use linear
+// interpolation between order statistics, so scratch is reordered in place.
+template <typename T>
+void lstm_ensemble_summary(const T *samples, int paths, int input_size, int feature, const std::vector<double> &qs,
+                           std::vector<T> &scratch, double &mean, std::vector<double> &quantiles) {
+    scratch.resize(paths);
+    double sum = 0.0;
+    for (int p = 0; p < paths; p++) {
+        scratch[p] = samples[(size_t)p * input_size + feature];
+        sum += scratch[p];
+    }
+    mean = sum / paths;
+
+    quantiles.resize(qs.size());
+    for (size_t i = 0; i < qs.size(); i++) {
+        const double rank = qs[i] * (paths - 1);
+        const int lo = (int)rank;
+        std::nth_element(scratch.begin(), scratch.begin() + lo, scratch.end());
+        double value = scratch[lo];
+        if (lo + 1 < paths && rank > lo) {
+            // The next order statistic is the minimum of the upper partition
+            const double next = *std::min_element(scratch.begin() + lo + 1, scratch.end());
+            value += (rank - lo) * (next - value);
+        }
+        quantiles[i] = value;
+    }
+}
+
+#endif // LSTM_ENSEMBLE_H
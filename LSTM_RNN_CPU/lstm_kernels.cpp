@@ -0,0 +1,773 @@
+#include "lstm_kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <immintrin.h>
+
+// Aligned allocation
+void *lstm_aligned_alloc(size_t bytes) {
+    size_t rounded = (bytes + LSTM_ALIGN - 1) / LSTM_ALIGN * LSTM_ALIGN;
+    void *ptr = std::aligned_alloc(LSTM_ALIGN, rounded ? rounded : LSTM_ALIGN);
+    if (ptr) {
+        std::memset(ptr, 0, rounded ? rounded : LSTM_ALIGN);
+    }
+    return ptr;
+}
+
+void lstm_aligned_free(void *ptr) {
+    std::free(ptr);
+}
+
+// CPU feature detection
+static LstmSimdLevel detect_simd_level() {
+    LstmSimdLevel level = LSTM_SIMD_SCALAR;
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        level = LSTM_SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        level = LSTM_SIMD_AVX512;
+    }
+
+    const char *cap = std::getenv("LSTM_SIMD");
+    if (cap) {
+        if (std::strcmp(cap, "scalar") == 0) {
+            level = LSTM_SIMD_SCALAR;
+        } else if (std::strcmp(cap, "avx2") == 0 && level > LSTM_SIMD_AVX2) {
+            level = LSTM_SIMD_AVX2;
+        }
+    }
+    return level;
+}
+
+LstmSimdLevel lstm_simd_level() {
+    static const LstmSimdLevel level = detect_simd_level();
+    return level;
+}
+
+bool lstm_simd_vnni() {
+    static const bool vnni = lstm_simd_level() == LSTM_SIMD_AVX512 && __builtin_cpu_supports("avx512vnni") &&
+                             __builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl");
+    return vnni;
+}
+
+const char *lstm_simd_name(LstmSimdLevel level) {
+    switch (level) {
+    case LSTM_SIMD_AVX512: return "avx512";
+    case LSTM_SIMD_AVX2: return "avx2";
+    default: return "scalar";
+    }
+}
+
+// Scalar kernels
+template <typename T>
+static void gemv_scalar(const T *W, const T *bias, const T *v, T *y, int rows, int ld, int cols) {
+    for (int r = 0; r < rows; r++) {
+        const T *w = W + (size_t)r * ld;
+        T sum = 0;
+        for (int k = 0; k < cols; k++) {
+            sum += w[k] * v[k];
+        }
+        y[r] = bias[r] + sum;
+    }
+}
+
+// AVX2 kernels, four rows (one hidden unit's gates) per pass. Every AVX kernel
+// ends with vzeroupper: GCC does not always emit it under target attributes, and
+// dirty upper state makes the SSE libm calls in the pointwise stage ~40x slower.
+__attribute__((target("avx2,fma")))
+static inline __m128 hsum4_ps(__m256 acc0, __m256 acc1, __m256 acc2, __m256 acc3) {
+    __m256 t0 = _mm256_hadd_ps(acc0, acc1);
+    __m256 t1 = _mm256_hadd_ps(acc2, acc3);
+    __m256 t2 = _mm256_hadd_ps(t0, t1);
+    return _mm_add_ps(_mm256_castps256_ps128(t2), _mm256_extractf128_ps(t2, 1));
+}
+
+__attribute__((target("avx2,fma")))
+static inline __m256d hsum4_pd(__m256d acc0, __m256d acc1, __m256d acc2, __m256d acc3) {
+    __m256d t0 = _mm256_hadd_pd(acc0, acc1);
+    __m256d t1 = _mm256_hadd_pd(acc2, acc3);
+    return _mm256_add_pd(_mm256_permute2f128_pd(t0, t1, 0x20), _mm256_permute2f128_pd(t0, t1, 0x31));
+}
+
+__attribute__((target("avx2,fma")))
+static void gemv_avx2_f32(const float *W, const float *bias, const float *v, float *y, int rows, int ld, int cols) {
+    for (int r = 0; r < rows; r += 4) {
+        const float *w0 = W + (size_t)r * ld;
+        const float *w1 = w0 + ld;
+        const float *w2 = w1 + ld;
+        const float *w3 = w2 + ld;
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+
+        for (int k = 0; k < cols; k += 8) {
+            __m256 vk = _mm256_load_ps(v + k);
+            acc0 = _mm256_fmadd_ps(_mm256_load_ps(w0 + k), vk, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_load_ps(w1 + k), vk, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_load_ps(w2 + k), vk, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_load_ps(w3 + k), vk, acc3);
+        }
+
+        __m128 sum = hsum4_ps(acc0, acc1, acc2, acc3);
+        _mm_storeu_ps(y + r, _mm_add_ps(sum, _mm_loadu_ps(bias + r)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx2,fma")))
+static void gemv_avx2_f64(const double *W, const double *bias, const double *v, double *y, int rows, int ld, int cols) {
+    for (int r = 0; r < rows; r += 4) {
+        const double *w0 = W + (size_t)r * ld;
+        const double *w1 = w0 + ld;
+        const double *w2 = w1 + ld;
+        const double *w3 = w2 + ld;
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+
+        for (int k = 0; k < cols; k += 4) {
+            __m256d vk = _mm256_load_pd(v + k);
+            acc0 = _mm256_fmadd_pd(_mm256_load_pd(w0 + k), vk, acc0);
+            acc1 = _mm256_fmadd_pd(_mm256_load_pd(w1 + k), vk, acc1);
+            acc2 = _mm256_fmadd_pd(_mm256_load_pd(w2 + k), vk, acc2);
+            acc3 = _mm256_fmadd_pd(_mm256_load_pd(w3 + k), vk, acc3);
+        }
+
+        _mm256_storeu_pd(y + r, _mm256_add_pd(hsum4_pd(acc0, acc1, acc2, acc3), _mm256_loadu_pd(bias + r)));
+    }
+    _mm256_zeroupper();
+}
+
+// AVX-512 kernels, accumulators folded to 256 bits and reduced as in AVX2.
+// The zero-masked extracts avoid GCC's undefined-register warning in the unmasked forms.
+__attribute__((target("avx512f")))
+static inline __m256d fold512_pd(__m512d v) {
+    return _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, v, 0), _mm512_maskz_extractf64x4_pd(0xF, v, 1));
+}
+
+__attribute__((target("avx512f")))
+static inline __m256 fold512_ps(__m512 v) {
+    __m512d d = _mm512_castps_pd(v);
+    return _mm256_add_ps(_mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d, 0)),
+                         _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d, 1)));
+}
+
+__attribute__((target("avx512f")))
+static void gemv_avx512_f32(const float *W, const float *bias, const float *v, float *y, int rows, int ld, int cols) {
+    for (int r = 0; r < rows; r += 4) {
+        const float *w0 = W + (size_t)r * ld;
+        const float *w1 = w0 + ld;
+        const float *w2 = w1 + ld;
+        const float *w3 = w2 + ld;
+        __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+        __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+
+        for (int k = 0; k < cols; k += 16) {
+            __m512 vk = _mm512_load_ps(v + k);
+            acc0 = _mm512_fmadd_ps(_mm512_load_ps(w0 + k), vk, acc0);
+            acc1 = _mm512_fmadd_ps(_mm512_load_ps(w1 + k), vk, acc1);
+            acc2 = _mm512_fmadd_ps(_mm512_load_ps(w2 + k), vk, acc2);
+            acc3 = _mm512_fmadd_ps(_mm512_load_ps(w3 + k), vk, acc3);
+        }
+
+        __m128 sum = hsum4_ps(fold512_ps(acc0), fold512_ps(acc1), fold512_ps(acc2), fold512_ps(acc3));
+        _mm_storeu_ps(y + r, _mm_add_ps(sum, _mm_loadu_ps(bias + r)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static void gemv_avx512_f64(const double *W, const double *bias, const double *v, double *y, int rows, int ld, int cols) {
+    for (int r = 0; r < rows; r += 4) {
+        const double *w0 = W + (size_t)r * ld;
+        const double *w1 = w0 + ld;
+        const double *w2 = w1 + ld;
+        const double *w3 = w2 + ld;
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+
+        for (int k = 0; k < cols; k += 8) {
+            __m512d vk = _mm512_load_pd(v + k);
+            acc0 = _mm512_fmadd_pd(_mm512_load_pd(w0 + k), vk, acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_load_pd(w1 + k), vk, acc1);
+            acc2 = _mm512_fmadd_pd(_mm512_load_pd(w2 + k), vk, acc2);
+            acc3 = _mm512_fmadd_pd(_mm512_load_pd(w3 + k), vk, acc3);
+        }
+
+        __m256d sum = hsum4_pd(fold512_pd(acc0), fold512_pd(acc1), fold512_pd(acc2), fold512_pd(acc3));
+        _mm256_storeu_pd(y + r, _mm256_add_pd(sum, _mm256_loadu_pd(bias + r)));
+    }
+    _mm256_zeroupper();
+}
+
+// GEMM kernels: Y[b * ldy + r] = bias[r] + W[r][0..cols) . V[b * ldv] for b in [0, batch).
+// Each 4-row weight group is loaded once per k and applied to several batch
+// columns at a time, so weight traffic is shared across the batch.
+template <typename T>
+static void gemm_scalar(const T *W, const T *bias, const T *V, int ldv, T *Y, int ldy,
+                        int rows, int ld, int cols, int batch) {
+    for (int b = 0; b < batch; b++) {
+        gemv_scalar<T>(W, bias, V + (size_t)b * ldv, Y + (size_t)b * ldy, rows, ld, cols);
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void gemm_avx2_f32(const float *W, const float *bias, const float *V, int ldv, float *Y, int ldy,
+                          int rows, int ld, int cols, int batch) {
+    for (int r = 0; r < rows; r += 4) {
+        const float *w0 = W + (size_t)r * ld;
+        const float *w1 = w0 + ld;
+        const float *w2 = w1 + ld;
+        const float *w3 = w2 + ld;
+        const __m128 bias4 = _mm_loadu_ps(bias + r);
+
+        int b = 0;
+        for (; b + 2 <= batch; b += 2) {
+            const float *v0 = V + (size_t)b * ldv;
+            const float *v1 = v0 + ldv;
+            __m256 a00 = _mm256_setzero_ps(), a10 = _mm256_setzero_ps();
+            __m256 a20 = _mm256_setzero_ps(), a30 = _mm256_setzero_ps();
+            __m256 a01 = _mm256_setzero_ps(), a11 = _mm256_setzero_ps();
+            __m256 a21 = _mm256_setzero_ps(), a31 = _mm256_setzero_ps();
+
+            for (int k = 0; k < cols; k += 8) {
+                __m256 x0 = _mm256_load_ps(v0 + k);
+                __m256 x1 = _mm256_load_ps(v1 + k);
+                __m256 wk = _mm256_load_ps(w0 + k);
+                a00 = _mm256_fmadd_ps(wk, x0, a00);
+                a01 = _mm256_fmadd_ps(wk, x1, a01);
+                wk = _mm256_load_ps(w1 + k);
+                a10 = _mm256_fmadd_ps(wk, x0, a10);
+                a11 = _mm256_fmadd_ps(wk, x1, a11);
+                wk = _mm256_load_ps(w2 + k);
+                a20 = _mm256_fmadd_ps(wk, x0, a20);
+                a21 = _mm256_fmadd_ps(wk, x1, a21);
+                wk = _mm256_load_ps(w3 + k);
+                a30 = _mm256_fmadd_ps(wk, x0, a30);
+                a31 = _mm256_fmadd_ps(wk, x1, a31);
+            }
+
+            _mm_storeu_ps(Y + (size_t)b * ldy + r, _mm_add_ps(hsum4_ps(a00, a10, a20, a30), bias4));
+            _mm_storeu_ps(Y + (size_t)(b + 1) * ldy + r, _mm_add_ps(hsum4_ps(a01, a11, a21, a31), bias4));
+        }
+        for (; b < batch; b++) {
+            gemv_avx2_f32(w0, bias + r, V + (size_t)b * ldv, Y + (size_t)b * ldy + r, 4, ld, cols);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static void gemm_avx512_f32(const float *W, const float *bias, const float *V, int ldv, float *Y, int ldy,
+                            int rows, int ld, int cols, int batch) {
+    for (int r = 0; r < rows; r += 4) {
+        const float *w0 = W + (size_t)r * ld;
+        const float *w1 = w0 + ld;
+        const float *w2 = w1 + ld;
+        const float *w3 = w2 + ld;
+        const __m128 bias4 = _mm_loadu_ps(bias + r);
+
+        int b = 0;
+        for (; b + 4 <= batch; b += 4) {
+            const float *v[4];
+            __m512 acc[4][4];
+            for (int j = 0; j < 4; j++) {
+                v[j] = V + (size_t)(b + j) * ldv;
+                for (int g = 0; g < 4; g++) {
+                    acc[g][j] = _mm512_setzero_ps();
+                }
+            }
+
+            for (int k = 0; k < cols; k += 16) {
+                __m512 x0 = _mm512_load_ps(v[0] + k);
+                __m512 x1 = _mm512_load_ps(v[1] + k);
+                __m512 x2 = _mm512_load_ps(v[2] + k);
+                __m512 x3 = _mm512_load_ps(v[3] + k);
+                const float *wg[4] = {w0, w1, w2, w3};
+                for (int g = 0; g < 4; g++) {
+                    __m512 wk = _mm512_load_ps(wg[g] + k);
+                    acc[g][0] = _mm512_fmadd_ps(wk, x0, acc[g][0]);
+                    acc[g][1] = _mm512_fmadd_ps(wk, x1, acc[g][1]);
+                    acc[g][2] = _mm512_fmadd_ps(wk, x2, acc[g][2]);
+                    acc[g][3] = _mm512_fmadd_ps(wk, x3, acc[g][3]);
+                }
+            }
+
+            for (int j = 0; j < 4; j++) {
+                __m128 sum = hsum4_ps(fold512_ps(acc[0][j]), fold512_ps(acc[1][j]),
+                                      fold512_ps(acc[2][j]), fold512_ps(acc[3][j]));
+                _mm_storeu_ps(Y + (size_t)(b + j) * ldy + r, _mm_add_ps(sum, bias4));
+            }
+        }
+        for (; b < batch; b++) {
+            gemv_avx512_f32(w0, bias + r, V + (size_t)b * ldv, Y + (size_t)b * ldy + r, 4, ld, cols);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+// Double precision: 4 rows by 2 batch columns on AVX2 and 4 by 4 on AVX-512,
+// reduced exactly as the f64 GEMV kernels so a batch matches per-column calls
+__attribute__((target("avx2,fma")))
+static void gemm_avx2_f64(const double *W, const double *bias, const double *V, int ldv, double *Y, int ldy,
+                          int rows, int ld, int cols, int batch) {
+    for (int r = 0; r < rows; r += 4) {
+        const double *w0 = W + (size_t)r * ld;
+        const double *w1 = w0 + ld;
+        const double *w2 = w1 + ld;
+        const double *w3 = w2 + ld;
+        const __m256d bias4 = _mm256_loadu_pd(bias + r);
+
+        int b = 0;
+        for (; b + 2 <= batch; b += 2) {
+            const double *v0 = V + (size_t)b * ldv;
+            const double *v1 = v0 + ldv;
+            __m256d a00 = _mm256_setzero_pd(), a10 = _mm256_setzero_pd();
+            __m256d a20 = _mm256_setzero_pd(), a30 = _mm256_setzero_pd();
+            __m256d a01 = _mm256_setzero_pd(), a11 = _mm256_setzero_pd();
+            __m256d a21 = _mm256_setzero_pd(), a31 = _mm256_setzero_pd();
+
+            for (int k = 0; k < cols; k += 4) {
+                __m256d x0 = _mm256_load_pd(v0 + k);
+                __m256d x1 = _mm256_load_pd(v1 + k);
+                __m256d wk = _mm256_load_pd(w0 + k);
+                a00 = _mm256_fmadd_pd(wk, x0, a00);
+                a01 = _mm256_fmadd_pd(wk, x1, a01);
+                wk = _mm256_load_pd(w1 + k);
+                a10 = _mm256_fmadd_pd(wk, x0, a10);
+                a11 = _mm256_fmadd_pd(wk, x1, a11);
+                wk = _mm256_load_pd(w2 + k);
+                a20 = _mm256_fmadd_pd(wk, x0, a20);
+                a21 = _mm256_fmadd_pd(wk, x1, a21);
+                wk = _mm256_load_pd(w3 + k);
+                a30 = _mm256_fmadd_pd(wk, x0, a30);
+                a31 = _mm256_fmadd_pd(wk, x1, a31);
+            }
+
+            _mm256_storeu_pd(Y + (size_t)b * ldy + r, _mm256_add_pd(hsum4_pd(a00, a10, a20, a30), bias4));
+            _mm256_storeu_pd(Y + (size_t)(b + 1) * ldy + r, _mm256_add_pd(hsum4_pd(a01, a11, a21, a31), bias4));
+        }
+        for (; b < batch; b++) {
+            gemv_avx2_f64(w0, bias + r, V + (size_t)b * ldv, Y + (size_t)b * ldy + r, 4, ld, cols);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static void gemm_avx512_f64(const double *W, const double *bias, const double *V, int ldv, double *Y, int ldy,
+                            int rows, int ld, int cols, int batch) {
+    for (int r = 0; r < rows; r += 4) {
+        const double *w0 = W + (size_t)r * ld;
+        const double *w1 = w0 + ld;
+        const double *w2 = w1 + ld;
+        const double *w3 = w2 + ld;
+        const __m256d bias4 = _mm256_loadu_pd(bias + r);
+
+        int b = 0;
+        for (; b + 4 <= batch; b += 4) {
+            const double *v[4];
+            __m512d acc[4][4];
+            for (int j = 0; j < 4; j++) {
+                v[j] = V + (size_t)(b + j) * ldv;
+                for (int g = 0; g < 4; g++) {
+                    acc[g][j] = _mm512_setzero_pd();
+                }
+            }
+
+            for (int k = 0; k < cols; k += 8) {
+                __m512d x0 = _mm512_load_pd(v[0] + k);
+                __m512d x1 = _mm512_load_pd(v[1] + k);
+                __m512d x2 = _mm512_load_pd(v[2] + k);
+                __m512d x3 = _mm512_load_pd(v[3] + k);
+                const double *wg[4] = {w0, w1, w2, w3};
+                for (int g = 0; g < 4; g++) {
+                    __m512d wk = _mm512_load_pd(wg[g] + k);
+                    acc[g][0] = _mm512_fmadd_pd(wk, x0, acc[g][0]);
+                    acc[g][1] = _mm512_fmadd_pd(wk, x1, acc[g][1]);
+                    acc[g][2] = _mm512_fmadd_pd(wk, x2, acc[g][2]);
+                    acc[g][3] = _mm512_fmadd_pd(wk, x3, acc[g][3]);
+                }
+            }
+
+            for (int j = 0; j < 4; j++) {
+                __m256d sum = hsum4_pd(fold512_pd(acc[0][j]), fold512_pd(acc[1][j]),
+                                       fold512_pd(acc[2][j]), fold512_pd(acc[3][j]));
+                _mm256_storeu_pd(Y + (size_t)(b + j) * ldy + r, _mm256_add_pd(sum, bias4));
+            }
+        }
+        for (; b < batch; b++) {
+            gemv_avx512_f64(w0, bias + r, V + (size_t)b * ldv, Y + (size_t)b * ldy + r, 4, ld, cols);
+        }
+    }
+    _mm256_zeroupper();
+}
+
+// Dispatch
+typedef void (*gemv_f32_fn)(const float *, const float *, const float *, float *, int, int, int);
+typedef void (*gemv_f64_fn)(const double *, const double *, const double *, double *, int, int, int);
+
+static gemv_f32_fn select_gemv_f32() {
+    switch (lstm_simd_level()) {
+    case LSTM_SIMD_AVX512: return gemv_avx512_f32;
+    case LSTM_SIMD_AVX2: return gemv_avx2_f32;
+    default: return gemv_scalar<float>;
+    }
+}
+
+static gemv_f64_fn select_gemv_f64() {
+    switch (lstm_simd_level()) {
+    case LSTM_SIMD_AVX512: return gemv_avx512_f64;
+    case LSTM_SIMD_AVX2: return gemv_avx2_f64;
+    default: return gemv_scalar<double>;
+    }
+}
+
+void lstm_gemv(const float *W, const float *bias, const float *v, float *y, int rows, int ld, int cols) {
+    static const gemv_f32_fn fn = select_gemv_f32();
+    fn(W, bias, v, y, rows, ld, cols);
+}
+
+void lstm_gemv(const double *W, const double *bias, const double *v, double *y, int rows, int ld, int cols) {
+    static const gemv_f64_fn fn = select_gemv_f64();
+    fn(W, bias, v, y, rows, ld, cols);
+}
+
+typedef void (*gemm_f32_fn)(const float *, const float *, const float *, int, float *, int, int, int, int, int);
+
+static gemm_f32_fn select_gemm_f32() {
+    switch (lstm_simd_level()) {
+    case LSTM_SIMD_AVX512: return gemm_avx512_f32;
+    case LSTM_SIMD_AVX2: return gemm_avx2_f32;
+    default: return gemm_scalar<float>;
+    }
+}
+
+void lstm_gemm(const float *W, const float *bias, const float *V, int ldv, float *Y, int ldy,
+               int rows, int ld, int cols, int batch) {
+    static const gemm_f32_fn fn = select_gemm_f32();
+    fn(W, bias, V, ldv, Y, ldy, rows, ld, cols, batch);
+}
+
+typedef void (*gemm_f64_fn)(const double *, const double *, const double *, int, double *, int, int, int, int, int);
+
+static gemm_f64_fn select_gemm_f64() {
+    switch (lstm_simd_level()) {
+    case LSTM_SIMD_AVX512: return gemm_avx512_f64;
+    case LSTM_SIMD_AVX2: return gemm_avx2_f64;
+    default: return gemm_scalar<double>;
+    }
+}
+
+void lstm_gemm(const double *W, const double *bias, const double *V, int ldv, double *Y, int ldy,
+               int rows, int ld, int cols, int batch) {
+    static const gemm_f64_fn fn = select_gemm_f64();
+    fn(W, bias, V, ldv, Y, ldy, rows, ld, cols, batch);
+}
+
+// Block-sparse kernels: each group's blocks accumulate into four row
+// accumulators that reduce once per group, as in the dense GEMV. A float block
+// row is one 256-bit vector; AVX-512 takes two rows per 512-bit register
+// against the slice of v broadcast to both halves.
+template <typename T>
+static void bsr_gemv_scalar(const T *values, const int *block_col, const int *block_ptr, const T *bias, const T *v,
+                            T *y, int groups) {
+    for (int g = 0; g < groups; g++) {
+        T sum[4] = {0, 0, 0, 0};
+        for (int b = block_ptr[g]; b < block_ptr[g + 1]; b++) {
+            const T *block = values + (size_t)b * 4 * LSTM_SPARSE_BLOCK;
+            const T *vb = v + block_col[b];
+            for (int j = 0; j < 4; j++) {
+                for (int k = 0; k < LSTM_SPARSE_BLOCK; k++) {
+                    sum[j] += block[j * LSTM_SPARSE_BLOCK + k] * vb[k];
+                }
+            }
+        }
+        for (int j = 0; j < 4; j++) {
+            y[4 * g + j] = bias[4 * g + j] + sum[j];
+        }
+    }
+}
+
+__attribute__((target("avx2,fma")))
+static void bsr_gemv_avx2_f32(const float *values, const int *block_col, const int *block_ptr, const float *bias,
+                              const float *v, float *y, int groups) {
+    for (int g = 0; g < groups; g++) {
+        __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+        for (int b = block_ptr[g]; b < block_ptr[g + 1]; b++) {
+            const float *block = values + (size_t)b * 4 * LSTM_SPARSE_BLOCK;
+            __m256 vb = _mm256_load_ps(v + block_col[b]);
+            acc0 = _mm256_fmadd_ps(_mm256_load_ps(block), vb, acc0);
+            acc1 = _mm256_fmadd_ps(_mm256_load_ps(block + 8), vb, acc1);
+            acc2 = _mm256_fmadd_ps(_mm256_load_ps(block + 16), vb, acc2);
+            acc3 = _mm256_fmadd_ps(_mm256_load_ps(block + 24), vb, acc3);
+        }
+        __m128 sum = hsum4_ps(acc0, acc1, acc2, acc3);
+        _mm_storeu_ps(y + 4 * g, _mm_add_ps(sum, _mm_loadu_ps(bias + 4 * g)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx2,fma")))
+static void bsr_gemv_avx2_f64(const double *values, const int *block_col, const int *block_ptr, const double *bias,
+                              const double *v, double *y, int groups) {
+    for (int g = 0; g < groups; g++) {
+        __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+        __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+        for (int b = block_ptr[g]; b < block_ptr[g + 1]; b++) {
+            const double *block = values + (size_t)b * 4 * LSTM_SPARSE_BLOCK;
+            const double *vb = v + block_col[b];
+            __m256d lo = _mm256_load_pd(vb), hi = _mm256_load_pd(vb + 4);
+            acc0 = _mm256_fmadd_pd(_mm256_load_pd(block + 4), hi, _mm256_fmadd_pd(_mm256_load_pd(block), lo, acc0));
+            acc1 = _mm256_fmadd_pd(_mm256_load_pd(block + 12), hi, _mm256_fmadd_pd(_mm256_load_pd(block + 8), lo, acc1));
+            acc2 = _mm256_fmadd_pd(_mm256_load_pd(block + 20), hi, _mm256_fmadd_pd(_mm256_load_pd(block + 16), lo, acc2));
+            acc3 = _mm256_fmadd_pd(_mm256_load_pd(block + 28), hi, _mm256_fmadd_pd(_mm256_load_pd(block + 24), lo, acc3));
+        }
+        _mm256_storeu_pd(y + 4 * g, _mm256_add_pd(hsum4_pd(acc0, acc1, acc2, acc3), _mm256_loadu_pd(bias + 4 * g)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static void bsr_gemv_avx512_f32(const float *values, const int *block_col, const int *block_ptr, const float *bias,
+                                const float *v, float *y, int groups) {
+    for (int g = 0; g < groups; g++) {
+        __m512 acc01 = _mm512_setzero_ps(), acc23 = _mm512_setzero_ps();
+        for (int b = block_ptr[g]; b < block_ptr[g + 1]; b++) {
+            const float *block = values + (size_t)b * 4 * LSTM_SPARSE_BLOCK;
+            __m512 vb = _mm512_castpd_ps(_mm512_maskz_broadcast_f64x4(0xFF, _mm256_castps_pd(_mm256_load_ps(v + block_col[b]))));
+            acc01 = _mm512_fmadd_ps(_mm512_load_ps(block), vb, acc01);
+            acc23 = _mm512_fmadd_ps(_mm512_load_ps(block + 16), vb, acc23);
+        }
+        __m512d d01 = _mm512_castps_pd(acc01), d23 = _mm512_castps_pd(acc23);
+        __m128 sum = hsum4_ps(_mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d01, 0)),
+                              _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d01, 1)),
+                              _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d23, 0)),
+                              _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, d23, 1)));
+        _mm_storeu_ps(y + 4 * g, _mm_add_ps(sum, _mm_loadu_ps(bias + 4 * g)));
+    }
+    _mm256_zeroupper();
+}
+
+__attribute__((target("avx512f")))
+static void bsr_gemv_avx512_f64(const double *values, const int *block_col, const int *block_ptr, const double *bias,
+                                const double *v, double *y, int groups) {
+    for (int g = 0; g < groups; g++) {
+        __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+        __m512d acc2 = _mm512_setzero_pd(), acc3 = _mm512_setzero_pd();
+        for (int b = block_ptr[g]; b < block_ptr[g + 1]; b++) {
+            const double *block = values + (size_t)b * 4 * LSTM_SPARSE_BLOCK;
+            __m512d vb = _mm512_load_pd(v + block_col[b]);
+            acc0 = _mm512_fmadd_pd(_mm512_load_pd(block), vb, acc0);
+            acc1 = _mm512_fmadd_pd(_mm512_load_pd(block + 8), vb, acc1);
+            acc2 = _mm512_fmadd_pd(_mm512_load_pd(block + 16), vb, acc2);
+            acc3 = _mm512_fmadd_pd(_mm512_load_pd(block + 24), vb, acc3);
+        }
+        __m256d sum = hsum4_pd(fold512_pd(acc0), fold512_pd(acc1), fold512_pd(acc2), fold512_pd(acc3));
+        _mm256_storeu_pd(y + 4 * g, _mm256_add_pd(sum, _mm256_loadu_pd(bias + 4 * g)));
+    }
+    _mm256_zeroupper();
+}
+
+typedef void (*bsr_gemv_f32_fn)(const float *, const int *, const int *, const float *, const float *, float *, int);
+typedef void (*bsr_gemv_f64_fn)(const double *, const int *, const int *, const double *, const double *, double *,
+                                int);
+
+static bsr_gemv_f32_fn select_bsr_gemv_f32() {
+    switch (lstm_simd_level()) {
+    case LSTM_SIMD_AVX512: return bsr_gemv_avx512_f32;
+    case LSTM_SIMD_AVX2: return bsr_gemv_avx2_f32;
+    default: return bsr_gemv_scalar<float>;
+    }
+}
+
+static bsr_gemv_f64_fn select_bsr_gemv_f64() {
+    switch (lstm_simd_level()) {
+    case LSTM_SIMD_AVX512: return bsr_gemv_avx512_f64;
+    case LSTM_SIMD_AVX2: return bsr_gemv_avx2_f64;
+    default: return bsr_gemv_scalar<double>;
+    }
+}
+
+void lstm_bsr_gemv(const float *values, const int *block_col, const int *block_ptr, const float *bias,
+                   const float *v, float *y, int groups) {
+    static const bsr_gemv_f32_fn fn = select_bsr_gemv_f32();
+    fn(values, block_col, block_ptr, bias, v, y, groups);
+}
+
+void lstm_bsr_gemv(const double *values, const int *block_col, const int *block_ptr, const double *bias,
+                   const double *v, double *y, int groups) {
+    static const bsr_gemv_f64_fn fn = select_bsr_gemv_f64();
+    fn(values, block_col, block_ptr, bias, v, y, groups);
+}
+
+// Integer kernels, four rows per pass with a scalar tail. Quantized rows are
+// only LSTM_QUANT_ALIGN aligned, so every load is unaligned; segments are short
+// (16 bytes for 5 inputs or 16 int8 hidden units), so the vector kernels work
+// on 256 bits and the VNNI ones mask the last partial vector.
+template <typename Q>
+static void qgemv_scalar(const Q *W, const int32_t *, const Q *v, int32_t *y, int rows, int ld, int cols) {
+    for (int r = 0; r < rows; r++) {
+        const Q *w = W + (size_t)r * ld;
+        int32_t sum = 0;
+        for (int k = 0; k < cols; k++) {
+            sum += int32_t(w[k]) * int32_t(v[k]);
+        }
+        y[r] = sum;
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m128i hsum4_epi32(__m256i acc0, __m256i acc1, __m256i acc2, __m256i acc3) {
+    __m256i t0 = _mm256_hadd_epi32(acc0, acc1);
+    __m256i t1 = _mm256_hadd_epi32(acc2, acc3);
+    __m256i t2 = _mm256_hadd_epi32(t0, t1);
+    return _mm_add_epi32(_mm256_castsi256_si128(t2), _mm256_extracti128_si256(t2, 1));
+}
+
+// AVX2: int8 is widened to int16 and both types go through pmaddwd
+__attribute__((target("avx2")))
+static inline __m256i load_s8_as_s16(const int8_t *p) {
+    return _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+__attribute__((target("avx2")))
+static void qgemv_avx2_s8(const int8_t *W, const int32_t *w_sums, const int8_t *v, int32_t *y, int rows, int ld,
+                          int cols) {
+    int r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const int8_t *w0 = W + (size_t)r * ld;
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+        for (int k = 0; k < cols; k += 16) {
+            __m256i vk = load_s8_as_s16(v + k);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(load_s8_as_s16(w0 + k), vk));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(load_s8_as_s16(w0 + ld + k), vk));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(load_s8_as_s16(w0 + 2 * ld + k), vk));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(load_s8_as_s16(w0 + 3 * ld + k), vk));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y + r), hsum4_epi32(acc0, acc1, acc2, acc3));
+    }
+    _mm256_zeroupper();
+    qgemv_scalar<int8_t>(W + (size_t)r * ld, w_sums, v, y + r, rows - r, ld, cols);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i load_s16(const int16_t *p, int remaining) {
+    return remaining >= 16 ? _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p))
+                           : _mm256_zextsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+__attribute__((target("avx2")))
+static void qgemv_avx2_s16(const int16_t *W, const int32_t *w_sums, const int16_t *v, int32_t *y, int rows, int ld,
+                           int cols) {
+    int r = 0;
+    for (; r + 4 <= rows; r += 4) {
+        const int16_t *w0 = W + (size_t)r * ld;
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+        for (int k = 0; k < cols; k += 16) {
+            __m256i vk = load_s16(v + k, cols - k);
+            acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(load_s16(w0 + k, cols - k), vk));
+            acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(load_s16(w0 + ld + k, cols - k), vk));
+            acc2 = _mm256_add_epi32(acc2, _mm256_madd_epi16(load_s16(w0 + 2 * ld + k, cols - k), vk));
+            acc3 = _mm256_add_epi32(acc3, _mm256_madd_epi16(load_s16(w0 + 3 * ld + k, cols - k), vk));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(y + r), hsum4_epi32(acc0, acc1, acc2, acc3));
+    }
+    _mm256_zeroupper();
+    qgemv_scalar<int16_t>(W + (size_t)r * ld, w_sums, v, y + r, rows - r, ld, cols);
+}
+
+// AVX-512 VNNI, eight rows per pass: every 16-byte column step of two rows
+// shares one 256-bit register (row r low, row r+1 high) against the activation
+// step broadcast to both halves, so eight rows reduce with one hadd tree.
+// vpdpbusd multiplies unsigned by signed bytes, so the int8 activations are
+// biased by 128 (xor of the sign bit) and 128 * w_sums[r] is subtracted per
+// row; vpdpwssd takes int16 pairs as they are.
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+static inline __m256i load_row_pair(const void *lo, const void *hi) {
+    return _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(static_cast<const __m128i *>(lo))),
+                                   _mm_loadu_si128(static_cast<const __m128i *>(hi)), 1);
+}
+
+// Eight row sums from four row-pair accumulators, in row order
+__attribute__((target("avx512f,avx512bw,avx512vl")))
+static inline __m256i hsum8_pairs_epi32(__m256i acc0, __m256i acc1, __m256i acc2, __m256i acc3) {
+    __m256i t0 = _mm256_hadd_epi32(acc0, acc1);
+    __m256i t1 = _mm256_hadd_epi32(acc2, acc3);
+    __m256i t2 = _mm256_hadd_epi32(t0, t1);   // rows 0 2 4 6 | 1 3 5 7
+    return _mm256_permutevar8x32_epi32(t2, _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7));
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512vnni")))
+static void qgemv_vnni_s8(const int8_t *W, const int32_t *w_sums, const int8_t *v, int32_t *y, int rows, int ld,
+                          int cols) {
+    const __m256i bias128 = _mm256_set1_epi8((char)0x80);
+    int r = 0;
+    for (; r + 8 <= rows; r += 8) {
+        const int8_t *w0 = W + (size_t)r * ld;
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+        for (int k = 0; k < cols; k += 16) {
+            __m256i vk = _mm256_xor_si256(
+                _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(v + k))), bias128);
+            acc0 = _mm256_dpbusd_epi32(acc0, vk, load_row_pair(w0 + k, w0 + ld + k));
+            acc1 = _mm256_dpbusd_epi32(acc1, vk, load_row_pair(w0 + 2 * ld + k, w0 + 3 * ld + k));
+            acc2 = _mm256_dpbusd_epi32(acc2, vk, load_row_pair(w0 + 4 * ld + k, w0 + 5 * ld + k));
+            acc3 = _mm256_dpbusd_epi32(acc3, vk, load_row_pair(w0 + 6 * ld + k, w0 + 7 * ld + k));
+        }
+        __m256i offset = _mm256_slli_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(w_sums + r)), 7);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + r),
+                            _mm256_sub_epi32(hsum8_pairs_epi32(acc0, acc1, acc2, acc3), offset));
+    }
+    _mm256_zeroupper();
+    qgemv_scalar<int8_t>(W + (size_t)r * ld, w_sums, v, y + r, rows - r, ld, cols);
+}
+
+__attribute__((target("avx512f,avx512bw,avx512vl,avx512vnni")))
+static void qgemv_vnni_s16(const int16_t *W, const int32_t *w_sums, const int16_t *v, int32_t *y, int rows, int ld,
+                           int cols) {
+    int r = 0;
+    for (; r + 8 <= rows; r += 8) {
+        const int16_t *w0 = W + (size_t)r * ld;
+        __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+        __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+        for (int k = 0; k < cols; k += 8) {
+            __m256i vk = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(v + k)));
+            acc0 = _mm256_dpwssd_epi32(acc0, load_row_pair(w0 + k, w0 + ld + k), vk);
+            acc1 = _mm256_dpwssd_epi32(acc1, load_row_pair(w0 + 2 * ld + k, w0 + 3 * ld + k), vk);
+            acc2 = _mm256_dpwssd_epi32(acc2, load_row_pair(w0 + 4 * ld + k, w0 + 5 * ld + k), vk);
+            acc3 = _mm256_dpwssd_epi32(acc3, load_row_pair(w0 + 6 * ld + k, w0 + 7 * ld + k), vk);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(y + r), hsum8_pairs_epi32(acc0, acc1, acc2, acc3));
+    }
+    _mm256_zeroupper();
+    qgemv_scalar<int16_t>(W + (size_t)r * ld, w_sums, v, y + r, rows - r, ld, cols);
+}
+
+typedef void (*qgemv_s8_fn)(const int8_t *, const int32_t *, const int8_t *, int32_t *, int, int, int);
+typedef void (*qgemv_s16_fn)(const int16_t *, const int32_t *, const int16_t *, int32_t *, int, int, int);
+
+static qgemv_s8_fn select_qgemv_s8() {
+    if (lstm_simd_vnni()) {
+        return qgemv_vnni_s8;
+    }
+    return lstm_simd_level() >= LSTM_SIMD_AVX2 ? qgemv_avx2_s8 : qgemv_scalar<int8_t>;
+}
+
+static qgemv_s16_fn select_qgemv_s16() {
+    if (lstm_simd_vnni()) {
+        return qgemv_vnni_s16;
+    }
+    return lstm_simd_level() >= LSTM_SIMD_AVX2 ? qgemv_avx2_s16 : qgemv_scalar<int16_t>;
+}
+
+void lstm_qgemv(const int8_t *W, const int32_t *w_sums, const int8_t *v, int32_t *y, int rows, int ld, int cols) {
+    static const qgemv_s8_fn fn = select_qgemv_s8();
+    fn(W, w_sums, v, y, rows, ld, cols);
+}
+
+void lstm_qgemv(const int16_t *W, const int32_t *w_sums, const int16_t *v, int32_t *y, int rows, int ld, int cols) {
+    static const qgemv_s16_fn fn = select_qgemv_s16();
+    fn(W, w_sums, v, y, rows, ld, cols);
+}
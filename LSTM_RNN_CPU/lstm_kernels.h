@@ -0,0 +1,92 @@
+#ifndef LSTM_KERNELS_H
+#define LSTM_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Vector kernels behind the packed LSTM engine.
+// The AVX2/AVX-512 variants are compiled with function target attributes,
+// the best one is picked once at run time from cpuid.
+
+// Cache line alignment and padding granule (16 floats / 8 doubles)
+#define LSTM_ALIGN 64
+
+enum LstmSimdLevel {
+    LSTM_SIMD_SCALAR = 0,
+    LSTM_SIMD_AVX2 = 1,
+    LSTM_SIMD_AVX512 = 2
+};
+
+// Detected SIMD level, LSTM_SIMD=scalar|avx2|avx512 in the environment caps it
+LstmSimdLevel lstm_simd_level();
+const char *lstm_simd_name(LstmSimdLevel level);
+
+// AVX-512 VNNI (with BW/VL) for the integer kernels, off when LSTM_SIMD caps below avx512
+bool lstm_simd_vnni();
+
+// Round n up to a whole number of cache lines of T
+template <typename T>
+inline int lstm_padded(int n) {
+    const int lane = LSTM_ALIGN / sizeof(T);
+    return (n + lane - 1) / lane * lane;
+}
+
+// Aligned allocation for weight blocks and activation scratch
+void *lstm_aligned_alloc(size_t bytes);
+void lstm_aligned_free(void *ptr);
+
+// y[r] = bias[r] + sum_k W[r * ld + k] * v[k] for r in [0, rows), k in [0, cols)
+// rows is a multiple of 4, ld and cols are padded with lstm_padded and W/v are LSTM_ALIGN aligned.
+// bias may be any per-row vector, e.g. a cached input projection.
+void lstm_gemv(const float *W, const float *bias, const float *v, float *y, int rows, int ld, int cols);
+void lstm_gemv(const double *W, const double *bias, const double *v, double *y, int rows, int ld, int cols);
+
+template <typename T>
+inline void lstm_gemv(const T *W, const T *bias, const T *v, T *y, int rows, int stride) {
+    lstm_gemv(W, bias, v, y, rows, stride, stride);
+}
+
+// Batched form, Y[b * ldy + r] = bias[r] + sum_k W[r * ld + k] * V[b * ldv + k]
+// ldv is a multiple of the padding granule so every column of V stays aligned
+void lstm_gemm(const float *W, const float *bias, const float *V, int ldv, float *Y, int ldy,
+               int rows, int ld, int cols, int batch);
+void lstm_gemm(const double *W, const double *bias, const double *V, int ldv, double *Y, int ldy,
+               int rows, int ld, int cols, int batch);
+
+template <typename T>
+inline void lstm_gemm(const T *W, const T *bias, const T *V, int ldv, T *Y, int ldy, int rows, int stride, int batch) {
+    lstm_gemm(W, bias, V, ldv, Y, ldy, rows, stride, stride, batch);
+}
+
+// Block-sparse kernels for the pruned engine (lstm_sparse.h). A block is four
+// rows (one hidden unit's gates) by LSTM_SPARSE_BLOCK columns, stored row-major
+// and LSTM_ALIGN aligned. For every group g in [0, groups), with blocks
+// [block_ptr[g], block_ptr[g + 1]) starting at columns block_col[b] (multiples
+// of LSTM_SPARSE_BLOCK):
+// y[4g + j] = bias[4g + j] + sum_b values[b][j][0..LSTM_SPARSE_BLOCK) . v[block_col[b]..)
+// v is LSTM_ALIGN aligned and readable up to the last block's end.
+#define LSTM_SPARSE_BLOCK 8
+
+void lstm_bsr_gemv(const float *values, const int *block_col, const int *block_ptr, const float *bias,
+                   const float *v, float *y, int groups);
+void lstm_bsr_gemv(const double *values, const int *block_col, const int *block_ptr, const double *bias,
+                   const double *v, double *y, int groups);
+
+// Integer kernels for the quantized engine (lstm_quant.h). Rows are padded to
+// LSTM_QUANT_ALIGN bytes only, so tiny int8 rows are not blown up to a cache line.
+#define LSTM_QUANT_ALIGN 16
+
+template <typename Q>
+inline int lstm_quant_padded(int n) {
+    const int lane = LSTM_QUANT_ALIGN / sizeof(Q);
+    return (n + lane - 1) / lane * lane;
+}
+
+// y[r] = sum_k W[r * ld + k] * v[k] in int32 for r in [0, rows), k in [0, cols).
+// cols is padded with lstm_quant_padded and the caller keeps the sum in int32 range.
+// w_sums[r] holds sum_k W[r * ld + k]; the VNNI int8 kernel feeds v as unsigned
+// (v + 128) to vpdpbusd and takes 128 * w_sums[r] back off.
+void lstm_qgemv(const int8_t *W, const int32_t *w_sums, const int8_t *v, int32_t *y, int rows, int ld, int cols);
+void lstm_qgemv(const int16_t *W, const int32_t *w_sums, const int16_t *v, int32_t *y, int rows, int ld, int cols);
+
+#endif // LSTM_KERNELS_H
@@ -0,0 +1,238 @@
+#ifndef LSTM_MODEL_H
+#define LSTM_MODEL_H
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Native float/double LSTM engine for host-side inference.
+// Mirrors lstm_cell/lstm_sequence from LSTM_RNN_HW/lstm_rnn.cpp without the
+// ap_fixed/hls_math dependency. LstmModel fixes every loop bound at compile
+// time; LstmModelRuntime is the fallback for shapes chosen at run time.
+//
+// Like the HLS kernel, lstm_sequence passes h/c as both h_prev/c_prev and h/c,
+// so hidden unit i already sees the h[0..i) of the current step. The packed
+// engines (lstm_packed.h and everything built on it) keep h_prev intact for the
+// whole step instead, see the note there.
+
+// Clipping range applied to the cell state (same as lstm_rnn.cpp)
+#define LSTM_CELL_CLIP 50.0
+
+// Activation functions
+template <typename T>
+inline T lstm_sigmoid(T x) {
+    return T(1) / (T(1) + std::exp(-x));
+}
+
+template <typename T>
+inline T lstm_clip(T x, T min_val, T max_val) {
+    if (x < min_val) return min_val;
+    if (x > max_val) return max_val;
+    return x;
+}
+
+// Xavier initialization, same draw sequence as lstm_rnn.cpp
+template <typename T>
+inline T lstm_xavier(int input_size, int output_size) {
+    float limit = std::sqrt(12.0f / (input_size + output_size));
+    float random_value = ((float)std::rand() / RAND_MAX) * 2.0f * limit - limit;
+    return T(random_value);
+}
+
+// Compile-time sized LSTM model
+template <int In, int Hidden, int Seq, typename T>
+struct LstmModel {
+    static_assert(In <= Hidden, "prediction is read from h[0..In-1]");
+
+    typedef T value_type;
+    static constexpr int input_size = In;
+    static constexpr int hidden_size = Hidden;
+    static constexpr int seq_length = Seq;
+
+    // Weight matrices and biases for LSTM gates
+    T W_i[Hidden][In], U_i[Hidden][Hidden], b_i[Hidden];
+    T W_f[Hidden][In], U_f[Hidden][Hidden], b_f[Hidden];
+    T W_c[Hidden][In], U_c[Hidden][Hidden], b_c[Hidden];
+    T W_o[Hidden][In], U_o[Hidden][Hidden], b_o[Hidden];
+
+    // Initialize weights and biases
+    void initialize_weights_and_biases() {
+        for (int i = 0; i < Hidden; i++) {
+            for (int j = 0; j < In; j++) {
+                W_i[i][j] = lstm_xavier<T>(In, Hidden);
+                W_f[i][j] = lstm_xavier<T>(In, Hidden);
+                W_c[i][j] = lstm_xavier<T>(In, Hidden);
+                W_o[i][j] = lstm_xavier<T>(In, Hidden);
+            }
+            for (int j = 0; j < Hidden; j++) {
+                U_i[i][j] = lstm_xavier<T>(Hidden, Hidden);
+                U_f[i][j] = lstm_xavier<T>(Hidden, Hidden);
+                U_c[i][j] = lstm_xavier<T>(Hidden, Hidden);
+                U_o[i][j] = lstm_xavier<T>(Hidden, Hidden);
+            }
+            b_i[i] = lstm_xavier<T>(1, Hidden);
+            b_f[i] = lstm_xavier<T>(1, Hidden);
+            b_c[i] = lstm_xavier<T>(1, Hidden);
+            b_o[i] = lstm_xavier<T>(1, Hidden);
+        }
+    }
+
+    // LSTM cell with gate outputs. When h aliases h_prev, unit i reads the
+    // units before it already updated, as lstm_rnn.cpp does.
+    void lstm_cell(const T x[In], const T h_prev[Hidden], const T c_prev[Hidden],
+                   T h[Hidden], T c[Hidden],
+                   T i_gate[Hidden], T f_gate[Hidden],
+                   T g_gate[Hidden], T o_gate[Hidden]) const {
+        for (int i = 0; i < Hidden; i++) {
+            T input_gate = b_i[i];
+            T forget_gate = b_f[i];
+            T candidate = b_c[i];
+            T output_gate = b_o[i];
+
+#pragma GCC unroll 16
+            for (int j = 0; j < In; j++) {
+                input_gate += W_i[i][j] * x[j];
+                forget_gate += W_f[i][j] * x[j];
+                candidate += W_c[i][j] * x[j];
+                output_gate += W_o[i][j] * x[j];
+            }
+
+#pragma GCC unroll 16
+            for (int j = 0; j < Hidden; j++) {
+                input_gate += U_i[i][j] * h_prev[j];
+                forget_gate += U_f[i][j] * h_prev[j];
+                candidate += U_c[i][j] * h_prev[j];
+                output_gate += U_o[i][j] * h_prev[j];
+            }
+
+            i_gate[i] = lstm_sigmoid(input_gate);
+            f_gate[i] = lstm_sigmoid(forget_gate);
+            g_gate[i] = std::tanh(candidate);
+            o_gate[i] = lstm_sigmoid(output_gate);
+
+            c[i] = lstm_clip<T>(f_gate[i] * c_prev[i] + i_gate[i] * g_gate[i],
+                                T(-LSTM_CELL_CLIP), T(LSTM_CELL_CLIP));
+            h[i] = o_gate[i] * std::tanh(c[i]);
+        }
+    }
+
+    // LSTM sequence processing, h/c carry over between calls
+    void lstm_sequence(const T x_seq[Seq][In], T h[Hidden], T c[Hidden], T output_data[In],
+                       T i_gate[Hidden], T f_gate[Hidden],
+                       T g_gate[Hidden], T o_gate[Hidden]) const {
+        for (int t = 0; t < Seq; t++) {
+            lstm_cell(x_seq[t], h, c, h, c, i_gate, f_gate, g_gate, o_gate);
+        }
+
+        for (int i = 0; i < In; i++) {
+            output_data[i] = h[i];
+        }
+    }
+
+    void lstm_sequence(const T x_seq[Seq][In], T h[Hidden], T c[Hidden], T output_data[In]) const {
+        T i_gate[Hidden], f_gate[Hidden], g_gate[Hidden], o_gate[Hidden];
+        lstm_sequence(x_seq, h, c, output_data, i_gate, f_gate, g_gate, o_gate);
+    }
+};
+
+// Runtime sized LSTM model, row-major weights in contiguous vectors
+template <typename T>
+struct LstmModelRuntime {
+    typedef T value_type;
+    int input_size;
+    int hidden_size;
+    int seq_length;
+
+    std::vector<T> W_i, U_i, b_i;
+    std::vector<T> W_f, U_f, b_f;
+    std::vector<T> W_c, U_c, b_c;
+    std::vector<T> W_o, U_o, b_o;
+    std::vector<T> gates;    // i/f/g/o scratch for the lstm_sequence overload without gate outputs
+
+    LstmModelRuntime(int in, int hidden, int seq)
+        : input_size(in), hidden_size(hidden), seq_length(seq),
+          W_i(hidden * in), U_i(hidden * hidden), b_i(hidden),
+          W_f(hidden * in), U_f(hidden * hidden), b_f(hidden),
+          W_c(hidden * in), U_c(hidden * hidden), b_c(hidden),
+          W_o(hidden * in), U_o(hidden * hidden), b_o(hidden), gates(4 * hidden) {}
+
+    // Initialize weights and biases, same draw order as LstmModel
+    void initialize_weights_and_biases() {
+        const int in = input_size, hid = hidden_size;
+        for (int i = 0; i < hid; i++) {
+            for (int j = 0; j < in; j++) {
+                W_i[i * in + j] = lstm_xavier<T>(in, hid);
+                W_f[i * in + j] = lstm_xavier<T>(in, hid);
+                W_c[i * in + j] = lstm_xavier<T>(in, hid);
+                W_o[i * in + j] = lstm_xavier<T>(in, hid);
+            }
+            for (int j = 0; j < hid; j++) {
+                U_i[i * hid + j] = lstm_xavier<T>(hid, hid);
+                U_f[i * hid + j] = lstm_xavier<T>(hid, hid);
+                U_c[i * hid + j] = lstm_xavier<T>(hid, hid);
+                U_o[i * hid + j] = lstm_xavier<T>(hid, hid);
+            }
+            b_i[i] = lstm_xavier<T>(1, hid);
+            b_f[i] = lstm_xavier<T>(1, hid);
+            b_c[i] = lstm_xavier<T>(1, hid);
+            b_o[i] = lstm_xavier<T>(1, hid);
+        }
+    }
+
+    // LSTM cell with gate outputs, same aliasing behaviour as LstmModel
+    void lstm_cell(const T *x, const T *h_prev, const T *c_prev, T *h, T *c,
+                   T *i_gate, T *f_gate, T *g_gate, T *o_gate) const {
+        const int in = input_size, hid = hidden_size;
+
+        for (int i = 0; i < hid; i++) {
+            T input_gate = b_i[i];
+            T forget_gate = b_f[i];
+            T candidate = b_c[i];
+            T output_gate = b_o[i];
+
+            const T *wi = &W_i[i * in], *wf = &W_f[i * in], *wc = &W_c[i * in], *wo = &W_o[i * in];
+            for (int j = 0; j < in; j++) {
+                input_gate += wi[j] * x[j];
+                forget_gate += wf[j] * x[j];
+                candidate += wc[j] * x[j];
+                output_gate += wo[j] * x[j];
+            }
+
+            const T *ui = &U_i[i * hid], *uf = &U_f[i * hid], *uc = &U_c[i * hid], *uo = &U_o[i * hid];
+            for (int j = 0; j < hid; j++) {
+                input_gate += ui[j] * h_prev[j];
+                forget_gate += uf[j] * h_prev[j];
+                candidate += uc[j] * h_prev[j];
+                output_gate += uo[j] * h_prev[j];
+            }
+
+            i_gate[i] = lstm_sigmoid(input_gate);
+            f_gate[i] = lstm_sigmoid(forget_gate);
+            g_gate[i] = std::tanh(candidate);
+            o_gate[i] = lstm_sigmoid(output_gate);
+
+            c[i] = lstm_clip<T>(f_gate[i] * c_prev[i] + i_gate[i] * g_gate[i],
+                                T(-LSTM_CELL_CLIP), T(LSTM_CELL_CLIP));
+            h[i] = o_gate[i] * std::tanh(c[i]);
+        }
+    }
+
+    // LSTM sequence processing, x_seq is seq_length x input_size row-major
+    void lstm_sequence(const T *x_seq, T *h, T *c, T *output_data,
+                       T *i_gate, T *f_gate, T *g_gate, T *o_gate) const {
+        for (int t = 0; t < seq_length; t++) {
+            lstm_cell(x_seq + t * input_size, h, c, h, c, i_gate, f_gate, g_gate, o_gate);
+        }
+
+        for (int i = 0; i < input_size; i++) {
+            output_data[i] = h[i];
+        }
+    }
+
+    void lstm_sequence(const T *x_seq, T *h, T *c, T *output_data) {
+        T *g = gates.data();
+        lstm_sequence(x_seq, h, c, output_data, g, g + hidden_size, g + 2 * hidden_size, g + 3 * hidden_size);
+    }
+};
+
+#endif // LSTM_MODEL_H
@@ -0,0 +1,253 @@
+#ifndef LSTM_PACKED_H
+#define LSTM_PACKED_H
+
+#include <cstddef>
+#include <utility>
+#include "lstm_activation.h"
+#include "lstm_kernels.h"
+#include "lstm_model.h"
+#ifdef LSTM_PROBE
+#include <vector>
+#include "gate_probe.h"
+#endif
+
+// Gate order inside a packed hidden unit
+#define LSTM_GATE_I 0
+#define LSTM_GATE_F 1
+#define LSTM_GATE_C 2
+#define LSTM_GATE_O 3
+#define LSTM_GATES 4
+
+// Owning LSTM_ALIGN aligned array, movable but not copyable
+template <typename T>
+class AlignedBuffer {
+public:
+    AlignedBuffer() : data_(nullptr), size_(0) {}
+    explicit AlignedBuffer(size_t n) : data_(static_cast<T *>(lstm_aligned_alloc(n * sizeof(T)))), size_(n) {}
+    AlignedBuffer(AlignedBuffer &&other) : data_(other.data_), size_(other.size_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    AlignedBuffer &operator=(AlignedBuffer &&other) {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    AlignedBuffer(const AlignedBuffer &) = delete;
+    AlignedBuffer &operator=(const AlignedBuffer &) = delete;
+    ~AlignedBuffer() { lstm_aligned_free(data_); }
+
+    T *data() { return data_; }
+    const T *data() const { return data_; }
+    size_t size() const { return size_; }
+    T &operator[](size_t i) { return data_[i]; }
+    const T &operator[](size_t i) const { return data_[i]; }
+
+private:
+    T *data_;
+    size_t size_;
+};
+
+// All four gates in one [4*hidden][stride] block. Row 4*i+g holds gate g of
+// hidden unit i as [W_g[i][0..in) | 0 | U_g[i][0..hidden) | 0], with the U
+// segment starting on a cache line at x_stride. One pass over the block against
+// [x | 0 | h_prev | 0] yields every gate pre-activation, and the U segment alone
+// serves the recurrence when the W half comes from a projection cache.
+template <typename T>
+struct PackedLstmWeights {
+    int input_size;
+    int hidden_size;
+    int x_stride;        // lstm_padded(input_size), offset of the U segment
+    int h_stride;        // lstm_padded(hidden_size)
+    int stride;          // x_stride + h_stride
+    const T *weights;    // [4*hidden][stride]
+    const T *bias;       // [4*hidden]
+    LstmActivation activation;    // gate nonlinearity tier, see lstm_activation.h
+    AlignedBuffer<T> storage;
+
+    PackedLstmWeights()
+        : input_size(0), hidden_size(0), x_stride(0), h_stride(0), stride(0), weights(nullptr), bias(nullptr),
+          activation(LSTM_ACT_LIBM) {}
+
+    PackedLstmWeights(int in, int hidden)
+        : input_size(in), hidden_size(hidden), x_stride(lstm_padded<T>(in)), h_stride(lstm_padded<T>(hidden)),
+          stride(x_stride + h_stride), activation(LSTM_ACT_LIBM),
+          storage((size_t)LSTM_GATES * hidden * stride + lstm_padded<T>(LSTM_GATES * hidden)) {
+        weights = storage.data();
+        bias = storage.data() + (size_t)LSTM_GATES * hidden * stride;
+    }
+
+    PackedLstmWeights(PackedLstmWeights &&other) = default;
+    PackedLstmWeights &operator=(PackedLstmWeights &&other) = default;
+
+    int rows() const { return LSTM_GATES * hidden_size; }
+    T *row(int hidden_unit, int gate) { return storage.data() + (size_t)(LSTM_GATES * hidden_unit + gate) * stride; }
+    T *bias_data() { return storage.data() + (size_t)LSTM_GATES * hidden_size * stride; }
+
+    // Copy one gate from the separate W_g/U_g/b_g layout (row-major)
+    void set_gate(int gate, const T *W, const T *U, const T *b) {
+        for (int i = 0; i < hidden_size; i++) {
+            T *dst = row(i, gate);
+            for (int j = 0; j < input_size; j++) {
+                dst[j] = W[i * input_size + j];
+            }
+            for (int j = 0; j < hidden_size; j++) {
+                dst[x_stride + j] = U[i * hidden_size + j];
+            }
+            bias_data()[LSTM_GATES * i + gate] = b[i];
+        }
+    }
+};
+
+// Pack the separate gate matrices of either LSTM model
+template <int In, int Hidden, int Seq, typename T>
+PackedLstmWeights<T> pack_lstm_weights(const LstmModel<In, Hidden, Seq, T> &model) {
+    PackedLstmWeights<T> packed(In, Hidden);
+    packed.set_gate(LSTM_GATE_I, &model.W_i[0][0], &model.U_i[0][0], model.b_i);
+    packed.set_gate(LSTM_GATE_F, &model.W_f[0][0], &model.U_f[0][0], model.b_f);
+    packed.set_gate(LSTM_GATE_C, &model.W_c[0][0], &model.U_c[0][0], model.b_c);
+    packed.set_gate(LSTM_GATE_O, &model.W_o[0][0], &model.U_o[0][0], model.b_o);
+    return packed;
+}
+
+template <typename T>
+PackedLstmWeights<T> pack_lstm_weights(const LstmModelRuntime<T> &model) {
+    PackedLstmWeights<T> packed(model.input_size, model.hidden_size);
+    packed.set_gate(LSTM_GATE_I, model.W_i.data(), model.U_i.data(), model.b_i.data());
+    packed.set_gate(LSTM_GATE_F, model.W_f.data(), model.U_f.data(), model.b_f.data());
+    packed.set_gate(LSTM_GATE_C, model.W_c.data(), model.U_c.data(), model.b_c.data());
+    packed.set_gate(LSTM_GATE_O, model.W_o.data(), model.U_o.data(), model.b_o.data());
+    return packed;
+}
+
+// Per-thread scratch for the packed cell
+template <typename T>
+struct LstmWorkspace {
+    AlignedBuffer<T> xh;     // [x | 0 | h_prev | 0], stride wide
+    AlignedBuffer<T> gates;  // pre-activations then activations, 4*hidden wide
+
+    explicit LstmWorkspace(const PackedLstmWeights<T> &weights)
+        : xh(weights.stride), gates(lstm_padded<T>(weights.rows())) {}
+};
+
+// Gate nonlinearities and state update from interleaved pre-activations. The
+// libm tier keeps the original per-unit loop; the others activate the whole
+// gate vector in one pass, then tanh(c) in a second one.
+template <typename T>
+inline void lstm_pointwise(T *gates, const T *c_prev, T *h, T *c, int hidden_size,
+                           LstmActivation activation = LSTM_ACT_LIBM) {
+    if (activation != LSTM_ACT_LIBM) {
+        lstm_gate_activations(gates, hidden_size, activation);
+        for (int i = 0; i < hidden_size; i++) {
+            const T *g = gates + LSTM_GATES * i;
+            c[i] = lstm_clip<T>(g[LSTM_GATE_F] * c_prev[i] + g[LSTM_GATE_I] * g[LSTM_GATE_C],
+                                T(-LSTM_CELL_CLIP), T(LSTM_CELL_CLIP));
+            h[i] = c[i];
+        }
+        lstm_tanh_n(h, hidden_size, activation);
+        for (int i = 0; i < hidden_size; i++) {
+            h[i] *= gates[LSTM_GATES * i + LSTM_GATE_O];
+        }
+        return;
+    }
+
+    for (int i = 0; i < hidden_size; i++) {
+        T *g = gates + LSTM_GATES * i;
+        g[LSTM_GATE_I] = lstm_sigmoid(g[LSTM_GATE_I]);
+        g[LSTM_GATE_F] = lstm_sigmoid(g[LSTM_GATE_F]);
+        g[LSTM_GATE_C] = std::tanh(g[LSTM_GATE_C]);
+        g[LSTM_GATE_O] = lstm_sigmoid(g[LSTM_GATE_O]);
+
+        c[i] = lstm_clip<T>(g[LSTM_GATE_F] * c_prev[i] + g[LSTM_GATE_I] * g[LSTM_GATE_C],
+                            T(-LSTM_CELL_CLIP), T(LSTM_CELL_CLIP));
+        h[i] = g[LSTM_GATE_O] * std::tanh(c[i]);
+    }
+}
+
+// LSTM cell on the packed layout, h/c may alias h_prev/c_prev.
+// Gate activations are left interleaved in ws.gates.
+//
+// Every unit reads the h_prev of the previous step, since one GEMV produces
+// all the gates. The LSTM_RNN_HW kernel (and LstmModel) update h in place, so
+// their unit i sees the new h[0..i). The two recurrences are different models.
+// With the testbench's random weights on LSTM_RNN_HW/data.txt, the packed
+// forecast is within 0.06% of the kernel's on day 1 and within 0.9% over ten
+// days. lstm_cell_packed_inplace below runs the kernel's recurrence instead.
+template <typename T>
+void lstm_cell_packed(const PackedLstmWeights<T> &weights, LstmWorkspace<T> &ws,
+                      const T *x, const T *h_prev, const T *c_prev, T *h, T *c) {
+    T *xh = ws.xh.data();
+    for (int j = 0; j < weights.input_size; j++) {
+        xh[j] = x[j];
+    }
+    for (int j = 0; j < weights.hidden_size; j++) {
+        xh[weights.x_stride + j] = h_prev[j];
+    }
+
+    lstm_gemv(weights.weights, weights.bias, xh, ws.gates.data(), weights.rows(), weights.stride);
+    lstm_pointwise(ws.gates.data(), c_prev, h, c, weights.hidden_size, weights.activation);
+}
+
+// The kernel's recurrence on the packed layout: h and c are updated in place
+// and unit i reads the new h[0..i), as lstm_rnn.cpp does. The W half is one
+// GEMV, the U half runs unit by unit. Gate activations are left in ws.gates.
+template <typename T>
+void lstm_cell_packed_inplace(const PackedLstmWeights<T> &weights, LstmWorkspace<T> &ws, const T *x, T *h, T *c) {
+    T *xh = ws.xh.data();
+    for (int j = 0; j < weights.input_size; j++) {
+        xh[j] = x[j];
+    }
+
+    T *gates = ws.gates.data();
+    lstm_gemv(weights.weights, weights.bias, xh, gates, weights.rows(), weights.stride, weights.x_stride);
+    for (int i = 0; i < weights.hidden_size; i++) {
+        T *g = gates + LSTM_GATES * i;
+        for (int k = 0; k < LSTM_GATES; k++) {
+            const T *U = weights.weights + (size_t)(LSTM_GATES * i + k) * weights.stride + weights.x_stride;
+            T sum = g[k];
+            for (int j = 0; j < weights.hidden_size; j++) {
+                sum += U[j] * h[j];
+            }
+            g[k] = sum;
+        }
+        lstm_pointwise(g, c + i, h + i, c + i, 1, weights.activation);
+    }
+}
+
+#ifdef LSTM_PROBE
+// Hand one timestep to the gate probe: the interleaved i/f/g/o activations
+// lstm_cell_packed leaves in ws.gates, then c and h
+template <typename T>
+void lstm_probe_packed(int step, const T *gates, const T *c, const T *h, int hidden_size) {
+    thread_local std::vector<float> values;
+    values.resize((size_t)GATE_PROBE_FIELDS * hidden_size);
+    for (int i = 0; i < hidden_size; i++) {
+        for (int g = 0; g < LSTM_GATES; g++) {
+            values[(size_t)g * hidden_size + i] = float(gates[LSTM_GATES * i + g]);
+        }
+        values[(size_t)LSTM_GATES * hidden_size + i] = float(c[i]);
+        values[(size_t)(LSTM_GATES + 1) * hidden_size + i] = float(h[i]);
+    }
+    GateProbe::instance().record(step, values.data(), hidden_size);
+}
+#endif
+
+// LSTM sequence on the packed layout, x_seq is seq_length x input_size row-major
+template <typename T>
+void lstm_sequence_packed(const PackedLstmWeights<T> &weights, LstmWorkspace<T> &ws,
+                          const T *x_seq, int seq_length, T *h, T *c, T *output_data) {
+    for (int t = 0; t < seq_length; t++) {
+        lstm_cell_packed(weights, ws, x_seq + t * weights.input_size, h, c, h, c);
+#ifdef LSTM_PROBE
+        if (gate_probe_enabled()) {
+            lstm_probe_packed(t, ws.gates.data(), c, h, weights.hidden_size);
+        }
+#endif
+    }
+
+    for (int i = 0; i < weights.input_size; i++) {
+        output_data[i] = h[i];
+    }
+}
+
+#endif // LSTM_PACKED_H
@@ -0,0 +1,259 @@
+#ifndef LSTM_QUANT_H
+#define LSTM_QUANT_H
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "lstm_kernels.h"
+#include "lstm_packed.h"
+#include "rnn_model.h"
+
+// Quantized LSTM and RNN cells. Weights are stored as int8 or int16 codes with
+// one scale per row and segment (the W half and the U half of a packed row have
+// very different ranges), the cell input x and the recurrent input h_prev are
+// quantized on the fly with scales from a calibration run of the float engine,
+// and each segment is one int32 lstm_qgemv. Only the gate pre-activations are
+// quantized: the nonlinearities and the cell state stay in float, so c does not
+// pick up rounding error step after step.
+
+// Largest activations the float engine fed to the cell
+struct QuantCalibration {
+    double x_max;    // |x_t| over every input bar, fed-back predictions included
+    double h_max;    // |h_{t-1}| over every recurrent input
+
+    QuantCalibration() : x_max(0.0), h_max(0.0) {}
+
+    template <typename T>
+    void observe_x(const T *x, int n) {
+        for (int i = 0; i < n; i++) {
+            x_max = std::max(x_max, std::fabs(double(x[i])));
+        }
+    }
+
+    template <typename T>
+    void observe_h(const T *h, int n) {
+        for (int i = 0; i < n; i++) {
+            h_max = std::max(h_max, std::fabs(double(h[i])));
+        }
+    }
+};
+
+template <typename Q>
+struct QuantLimits;
+
+template <>
+struct QuantLimits<int8_t> {
+    static constexpr int max_code = 127;
+    static const char *name() { return "int8"; }
+};
+
+template <>
+struct QuantLimits<int16_t> {
+    static constexpr int max_code = 32767;
+    static const char *name() { return "int16"; }
+};
+
+// Largest activation code for which cols full-scale products still fit the
+// int32 accumulator. int8 always gets 127; int16 gets ~4096 levels over 16
+// hidden units, which is still 5 bits more than int8.
+template <typename Q>
+inline int quant_activation_levels(int cols) {
+    const int64_t limit = INT32_MAX / ((int64_t)QuantLimits<Q>::max_code * std::max(cols, 1));
+    return (int)std::min<int64_t>(QuantLimits<Q>::max_code, limit);
+}
+
+// Row r holds [W[r][0..in) | 0 | U[r][0..hidden) | 0] as codes, like the packed
+// float block but padded to LSTM_QUANT_ALIGN bytes per segment
+template <typename Q>
+struct QuantizedCell {
+    int rows;
+    int input_size;
+    int hidden_size;
+    int x_stride;                    // lstm_quant_padded(input_size), offset of the U segment
+    int h_stride;
+    int stride;
+    float x_inv_scale, h_inv_scale;  // value -> activation code
+    int x_levels, h_levels;          // activation codes are clamped to +-levels
+    AlignedBuffer<Q> weights;        // [rows][stride]
+    std::vector<float> x_factor;     // per row: weight scale * activation scale, code sum -> value
+    std::vector<float> h_factor;
+    std::vector<int32_t> x_sums;     // per row code sums, see lstm_qgemv
+    std::vector<int32_t> h_sums;
+    std::vector<float> bias;
+    LstmActivation activation;       // of the float model, the nonlinearities stay in float
+
+    // Codes plus the per-row scales and bias the engine reads
+    size_t weight_bytes() const {
+        return weights.size() * sizeof(Q) + (size_t)rows * (3 * sizeof(float) + 2 * sizeof(int32_t));
+    }
+};
+
+// Quantize rows x [in | hidden] weights, W and U read ldw/ldu elements apart
+template <typename Q>
+QuantizedCell<Q> quantize_cell(int rows, int input_size, int hidden_size, const float *W, int ldw, const float *U,
+                               int ldu, const float *bias, const QuantCalibration &calibration) {
+    QuantizedCell<Q> cell;
+    cell.activation = LSTM_ACT_LIBM;
+    cell.rows = rows;
+    cell.input_size = input_size;
+    cell.hidden_size = hidden_size;
+    cell.x_stride = lstm_quant_padded<Q>(input_size);
+    cell.h_stride = lstm_quant_padded<Q>(hidden_size);
+    cell.stride = cell.x_stride + cell.h_stride;
+    cell.x_levels = quant_activation_levels<Q>(input_size);
+    cell.h_levels = quant_activation_levels<Q>(hidden_size);
+    const double x_scale = calibration.x_max > 0.0 ? calibration.x_max / cell.x_levels : 1.0;
+    const double h_scale = calibration.h_max > 0.0 ? calibration.h_max / cell.h_levels : 1.0;
+    cell.x_inv_scale = float(1.0 / x_scale);
+    cell.h_inv_scale = float(1.0 / h_scale);
+
+    cell.weights = AlignedBuffer<Q>((size_t)rows * cell.stride);
+    cell.x_factor.resize(rows);
+    cell.h_factor.resize(rows);
+    cell.x_sums.resize(rows);
+    cell.h_sums.resize(rows);
+    cell.bias.assign(bias, bias + rows);
+
+    // One segment of one row: symmetric per-row scale, returns the code sum
+    auto quantize_segment = [](const float *src, int n, Q *dst, double &scale) {
+        double max_abs = 0.0;
+        for (int j = 0; j < n; j++) {
+            max_abs = std::max(max_abs, std::fabs(double(src[j])));
+        }
+        scale = max_abs / QuantLimits<Q>::max_code;
+        int32_t sum = 0;
+        for (int j = 0; j < n; j++) {
+            const long code = scale > 0.0 ? std::lround(src[j] / scale) : 0;
+            dst[j] = Q(std::max<long>(-QuantLimits<Q>::max_code, std::min<long>(QuantLimits<Q>::max_code, code)));
+            sum += dst[j];
+        }
+        return sum;
+    };
+
+    for (int r = 0; r < rows; r++) {
+        Q *row = cell.weights.data() + (size_t)r * cell.stride;
+        double w_scale, u_scale;
+        cell.x_sums[r] = quantize_segment(W + (size_t)r * ldw, input_size, row, w_scale);
+        cell.h_sums[r] = quantize_segment(U + (size_t)r * ldu, hidden_size, row + cell.x_stride, u_scale);
+        cell.x_factor[r] = float(w_scale * x_scale);
+        cell.h_factor[r] = float(u_scale * h_scale);
+    }
+    return cell;
+}
+
+template <typename Q>
+QuantizedCell<Q> quantize_lstm(const PackedLstmWeights<float> &packed, const QuantCalibration &calibration) {
+    QuantizedCell<Q> cell = quantize_cell<Q>(packed.rows(), packed.input_size, packed.hidden_size, packed.weights,
+                                             packed.stride, packed.weights + packed.x_stride, packed.stride,
+                                             packed.bias, calibration);
+    cell.activation = packed.activation;
+    return cell;
+}
+
+template <typename Q>
+QuantizedCell<Q> quantize_rnn(const RnnModel<float> &model, const QuantCalibration &calibration) {
+    QuantizedCell<Q> cell = quantize_cell<Q>(model.hidden_size, model.input_size, model.hidden_size, model.W.data(),
+                                             model.input_size, model.U.data(), model.hidden_size, model.b.data(),
+                                             calibration);
+    cell.activation = model.activation;
+    return cell;
+}
+
+// Per-thread scratch for the quantized cell
+template <typename Q>
+struct QuantWorkspace {
+    AlignedBuffer<Q> xh;           // [x | 0 | h_prev | 0] as activation codes
+    AlignedBuffer<int32_t> acc_x;  // int32 sums of the W and U segments
+    AlignedBuffer<int32_t> acc_h;
+    AlignedBuffer<float> gates;    // pre-activations then activations
+    AlignedBuffer<float> h_prev;   // RNN sequence state
+
+    explicit QuantWorkspace(const QuantizedCell<Q> &cell)
+        : xh(cell.stride), acc_x(cell.rows), acc_h(cell.rows), gates(cell.rows), h_prev(cell.hidden_size) {}
+};
+
+// Round half away from zero after clamping, plain float ops so the loops vectorize
+template <typename Q>
+inline Q quant_code(float value, float inv_scale, float levels) {
+    const float scaled = std::max(-levels, std::min(levels, value * inv_scale));
+    return Q(scaled + (scaled >= 0.0f ? 0.5f : -0.5f));
+}
+
+// ws.gates[r] = bias[r] + W[r] . x + U[r] . h_prev through the integer kernels
+template <typename Q>
+void quant_preactivations(const QuantizedCell<Q> &cell, QuantWorkspace<Q> &ws, const float *x, const float *h_prev) {
+    // Locals, since int8 stores may alias anything and would reload the bounds
+    Q *xh = ws.xh.data();
+    const int input_size = cell.input_size, hidden_size = cell.hidden_size;
+    const float x_inv_scale = cell.x_inv_scale, h_inv_scale = cell.h_inv_scale;
+    const float x_levels = float(cell.x_levels), h_levels = float(cell.h_levels);
+    for (int j = 0; j < input_size; j++) {
+        xh[j] = quant_code<Q>(x[j], x_inv_scale, x_levels);
+    }
+    Q *hq = xh + cell.x_stride;
+    for (int j = 0; j < hidden_size; j++) {
+        hq[j] = quant_code<Q>(h_prev[j], h_inv_scale, h_levels);
+    }
+
+    lstm_qgemv(cell.weights.data(), cell.x_sums.data(), xh, ws.acc_x.data(), cell.rows, cell.stride, cell.x_stride);
+    lstm_qgemv(cell.weights.data() + cell.x_stride, cell.h_sums.data(), xh + cell.x_stride, ws.acc_h.data(),
+               cell.rows, cell.stride, cell.h_stride);
+
+    float *gates = ws.gates.data();
+    const int32_t *acc_x = ws.acc_x.data(), *acc_h = ws.acc_h.data();
+    const float *bias = cell.bias.data(), *x_factor = cell.x_factor.data(), *h_factor = cell.h_factor.data();
+    const int rows = cell.rows;
+    for (int r = 0; r < rows; r++) {
+        gates[r] = bias[r] + x_factor[r] * float(acc_x[r]) + h_factor[r] * float(acc_h[r]);
+    }
+}
+
+// LSTM cell on a quantized packed LSTM, h/c may alias h_prev/c_prev
+template <typename Q>
+void lstm_cell_quant(const QuantizedCell<Q> &cell, QuantWorkspace<Q> &ws, const float *x, const float *h_prev,
+                     const float *c_prev, float *h, float *c) {
+    quant_preactivations(cell, ws, x, h_prev);
+    lstm_pointwise(ws.gates.data(), c_prev, h, c, cell.hidden_size, cell.activation);
+}
+
+template <typename Q>
+void lstm_sequence_quant(const QuantizedCell<Q> &cell, QuantWorkspace<Q> &ws, const float *x_seq, int seq_length,
+                         float *h, float *c, float *output_data) {
+    for (int t = 0; t < seq_length; t++) {
+        lstm_cell_quant(cell, ws, x_seq + t * cell.input_size, h, c, h, c);
+    }
+
+    for (int i = 0; i < cell.input_size; i++) {
+        output_data[i] = h[i];
+    }
+}
+
+// RNN cell on a quantized RnnModel, h may alias h_prev
+template <typename Q>
+void rnn_cell_quant(const QuantizedCell<Q> &cell, QuantWorkspace<Q> &ws, const float *x, const float *h_prev,
+                    float *h) {
+    quant_preactivations(cell, ws, x, h_prev);
+    if (cell.activation != LSTM_ACT_LIBM) {
+        std::copy(ws.gates.data(), ws.gates.data() + cell.hidden_size, h);
+        lstm_tanh_n(h, cell.hidden_size, cell.activation);
+        return;
+    }
+    for (int i = 0; i < cell.hidden_size; i++) {
+        h[i] = std::tanh(ws.gates[i]);
+    }
+}
+
+// Whole sequence from a zero state, as RnnModel::rnn_sequence
+template <typename Q>
+void rnn_sequence_quant(const QuantizedCell<Q> &cell, QuantWorkspace<Q> &ws, const float *x_seq, int seq_length,
+                        float *h) {
+    std::fill(ws.h_prev.data(), ws.h_prev.data() + cell.hidden_size, 0.0f);
+    for (int t = 0; t < seq_length; t++) {
+        rnn_cell_quant(cell, ws, x_seq + t * cell.input_size, ws.h_prev.data(), h);
+        std::copy(h, h + cell.hidden_size, ws.h_prev.data());
+    }
+}
+
+#endif // LSTM_QUANT_H
@@ -0,0 +1,77 @@
+#ifndef LSTM_ROLLOUT_H
+#define LSTM_ROLLOUT_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "data_io.h"
+
+// The lstm_cpu rollout for the engine comparison tools (quant_cpu, sparse_cpu):
+// each data file is normalized over its whole table, the first seq_length bars
+// form the window, and every prediction day runs the window through step(),
+// keeps h/c, and feeds the prediction back as the newest bar. Any engine whose
+// cell can be wrapped in step(x, h, c) is scored on exactly the same inputs.
+
+struct LstmSeries {
+    std::string file_name;
+    OnlineNormalizer normalizer;
+    int input_size = 0;
+    int seq_length = 0;
+    std::vector<float> window;     // seq_length x input_size, normalized, zero padded
+    int prediction_days = 0;
+};
+
+// False with an error message when the file has no input_size-feature rows
+inline bool load_lstm_series(const std::string &file_name, int input_size, int seq_length, LstmSeries &series) {
+    DataTable table;
+    if (!load_table(file_name, table) || table.rows() == 0 || table.num_features != (size_t)input_size) {
+        std::cerr << "Error: No " << input_size << "-feature data loaded from " << file_name << std::endl;
+        return false;
+    }
+    std::vector<double> normalized;
+    normalize_table(table, series.normalizer, normalized);
+    series.file_name = file_name;
+    series.input_size = input_size;
+    series.seq_length = seq_length;
+    series.prediction_days = table.prediction_days;
+    series.window.assign((size_t)seq_length * input_size, 0.0f);
+    for (size_t i = 0; i < series.window.size() && i < normalized.size(); i++) {
+        series.window[i] = float(normalized[i]);
+    }
+    return true;
+}
+
+// Rolling prediction over one series, step(x, h, c) advances the state in place.
+// Returns prediction_days x input_size normalized outputs.
+template <typename Step>
+std::vector<float> rollout(const LstmSeries &series, int hidden_size, Step step) {
+    const int input_size = series.input_size;
+    std::vector<float> input_seq = series.window;
+    std::vector<float> h(hidden_size, 0.0f), c(hidden_size, 0.0f);
+    std::vector<float> predictions;
+
+    for (int day = 0; day < series.prediction_days; ++day) {
+        for (int t = 0; t < series.seq_length; t++) {
+            step(&input_seq[t * input_size], h.data(), c.data());
+        }
+        predictions.insert(predictions.end(), h.begin(), h.begin() + input_size);
+
+        input_seq.erase(input_seq.begin(), input_seq.begin() + input_size);
+        input_seq.insert(input_seq.end(), h.begin(), h.begin() + input_size);
+    }
+    return predictions;
+}
+
+// Mean time of one call of run() in microseconds
+template <typename Run>
+double time_us(int repeat, Run run) {
+    run();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        run();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeat;
+}
+
+#endif // LSTM_ROLLOUT_H
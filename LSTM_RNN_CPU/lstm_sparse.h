@@ -0,0 +1,180 @@
+#ifndef LSTM_SPARSE_H
+#define LSTM_SPARSE_H
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+#include "lstm_kernels.h"
+#include "lstm_packed.h"
+
+// Block-pruned LSTM cell. The recurrent half of the packed block (U, 4*hidden
+// rows by hidden columns) holds most of the multiply-adds and grows with the
+// square of the hidden size, so it is pruned by magnitude in blocks of one
+// hidden unit's four gate rows by LSTM_SPARSE_BLOCK columns of h_prev: the
+// blocks with the smallest Frobenius norm are dropped until the requested
+// fraction is gone. The kept blocks are stored block-row compressed and run
+// through lstm_bsr_gemv. The small input half (W) stays dense; lstm_gemv turns
+// it and the bias into the per-row bias of the sparse pass.
+
+template <typename T>
+struct SparseLstmWeights {
+    int input_size;
+    int hidden_size;
+    int x_stride;                  // lstm_padded(input_size)
+    int h_stride;                  // lstm_padded(hidden_size), a multiple of LSTM_SPARSE_BLOCK
+    int total_blocks;              // U blocks before pruning
+    LstmActivation activation;
+    AlignedBuffer<T> input;        // [4*hidden][x_stride], the W half as packed
+    AlignedBuffer<T> bias;         // [4*hidden]
+    AlignedBuffer<T> values;       // [blocks][4][LSTM_SPARSE_BLOCK]
+    std::vector<int> block_ptr;    // hidden unit i owns blocks [block_ptr[i], block_ptr[i + 1])
+    std::vector<int> block_col;    // first h_prev column of each block
+
+    SparseLstmWeights() : input_size(0), hidden_size(0), x_stride(0), h_stride(0), total_blocks(0),
+                          activation(LSTM_ACT_LIBM) {}
+    SparseLstmWeights(SparseLstmWeights &&other) = default;
+    SparseLstmWeights &operator=(SparseLstmWeights &&other) = default;
+
+    int rows() const { return LSTM_GATES * hidden_size; }
+    int blocks() const { return (int)block_col.size(); }
+    double sparsity() const { return total_blocks ? 1.0 - double(blocks()) / total_blocks : 0.0; }
+
+    // Everything the cell reads: W half, bias, kept blocks and their index
+    size_t weight_bytes() const {
+        return (input.size() + bias.size() + values.size()) * sizeof(T) +
+               (block_ptr.size() + block_col.size()) * sizeof(int);
+    }
+};
+
+// Drop the sparsity fraction (0..1) of U blocks with the smallest norms. Ties
+// go to the lower block index, so the result does not depend on the sort.
+template <typename T>
+SparseLstmWeights<T> prune_lstm_weights(const PackedLstmWeights<T> &dense, double sparsity) {
+    SparseLstmWeights<T> sparse;
+    sparse.input_size = dense.input_size;
+    sparse.hidden_size = dense.hidden_size;
+    sparse.x_stride = dense.x_stride;
+    sparse.h_stride = dense.h_stride;
+    sparse.activation = dense.activation;
+
+    const int rows = dense.rows(), hidden = dense.hidden_size;
+    const int per_unit = (hidden + LSTM_SPARSE_BLOCK - 1) / LSTM_SPARSE_BLOCK;
+    sparse.total_blocks = hidden * per_unit;
+
+    sparse.input = AlignedBuffer<T>((size_t)rows * dense.x_stride);
+    sparse.bias = AlignedBuffer<T>(lstm_padded<T>(rows));
+    for (int r = 0; r < rows; r++) {
+        std::copy(dense.weights + (size_t)r * dense.stride, dense.weights + (size_t)r * dense.stride + dense.x_stride,
+                  sparse.input.data() + (size_t)r * dense.x_stride);
+        sparse.bias[r] = dense.bias[r];
+    }
+
+    // Block (unit, column block) of the U half, four rows by LSTM_SPARSE_BLOCK
+    auto block_at = [&](int unit, int k, int j) {
+        return dense.weights + (size_t)(LSTM_GATES * unit + j) * dense.stride + dense.x_stride +
+               k * LSTM_SPARSE_BLOCK;
+    };
+    std::vector<std::pair<double, int>> order(sparse.total_blocks);
+    for (int i = 0; i < hidden; i++) {
+        for (int k = 0; k < per_unit; k++) {
+            double sum = 0.0;
+            for (int j = 0; j < LSTM_GATES; j++) {
+                const T *row = block_at(i, k, j);
+                for (int c = 0; c < LSTM_SPARSE_BLOCK; c++) {
+                    sum += double(row[c]) * double(row[c]);
+                }
+            }
+            order[i * per_unit + k] = std::make_pair(std::sqrt(sum), i * per_unit + k);
+        }
+    }
+    const int dropped = std::min(sparse.total_blocks, std::max(0, (int)std::lround(sparsity * sparse.total_blocks)));
+    std::vector<char> keep(sparse.total_blocks, 1);
+    std::nth_element(order.begin(), order.begin() + dropped, order.end());
+    for (int d = 0; d < dropped; d++) {
+        keep[order[d].second] = 0;
+    }
+
+    sparse.values = AlignedBuffer<T>((size_t)(sparse.total_blocks - dropped) * LSTM_GATES * LSTM_SPARSE_BLOCK);
+    sparse.block_ptr.assign(1, 0);
+    for (int i = 0; i < hidden; i++) {
+        for (int k = 0; k < per_unit; k++) {
+            if (!keep[i * per_unit + k]) {
+                continue;
+            }
+            T *dst = sparse.values.data() + sparse.block_col.size() * LSTM_GATES * LSTM_SPARSE_BLOCK;
+            for (int j = 0; j < LSTM_GATES; j++) {
+                std::copy(block_at(i, k, j), block_at(i, k, j) + LSTM_SPARSE_BLOCK, dst + j * LSTM_SPARSE_BLOCK);
+            }
+            sparse.block_col.push_back(k * LSTM_SPARSE_BLOCK);
+        }
+        sparse.block_ptr.push_back((int)sparse.block_col.size());
+    }
+    return sparse;
+}
+
+// The pruned model back in the dense packed layout, dropped blocks as zeros,
+// to check the sparse kernels or save the weights with save_lstm_weights
+template <typename T>
+PackedLstmWeights<T> densify_lstm_weights(const SparseLstmWeights<T> &sparse) {
+    PackedLstmWeights<T> dense(sparse.input_size, sparse.hidden_size);
+    dense.activation = sparse.activation;
+    for (int r = 0; r < sparse.rows(); r++) {
+        std::copy(sparse.input.data() + (size_t)r * sparse.x_stride,
+                  sparse.input.data() + (size_t)(r + 1) * sparse.x_stride, dense.storage.data() + (size_t)r * dense.stride);
+        dense.bias_data()[r] = sparse.bias[r];
+    }
+    for (int i = 0; i < sparse.hidden_size; i++) {
+        for (int b = sparse.block_ptr[i]; b < sparse.block_ptr[i + 1]; b++) {
+            const T *block = sparse.values.data() + (size_t)b * LSTM_GATES * LSTM_SPARSE_BLOCK;
+            for (int j = 0; j < LSTM_GATES; j++) {
+                T *row = dense.row(i, j) + dense.x_stride + sparse.block_col[b];
+                const int width = std::min(LSTM_SPARSE_BLOCK, sparse.hidden_size - sparse.block_col[b]);
+                std::copy(block + j * LSTM_SPARSE_BLOCK, block + j * LSTM_SPARSE_BLOCK + width, row);
+            }
+        }
+    }
+    return dense;
+}
+
+// Per-thread scratch for the sparse cell
+template <typename T>
+struct SparseLstmWorkspace {
+    AlignedBuffer<T> x;        // x, zero padded to x_stride
+    AlignedBuffer<T> h_prev;   // h_prev, zero padded to h_stride
+    AlignedBuffer<T> proj;     // W . x + b
+    AlignedBuffer<T> gates;    // pre-activations then activations
+
+    explicit SparseLstmWorkspace(const SparseLstmWeights<T> &weights)
+        : x(weights.x_stride), h_prev(weights.h_stride), proj(lstm_padded<T>(weights.rows())),
+          gates(lstm_padded<T>(weights.rows())) {}
+};
+
+// LSTM cell on the pruned weights, h/c may alias h_prev/c_prev
+template <typename T>
+void lstm_cell_sparse(const SparseLstmWeights<T> &weights, SparseLstmWorkspace<T> &ws,
+                      const T *x, const T *h_prev, const T *c_prev, T *h, T *c) {
+    std::copy(x, x + weights.input_size, ws.x.data());
+    std::copy(h_prev, h_prev + weights.hidden_size, ws.h_prev.data());
+
+    lstm_gemv(weights.input.data(), weights.bias.data(), ws.x.data(), ws.proj.data(), weights.rows(),
+              weights.x_stride);
+    lstm_bsr_gemv(weights.values.data(), weights.block_col.data(), weights.block_ptr.data(), ws.proj.data(),
+                  ws.h_prev.data(), ws.gates.data(), weights.hidden_size);
+    lstm_pointwise(ws.gates.data(), c_prev, h, c, weights.hidden_size, weights.activation);
+}
+
+// LSTM sequence on the pruned weights, x_seq is seq_length x input_size row-major
+template <typename T>
+void lstm_sequence_sparse(const SparseLstmWeights<T> &weights, SparseLstmWorkspace<T> &ws,
+                          const T *x_seq, int seq_length, T *h, T *c, T *output_data) {
+    for (int t = 0; t < seq_length; t++) {
+        lstm_cell_sparse(weights, ws, x_seq + t * weights.input_size, h, c, h, c);
+    }
+
+    for (int i = 0; i < weights.input_size; i++) {
+        output_data[i] = h[i];
+    }
+}
+
+#endif // LSTM_SPARSE_H
@@ -0,0 +1,243 @@
+#ifndef LSTM_STACK_H
+#define LSTM_STACK_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "lstm_packed.h"
+
+// Stack of packed LSTM layers with a dense head, the shape of the Keras model
+// in LSTM_RNN_SW/main.py (LSTM(50) -> LSTM(50) -> Dense(5)). Layer k reads the
+// h sequence of layer k-1 and the head projects the last layer's final h to
+// output_size values, instead of reading the prediction from h[0..input_size).
+template <typename T>
+struct LstmStack {
+    std::vector<PackedLstmWeights<T>> layers;
+    int output_size;
+    int head_rows;              // output_size rounded up to 4 for lstm_gemv
+    int head_stride;            // lstm_padded(last hidden size)
+    AlignedBuffer<T> head;      // [head_rows][head_stride]
+    AlignedBuffer<T> head_bias; // [head_rows]
+
+    LstmStack() : output_size(0), head_rows(0), head_stride(0) {}
+
+    // Zeroed layers of the given hidden sizes
+    LstmStack(int input_size, const std::vector<int> &hidden_sizes, int output)
+        : output_size(output), head_rows((output + 3) / 4 * 4),
+          head_stride(lstm_padded<T>(hidden_sizes.back())),
+          head((size_t)head_rows * head_stride), head_bias(lstm_padded<T>(head_rows)) {
+        int in = input_size;
+        for (int hidden : hidden_sizes) {
+            layers.emplace_back(in, hidden);
+            in = hidden;
+        }
+    }
+
+    LstmStack(LstmStack &&other) = default;
+    LstmStack &operator=(LstmStack &&other) = default;
+
+    int num_layers() const { return (int)layers.size(); }
+    int input_size() const { return layers.front().input_size; }
+    int last_hidden() const { return layers.back().hidden_size; }
+    T *head_row(int r) { return head.data() + (size_t)r * head_stride; }
+    const T *head_row(int r) const { return head.data() + (size_t)r * head_stride; }
+
+    void set_activation(LstmActivation activation) {
+        for (auto &layer : layers) {
+            layer.activation = activation;
+        }
+    }
+
+    // The usual Xavier draws, layer by layer, then the head
+    void initialize_weights_and_biases() {
+        for (auto &layer : layers) {
+            LstmModelRuntime<T> model(layer.input_size, layer.hidden_size, 1);
+            model.initialize_weights_and_biases();
+            const LstmActivation activation = layer.activation;
+            layer = pack_lstm_weights(model);
+            layer.activation = activation;
+        }
+        for (int r = 0; r < output_size; r++) {
+            for (int j = 0; j < last_hidden(); j++) {
+                head_row(r)[j] = lstm_xavier<T>(last_hidden(), output_size);
+            }
+            head_bias[r] = lstm_xavier<T>(1, output_size);
+        }
+    }
+};
+
+// Per-thread scratch and recurrent state of every layer
+template <typename T>
+struct LstmStackState {
+    std::vector<LstmWorkspace<T>> ws;
+    std::vector<AlignedBuffer<T>> h, c;   // lstm_padded(hidden) wide, zero padded for the head
+    AlignedBuffer<T> head_out;
+
+    explicit LstmStackState(const LstmStack<T> &stack) : head_out(lstm_padded<T>(stack.head_rows)) {
+        for (const auto &layer : stack.layers) {
+            ws.emplace_back(layer);
+            h.emplace_back(lstm_padded<T>(layer.hidden_size));
+            c.emplace_back(lstm_padded<T>(layer.hidden_size));
+        }
+    }
+
+    void reset() {
+        for (size_t k = 0; k < h.size(); k++) {
+            std::fill(h[k].data(), h[k].data() + h[k].size(), T(0));
+            std::fill(c[k].data(), c[k].data() + c[k].size(), T(0));
+        }
+    }
+};
+
+// Dense head on the last layer's h
+template <typename T>
+inline void lstm_stack_head(const LstmStack<T> &stack, LstmStackState<T> &state, T *output) {
+    lstm_gemv(stack.head.data(), stack.head_bias.data(), state.h.back().data(), state.head_out.data(),
+              stack.head_rows, stack.head_stride);
+    for (int r = 0; r < stack.output_size; r++) {
+        output[r] = state.head_out[r];
+    }
+}
+
+// Layer-major reference: each step runs every layer in turn, state carries
+// over from the previous call as in lstm_sequence_packed
+template <typename T>
+void lstm_stack_sequence(const LstmStack<T> &stack, LstmStackState<T> &state, const T *x_seq, int seq_length,
+                         T *output) {
+    const int in = stack.input_size();
+    for (int t = 0; t < seq_length; t++) {
+        const T *x = x_seq + (size_t)t * in;
+        for (int k = 0; k < stack.num_layers(); k++) {
+            lstm_cell_packed(stack.layers[k], state.ws[k], x, state.h[k].data(), state.c[k].data(),
+                             state.h[k].data(), state.c[k].data());
+            x = state.h[k].data();
+        }
+    }
+    lstm_stack_head(stack, state, output);
+}
+
+// Wavefront execution of the stack: layer k runs on its own thread (layer 0 on
+// the caller) and starts step t as soon as layer k-1 has published its h for
+// step t, so layer k at step t overlaps layer k+1 at step t-1. Each layer keeps
+// its h sequence for the call, and a per-layer step counter (release/acquire)
+// is the only synchronization inside a sequence. Results are bit-identical to
+// lstm_stack_sequence.
+template <typename T>
+class LstmStackPipeline {
+public:
+    LstmStackPipeline(const LstmStack<T> &stack, int max_seq_length)
+        : stack_(stack), state_(stack), seq_(stack.num_layers()), done_(new std::atomic<int>[stack.num_layers()]),
+          max_seq_length_(max_seq_length), x_seq_(nullptr), seq_length_(0), generation_(0), stop_(false) {
+        for (int k = 0; k < stack.num_layers(); k++) {
+            seq_[k] = AlignedBuffer<T>((size_t)max_seq_length * stack.layers[k].hidden_size);
+            done_[k].store(0);
+        }
+        for (int k = 1; k < stack.num_layers(); k++) {
+            workers_.emplace_back(&LstmStackPipeline::worker_loop, this, k);
+        }
+    }
+
+    ~LstmStackPipeline() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    LstmStackPipeline(const LstmStackPipeline &) = delete;
+    LstmStackPipeline &operator=(const LstmStackPipeline &) = delete;
+
+    LstmStackState<T> &state() { return state_; }
+
+    // Same contract as lstm_stack_sequence. False, with nothing run, when
+    // seq_length is outside [0, max_seq_length] and the per-layer buffers
+    // cannot hold it.
+    bool run(const T *x_seq, int seq_length, T *output) {
+        if (seq_length < 0 || seq_length > max_seq_length_) {
+            return false;
+        }
+        for (int k = 0; k < stack_.num_layers(); k++) {
+            done_[k].store(0, std::memory_order_relaxed);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            x_seq_ = x_seq;
+            seq_length_ = seq_length;
+            generation_++;
+        }
+        wake_.notify_all();
+
+        run_layer(0);
+        const int last = stack_.num_layers() - 1;
+        wait_for(last, seq_length);
+        lstm_stack_head(stack_, state_, output);
+        return true;
+    }
+
+private:
+    void wait_for(int layer, int steps) {
+        for (int spins = 0; done_[layer].load(std::memory_order_acquire) < steps;) {
+            if (spins < 64) {
+                spins++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void run_layer(int k) {
+        const PackedLstmWeights<T> &layer = stack_.layers[k];
+        const int hidden = layer.hidden_size;
+        T *h = state_.h[k].data(), *c = state_.c[k].data();
+        for (int t = 0; t < seq_length_; t++) {
+            const T *x;
+            if (k == 0) {
+                x = x_seq_ + (size_t)t * layer.input_size;
+            } else {
+                wait_for(k - 1, t + 1);
+                x = seq_[k - 1].data() + (size_t)t * layer.input_size;
+            }
+            lstm_cell_packed(layer, state_.ws[k], x, h, c, h, c);
+            std::copy(h, h + hidden, seq_[k].data() + (size_t)t * hidden);
+            done_[k].store(t + 1, std::memory_order_release);
+        }
+    }
+
+    void worker_loop(int k) {
+        long seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                if (stop_) {
+                    return;
+                }
+                seen = generation_;
+            }
+            run_layer(k);
+        }
+    }
+
+    const LstmStack<T> &stack_;
+    LstmStackState<T> state_;
+    std::vector<AlignedBuffer<T>> seq_;              // [max_seq][hidden] h of every step, per layer
+    std::unique_ptr<std::atomic<int>[]> done_;      // steps layer k has published this call
+    std::vector<std::thread> workers_;
+    const int max_seq_length_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    const T *x_seq_;
+    int seq_length_;
+    long generation_;    // bumped by run(), guarded by mutex_
+    bool stop_;
+};
+
+#endif // LSTM_STACK_H
@@ -0,0 +1,105 @@
+#ifndef LSTM_STREAM_H
+#define LSTM_STREAM_H
+
+#include <algorithm>
+#include <vector>
+#include "lstm_batch.h"
+
+// Stateful streaming inference: push(bar) runs exactly one lstm_cell step on
+// the persistent h/c and returns the prediction, instead of rerunning a full
+// SEQ_LENGTH window per bar like the testbench loop.
+
+// What happens to the recurrent state as the stream grows
+enum LstmResetPolicy {
+    LSTM_RESET_NEVER = 0,     // carry h/c forever
+    LSTM_RESET_PERIODIC = 1,  // zero h/c every window bars
+    LSTM_RESET_STAGGERED = 2  // two states offset by window/2, each reset every window bars;
+                              // predictions come from the older one, so history is bounded
+                              // to [window/2, window) bars at two cell steps per bar
+};
+
+struct LstmStreamConfig {
+    LstmResetPolicy policy;
+    int window;   // bars between resets (PERIODIC/STAGGERED)
+    int warmup;   // bars a state must have seen before its prediction is reported ready
+
+    LstmStreamConfig() : policy(LSTM_RESET_NEVER), window(0), warmup(0) {}
+    LstmStreamConfig(LstmResetPolicy p, int w, int warm) : policy(p), window(w), warmup(warm) {}
+};
+
+template <typename T>
+class LstmStream {
+public:
+    LstmStream(const PackedLstmWeights<T> &weights, const LstmStreamConfig &config)
+        : weights_(weights), config_(config), ws_(weights, 2),
+          h_(2 * weights.hidden_size), c_(2 * weights.hidden_size), bars_(0) {
+        if (config_.policy != LSTM_RESET_NEVER && config_.window < 2) {
+            config_.window = 2;
+        }
+        reset();
+    }
+
+    // Zero both states and restart the bar count
+    void reset() {
+        std::fill(h_.begin(), h_.end(), T(0));
+        std::fill(c_.begin(), c_.end(), T(0));
+        age_[0] = age_[1] = 0;
+        bars_ = 0;
+    }
+
+    // Advance one bar (input_size values) and write the input_size prediction.
+    // Returns false while the reporting state is still inside its warmup.
+    bool push(const T *bar, T *prediction) {
+        const int hid = weights_.hidden_size;
+        int lanes = 1;
+
+        if (config_.policy == LSTM_RESET_STAGGERED && bars_ >= config_.window / 2) {
+            lanes = 2;
+        }
+        if (config_.policy != LSTM_RESET_NEVER) {
+            for (int l = 0; l < lanes; l++) {
+                if (age_[l] >= config_.window) {
+                    clear_lane(l);
+                }
+            }
+        }
+
+        // Both lanes see the same bar, so one batched step serves them
+        const int in = weights_.input_size;
+        lstm_cell_batch(weights_, ws_, bar, 0, h_.data(), c_.data(), lanes);
+
+        for (int l = 0; l < lanes; l++) {
+            age_[l]++;
+        }
+        bars_++;
+
+        const int active = (lanes == 2 && age_[1] > age_[0]) ? 1 : 0;
+        const T *h = &h_[active * hid];
+        std::copy(h, h + in, prediction);
+        return age_[active] >= config_.warmup;
+    }
+
+    long bars() const { return bars_; }
+    const T *hidden() const { return &h_[active_lane() * weights_.hidden_size]; }
+    const T *cell() const { return &c_[active_lane() * weights_.hidden_size]; }
+
+private:
+    int active_lane() const { return age_[1] > age_[0] ? 1 : 0; }
+
+    void clear_lane(int lane) {
+        const int hid = weights_.hidden_size;
+        std::fill(h_.begin() + lane * hid, h_.begin() + (lane + 1) * hid, T(0));
+        std::fill(c_.begin() + lane * hid, c_.begin() + (lane + 1) * hid, T(0));
+        age_[lane] = 0;
+    }
+
+    const PackedLstmWeights<T> &weights_;
+    LstmStreamConfig config_;
+    LstmBatchWorkspace<T> ws_;
+    std::vector<T> h_;  // [2][hidden]
+    std::vector<T> c_;  // [2][hidden]
+    int age_[2];        // bars since each lane was last reset
+    long bars_;
+};
+
+#endif // LSTM_STREAM_H
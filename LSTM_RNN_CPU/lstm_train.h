@@ -0,0 +1,299 @@
+#ifndef LSTM_TRAIN_H
+#define LSTM_TRAIN_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "lstm_packed.h"
+#include "thread_pool.h"
+
+// Native training of the packed LSTM. Every window of seq_length bars predicts
+// the bar after it through h[0..input_size), as in the inference engines, and
+// the loss is the mean squared error of that prediction. Gradients flow back
+// bptt steps from the prediction (truncated BPTT). A minibatch is split across
+// the pool: each worker runs forward/backward for its windows into its own
+// gradient block, then one parallel pass sums the blocks and applies Adam.
+//
+// The model trained is the LSTM_RNN_HW kernel's: each step updates h in place
+// (lstm_cell_packed_inplace), so unit i sees the new h[0..i) and the backward
+// pass walks the units of a step in reverse. With carry_state, window s starts
+// from the state window s - 1 ended in, as the rolling forecast of lstm_cpu and
+// the testbench carries h/c from day to day. These start states are recomputed
+// by carry_states() and get no gradient.
+//
+// The gradient and Adam moments share the PackedLstmWeights storage layout, so
+// the optimizer is one flat loop over [4*hidden][stride] + bias and the trained
+// weights are ready for save_lstm_weights/save_packed_lstm_weights. Padding
+// columns see zero inputs and therefore stay zero.
+
+struct LstmTrainConfig {
+    int seq_length;
+    int bptt;              // steps the gradient flows back, 0 or >= seq_length for the whole window
+    double learning_rate;
+    double beta1;
+    double beta2;
+    double epsilon;
+    bool carry_state;      // start each window from the previous window's final state, else from zero
+
+    LstmTrainConfig()
+        : seq_length(60), bptt(0), learning_rate(1e-3), beta1(0.9), beta2(0.999), epsilon(1e-8),
+          carry_state(true) {}
+};
+
+template <typename T>
+class LstmTrainer {
+public:
+    // weights must own its storage (pack or copy a mapped file first)
+    LstmTrainer(PackedLstmWeights<T> &weights, const LstmTrainConfig &config, ThreadPool &pool)
+        : weights_(weights), config_(config), pool_(pool), steps_(0), state_windows_(0),
+          m_(weights.storage.size()), v_(weights.storage.size()) {
+        if (config_.bptt <= 0 || config_.bptt > config_.seq_length) {
+            config_.bptt = config_.seq_length;
+        }
+        for (int i = 0; i < pool_.size(); i++) {
+            workers_.emplace_back(new Worker(weights_, config_.bptt));
+        }
+    }
+
+    // One Adam step on the windows starting at starts[0..count) of series
+    // ([rows][input_size]); returns their mean squared error
+    double step(const T *series, const long *starts, int count) {
+        const int threads = pool_.size();
+        const long grain = (count + threads - 1) / threads;
+        const T scale = T(1) / T(count);
+
+        for (auto &worker : workers_) {
+            worker->loss = 0.0;
+        }
+        parallel_for(pool_, 0, count, grain, [&](int worker, long lo, long hi) {
+            Worker &w = *workers_[worker];
+            for (long k = lo; k < hi; k++) {
+                w.loss += backward(w, series, starts[k], scale);
+            }
+        });
+
+        double loss = 0.0;
+        for (auto &worker : workers_) {
+            loss += worker->loss;
+        }
+
+        // Sum the worker gradients, clear them for the next batch and update
+        steps_++;
+        const double lr = config_.learning_rate * std::sqrt(1.0 - std::pow(config_.beta2, (double)steps_)) /
+                          (1.0 - std::pow(config_.beta1, (double)steps_));
+        const long n = (long)weights_.storage.size();
+        parallel_for(pool_, 0, n, (n + threads - 1) / threads, [&](int, long lo, long hi) {
+            adam_update(lo, hi, lr);
+        });
+        return loss / count;
+    }
+
+    // Mean squared error of the windows without touching the weights
+    double evaluate(const T *series, const long *starts, long count) {
+        if (count <= 0) {
+            return 0.0;
+        }
+        const int threads = pool_.size();
+        for (auto &worker : workers_) {
+            worker->loss = 0.0;
+        }
+        parallel_for(pool_, 0, count, (count + threads - 1) / threads, [&](int worker, long lo, long hi) {
+            Worker &w = *workers_[worker];
+            for (long k = lo; k < hi; k++) {
+                w.loss += forward(w, series, starts[k], false);
+            }
+        });
+        double loss = 0.0;
+        for (auto &worker : workers_) {
+            loss += worker->loss;
+        }
+        return loss / count;
+    }
+
+    // Start states of the windows [0, windows) of series under the current
+    // weights: window 0 starts from zero, window s from the end of window s - 1.
+    // Sequential, one pass over every window; a no-op without carry_state.
+    void carry_states(const T *series, long windows) {
+        if (!config_.carry_state) {
+            return;
+        }
+        const int in = weights_.input_size, hidden = weights_.hidden_size;
+        Worker &w = *workers_[0];
+        state_h_.assign((size_t)windows * hidden, T(0));
+        state_c_.assign((size_t)windows * hidden, T(0));
+        std::fill(w.h.begin(), w.h.end(), T(0));
+        std::fill(w.c.begin(), w.c.end(), T(0));
+        for (long s = 0; s < windows; s++) {
+            std::copy(w.h.begin(), w.h.end(), state_h_.begin() + (size_t)s * hidden);
+            std::copy(w.c.begin(), w.c.end(), state_c_.begin() + (size_t)s * hidden);
+            for (int t = 0; t < config_.seq_length; t++) {
+                lstm_cell_packed_inplace(weights_, w.ws, series + (size_t)(s + t) * in, w.h.data(), w.c.data());
+            }
+        }
+        state_windows_ = windows;
+    }
+
+    long steps() const { return steps_; }
+
+private:
+    struct Worker {
+        LstmWorkspace<T> ws;
+        AlignedBuffer<T> grad;     // same layout as the weight storage
+        AlignedBuffer<T> gates;    // [bptt][4*hidden] gate activations
+        std::vector<T> hiddens;    // [bptt + 1][hidden] h before each tracked step, then the final h
+        std::vector<T> cells;      // [bptt + 1][hidden] c before each tracked step, then the final c
+        std::vector<T> h, c, dh, dh_prev, dc, dgates;
+        double loss;
+
+        Worker(const PackedLstmWeights<T> &weights, int bptt)
+            : ws(weights), grad(weights.storage.size()), gates((size_t)bptt * weights.rows()),
+              hiddens((size_t)(bptt + 1) * weights.hidden_size), cells((size_t)(bptt + 1) * weights.hidden_size),
+              h(weights.hidden_size), c(weights.hidden_size), dh(weights.hidden_size),
+              dh_prev(weights.hidden_size), dc(weights.hidden_size), dgates(weights.rows()), loss(0.0) {}
+    };
+
+    // Run the window starting at row start from its start state, keeping the
+    // last bptt steps when track is set; returns the squared error against the
+    // bar after the window
+    double forward(Worker &w, const T *series, long start, bool track) {
+        const int in = weights_.input_size, hidden = weights_.hidden_size, rows = weights_.rows();
+        const int seq = config_.seq_length, first = seq - config_.bptt;
+        const T *x_seq = series + start * in;
+        if (config_.carry_state && start < state_windows_) {
+            std::copy(state_h_.begin() + (size_t)start * hidden, state_h_.begin() + (size_t)(start + 1) * hidden,
+                      w.h.begin());
+            std::copy(state_c_.begin() + (size_t)start * hidden, state_c_.begin() + (size_t)(start + 1) * hidden,
+                      w.c.begin());
+        } else {
+            std::fill(w.h.begin(), w.h.end(), T(0));
+            std::fill(w.c.begin(), w.c.end(), T(0));
+        }
+
+        for (int t = 0; t < seq; t++) {
+            const int k = t - first;
+            if (track && k >= 0) {
+                std::copy(w.h.begin(), w.h.end(), w.hiddens.begin() + (size_t)k * hidden);
+                std::copy(w.c.begin(), w.c.end(), w.cells.begin() + (size_t)k * hidden);
+            }
+            lstm_cell_packed_inplace(weights_, w.ws, x_seq + (size_t)t * in, w.h.data(), w.c.data());
+            if (track && k >= 0) {
+                std::copy(w.ws.gates.data(), w.ws.gates.data() + rows, w.gates.data() + (size_t)k * rows);
+            }
+        }
+        if (track) {
+            std::copy(w.h.begin(), w.h.end(), w.hiddens.begin() + (size_t)config_.bptt * hidden);
+            std::copy(w.c.begin(), w.c.end(), w.cells.begin() + (size_t)config_.bptt * hidden);
+        }
+
+        const T *target = x_seq + (size_t)seq * in;
+        double loss = 0.0;
+        for (int j = 0; j < in; j++) {
+            const double e = double(w.h[j]) - double(target[j]);
+            loss += e * e;
+        }
+        return loss / in;
+    }
+
+    // Forward plus truncated BPTT of one window into w.grad, gradients scaled by scale
+    double backward(Worker &w, const T *series, long start, T scale) {
+        const int in = weights_.input_size, hidden = weights_.hidden_size, rows = weights_.rows();
+        const int stride = weights_.stride;
+        const T *x_seq = series + start * in;
+        const double loss = forward(w, series, start, true);
+
+        // d(loss)/dh of the prediction, nothing flows into c from the loss
+        const T *target = x_seq + (size_t)config_.seq_length * in;
+        std::fill(w.dh.begin(), w.dh.end(), T(0));
+        std::fill(w.dc.begin(), w.dc.end(), T(0));
+        for (int j = 0; j < in; j++) {
+            w.dh[j] = T(2) * (w.h[j] - target[j]) * scale / T(in);
+        }
+
+        T *grad = w.grad.data();
+        T *grad_bias = grad + (size_t)rows * stride;
+        T *dg = w.dgates.data();
+        const int first = config_.seq_length - config_.bptt;
+        for (int k = config_.bptt - 1; k >= 0; k--) {
+            const T *g = w.gates.data() + (size_t)k * rows;
+            const T *c_prev = w.cells.data() + (size_t)k * hidden;
+            const T *c_now = c_prev + hidden;
+            const T *h_prev = w.hiddens.data() + (size_t)k * hidden;
+            const T *h_now = h_prev + hidden;
+            const T *x = x_seq + (size_t)(first + k) * in;
+
+            // Unit i read h_now[0..i) and h_prev[i..hidden), so w.dh[i] (for
+            // h_now) is complete once the units after it have been handled
+            std::fill(w.dh_prev.begin(), w.dh_prev.end(), T(0));
+            T *dh = w.dh.data();
+            T *dh_prev = w.dh_prev.data();
+            for (int i = hidden - 1; i >= 0; i--) {
+                const T ig = g[LSTM_GATES * i + LSTM_GATE_I], fg = g[LSTM_GATES * i + LSTM_GATE_F];
+                const T cg = g[LSTM_GATES * i + LSTM_GATE_C], og = g[LSTM_GATES * i + LSTM_GATE_O];
+                const T tc = std::tanh(c_now[i]);
+
+                // The cell clip passes no gradient once it saturates
+                T dct = w.dc[i] + w.dh[i] * og * (T(1) - tc * tc);
+                if (c_now[i] >= T(LSTM_CELL_CLIP) || c_now[i] <= T(-LSTM_CELL_CLIP)) {
+                    dct = T(0);
+                }
+                dg[LSTM_GATES * i + LSTM_GATE_I] = dct * cg * ig * (T(1) - ig);
+                dg[LSTM_GATES * i + LSTM_GATE_F] = dct * c_prev[i] * fg * (T(1) - fg);
+                dg[LSTM_GATES * i + LSTM_GATE_C] = dct * ig * (T(1) - cg * cg);
+                dg[LSTM_GATES * i + LSTM_GATE_O] = w.dh[i] * tc * og * (T(1) - og);
+                w.dc[i] = dct * fg;
+
+                // Outer product with the unit's [x | 0 | h_now[0..i) h_prev[i..) | 0]
+                // row, and U^T dgates back into whichever h each column read
+                for (int r = LSTM_GATES * i; r < LSTM_GATES * (i + 1); r++) {
+                    const T d = dg[r];
+                    T *grad_row = grad + (size_t)r * stride;
+                    for (int j = 0; j < in; j++) {
+                        grad_row[j] += d * x[j];
+                    }
+                    grad_bias[r] += d;
+
+                    const T *U = weights_.weights + (size_t)r * stride + weights_.x_stride;
+                    T *grad_u = grad_row + weights_.x_stride;
+                    for (int j = 0; j < i; j++) {
+                        grad_u[j] += d * h_now[j];
+                        dh[j] += d * U[j];
+                    }
+                    for (int j = i; j < hidden; j++) {
+                        grad_u[j] += d * h_prev[j];
+                        dh_prev[j] += d * U[j];
+                    }
+                }
+            }
+            w.dh.swap(w.dh_prev);
+        }
+        return loss;
+    }
+
+    void adam_update(long lo, long hi, double lr) {
+        T *params = weights_.storage.data();
+        const T beta1 = T(config_.beta1), beta2 = T(config_.beta2);
+        const T step = T(lr), epsilon = T(config_.epsilon);
+        for (long i = lo; i < hi; i++) {
+            T g = T(0);
+            for (auto &worker : workers_) {
+                g += worker->grad[i];
+                worker->grad[i] = T(0);
+            }
+            m_[i] = beta1 * m_[i] + (T(1) - beta1) * g;
+            v_[i] = beta2 * v_[i] + (T(1) - beta2) * g * g;
+            params[i] -= step * m_[i] / (std::sqrt(v_[i]) + epsilon);
+        }
+    }
+
+    PackedLstmWeights<T> &weights_;
+    LstmTrainConfig config_;
+    ThreadPool &pool_;
+    long steps_;
+    long state_windows_;          // windows with a start state in state_h_/state_c_
+    std::vector<T> state_h_, state_c_;    // [window][hidden] start states from carry_states
+    AlignedBuffer<T> m_, v_;      // Adam moments, same layout as the weight storage
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
+
+#endif // LSTM_TRAIN_H
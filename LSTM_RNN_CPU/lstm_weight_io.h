@@ -0,0 +1,273 @@
+#ifndef LSTM_WEIGHT_IO_H
+#define LSTM_WEIGHT_IO_H
+
+#include <string>
+#include <vector>
+#include "lstm_activation.h"
+#include "lstm_model.h"
+#include "lstm_packed.h"
+#include "lstm_stack.h"
+#include "weight_file.h"
+
+// LSTM models in and out of the weight container. The split layout stores the
+// twelve W_g/U_g/b_g tensors as named in lstm_rnn.h (W_i, U_i, b_i, ...); the
+// packed layout stores the PackedLstmWeights block and its bias so a matching
+// engine can run straight from the mapping.
+
+inline std::string lstm_tensor_name(char kind, int gate) {
+    return std::string(1, kind) + "_" + WEIGHT_GATE_ORDER[gate];
+}
+
+// Read gate g of either layout into dense W [hidden][in], U [hidden][hidden], b [hidden]
+template <typename T>
+bool read_lstm_gate(const WeightFile &file, int gate, T *W, T *U, T *b) {
+    const WeightHeader &header = file.header();
+    const int in = header.input_size, hidden = header.hidden_size;
+    if (header.layout == WEIGHT_LAYOUT_SPLIT) {
+        return file.copy(lstm_tensor_name('W', gate).c_str(), W, hidden, in) &&
+               file.copy(lstm_tensor_name('U', gate).c_str(), U, hidden, hidden) &&
+               file.copy(lstm_tensor_name('b', gate).c_str(), b, 1, hidden);
+    }
+
+    const int stride = header.x_stride + header.h_stride;
+    std::vector<double> packed((size_t)LSTM_GATES * hidden * stride), bias(LSTM_GATES * hidden);
+    if (!file.copy("packed", packed.data(), LSTM_GATES * hidden, stride) ||
+        !file.copy("bias", bias.data(), 1, LSTM_GATES * hidden)) {
+        return false;
+    }
+    for (int i = 0; i < hidden; i++) {
+        const double *row = &packed[(size_t)(LSTM_GATES * i + gate) * stride];
+        for (int j = 0; j < in; j++) {
+            W[i * in + j] = T(row[j]);
+        }
+        for (int j = 0; j < hidden; j++) {
+            U[i * hidden + j] = T(row[header.x_stride + j]);
+        }
+        b[i] = T(bias[LSTM_GATES * i + gate]);
+    }
+    return true;
+}
+
+// The activation tier a weight file records, false when the value is out of
+// range or names a tier this build cannot run
+inline bool weight_file_activation(const WeightHeader &header, LstmActivation &act) {
+    if (header.activation >= LSTM_ACT_COUNT || !lstm_activation_available(LstmActivation(header.activation))) {
+        std::cerr << "Error: Weight file asks for activation tier " << header.activation << " ("
+                  << (header.activation < LSTM_ACT_COUNT ? lstm_activation_name(LstmActivation(header.activation))
+                                                         : "unknown")
+                  << "), which this build cannot run" << std::endl;
+        return false;
+    }
+    act = LstmActivation(header.activation);
+    return true;
+}
+
+// Check the file holds an LSTM of the expected shape (0 accepts any hidden size
+// that the prediction, read from h[0..input_size), fits in)
+inline bool check_lstm_weight_file(const WeightFile &file, int input_size, int hidden_size) {
+    const WeightHeader &header = file.header();
+    if (header.model != WEIGHT_MODEL_LSTM || (int)header.input_size != input_size ||
+        (int)header.hidden_size < input_size || (hidden_size > 0 && (int)header.hidden_size != hidden_size)) {
+        std::cerr << "Error: Weight file holds model " << header.model << " with input " << header.input_size
+                  << ", hidden " << header.hidden_size << "; expected an LSTM with input " << input_size;
+        if (hidden_size > 0) {
+            std::cerr << ", hidden " << hidden_size;
+        }
+        std::cerr << std::endl;
+        return false;
+    }
+    LstmActivation activation;
+    return weight_file_activation(header, activation);
+}
+
+template <int In, int Hidden, int Seq, typename T>
+bool load_lstm_weights(const WeightFile &file, LstmModel<In, Hidden, Seq, T> &model) {
+    return check_lstm_weight_file(file, In, Hidden) &&
+           read_lstm_gate(file, LSTM_GATE_I, &model.W_i[0][0], &model.U_i[0][0], model.b_i) &&
+           read_lstm_gate(file, LSTM_GATE_F, &model.W_f[0][0], &model.U_f[0][0], model.b_f) &&
+           read_lstm_gate(file, LSTM_GATE_C, &model.W_c[0][0], &model.U_c[0][0], model.b_c) &&
+           read_lstm_gate(file, LSTM_GATE_O, &model.W_o[0][0], &model.U_o[0][0], model.b_o);
+}
+
+template <typename T>
+bool load_lstm_weights(const WeightFile &file, LstmModelRuntime<T> &model) {
+    return check_lstm_weight_file(file, model.input_size, model.hidden_size) &&
+           read_lstm_gate(file, LSTM_GATE_I, model.W_i.data(), model.U_i.data(), model.b_i.data()) &&
+           read_lstm_gate(file, LSTM_GATE_F, model.W_f.data(), model.U_f.data(), model.b_f.data()) &&
+           read_lstm_gate(file, LSTM_GATE_C, model.W_c.data(), model.U_c.data(), model.b_c.data()) &&
+           read_lstm_gate(file, LSTM_GATE_O, model.W_o.data(), model.U_o.data(), model.b_o.data());
+}
+
+// Packed weights for the CPU engines. A packed file in the engine's dtype and
+// padding is used in place (the WeightFile must then outlive the result);
+// anything else is repacked into owned storage.
+template <typename T>
+bool load_packed_lstm_weights(const WeightFile &file, int input_size, PackedLstmWeights<T> &packed) {
+    if (!check_lstm_weight_file(file, input_size, 0)) {
+        return false;
+    }
+    const WeightHeader &header = file.header();
+    const int in = header.input_size, hidden = header.hidden_size;
+
+    if (header.layout == WEIGHT_LAYOUT_PACKED && (int)header.x_stride == lstm_padded<T>(in) &&
+        (int)header.h_stride == lstm_padded<T>(hidden)) {
+        const int stride = header.x_stride + header.h_stride;
+        const T *weights = file.tensor<T>("packed", LSTM_GATES * hidden, stride);
+        const T *bias = file.tensor<T>("bias", 1, LSTM_GATES * hidden);
+        if (weights && bias) {
+            packed = PackedLstmWeights<T>();
+            packed.input_size = in;
+            packed.hidden_size = hidden;
+            packed.x_stride = header.x_stride;
+            packed.h_stride = header.h_stride;
+            packed.stride = stride;
+            packed.weights = weights;
+            packed.bias = bias;
+            packed.activation = LstmActivation(header.activation);
+            return true;
+        }
+    }
+
+    packed = PackedLstmWeights<T>(in, hidden);
+    packed.activation = LstmActivation(header.activation);
+    std::vector<T> W((size_t)hidden * in), U((size_t)hidden * hidden), b(hidden);
+    for (int gate = 0; gate < LSTM_GATES; gate++) {
+        if (!read_lstm_gate(file, gate, W.data(), U.data(), b.data())) {
+            return false;
+        }
+        packed.set_gate(gate, W.data(), U.data(), b.data());
+    }
+    return true;
+}
+
+// Write the twelve gate tensors in the split layout (pack either model first),
+// optionally recording the ap_fixed<fixed_width, fixed_int> format they are exact in
+template <typename T>
+bool save_lstm_weights(const std::string &file_name, const PackedLstmWeights<T> &packed,
+                       WeightDtype dtype = WEIGHT_F64, int fixed_width = 0, int fixed_int = 0) {
+    const int in = packed.input_size, hidden = packed.hidden_size;
+    WeightFileWriter writer(WEIGHT_MODEL_LSTM, dtype, WEIGHT_LAYOUT_SPLIT, in, hidden, in);
+    writer.set_activation(packed.activation);
+    writer.set_fixed_format(fixed_width, fixed_int);
+    std::vector<T> b(hidden);
+    bool ok = true;
+    for (int gate = 0; gate < LSTM_GATES && ok; gate++) {
+        // Rows of one gate are LSTM_GATES rows apart in the packed block
+        const T *first = packed.weights + (size_t)gate * packed.stride;
+        for (int i = 0; i < hidden; i++) {
+            b[i] = packed.bias[LSTM_GATES * i + gate];
+        }
+        ok = writer.add(lstm_tensor_name('W', gate).c_str(), first, hidden, in, LSTM_GATES * packed.stride) &&
+             writer.add(lstm_tensor_name('U', gate).c_str(), first + packed.x_stride, hidden, hidden,
+                        LSTM_GATES * packed.stride) &&
+             writer.add(lstm_tensor_name('b', gate).c_str(), b.data(), 1, hidden);
+    }
+    return ok && writer.save(file_name);
+}
+
+// Write the packed block, padded for element type E so engines of that type can map it
+template <typename E, typename T>
+bool save_packed_lstm_weights(const std::string &file_name, const PackedLstmWeights<T> &packed) {
+    const WeightDtype dtype = sizeof(E) == sizeof(float) ? WEIGHT_F32 : WEIGHT_F64;
+    const int in = packed.input_size, hidden = packed.hidden_size;
+    const int x_stride = lstm_padded<E>(in), h_stride = lstm_padded<E>(hidden);
+
+    std::vector<T> rows((size_t)LSTM_GATES * hidden * (x_stride + h_stride), T(0));
+    for (int r = 0; r < LSTM_GATES * hidden; r++) {
+        const T *src = packed.weights + (size_t)r * packed.stride;
+        T *dst = &rows[(size_t)r * (x_stride + h_stride)];
+        for (int j = 0; j < in; j++) {
+            dst[j] = src[j];
+        }
+        for (int j = 0; j < hidden; j++) {
+            dst[x_stride + j] = src[packed.x_stride + j];
+        }
+    }
+
+    WeightFileWriter writer(WEIGHT_MODEL_LSTM, dtype, WEIGHT_LAYOUT_PACKED, in, hidden, in);
+    writer.set_strides(x_stride, h_stride);
+    writer.set_activation(packed.activation);
+    return writer.add("packed", rows.data(), LSTM_GATES * hidden, x_stride + h_stride) &&
+           writer.add("bias", packed.bias, 1, LSTM_GATES * hidden) && writer.save(file_name);
+}
+
+// LSTM stacks keep each layer's rows in packed order (row 4*i+g is gate g of
+// unit i): "lK.W" [4*hidden][in], "lK.U" [4*hidden][hidden] and "lK.b"
+// [1][4*hidden] for layer K, then "head.W" [output][hidden] and "head.b".
+// The header's input_size and output_size are the stack's, hidden_size is the
+// last layer's; the layer count and sizes come from the tensor directory.
+inline std::string lstm_stack_tensor_name(int layer, char kind) {
+    return "l" + std::to_string(layer) + "." + std::string(1, kind);
+}
+
+template <typename T>
+bool save_lstm_stack(const std::string &file_name, const LstmStack<T> &stack, WeightDtype dtype = WEIGHT_F64) {
+    const int in = stack.input_size(), out = stack.output_size;
+    WeightFileWriter writer(WEIGHT_MODEL_LSTM_STACK, dtype, WEIGHT_LAYOUT_SPLIT, in, stack.last_hidden(), out);
+    writer.set_activation(stack.layers.front().activation);
+    bool ok = true;
+    for (int k = 0; k < stack.num_layers() && ok; k++) {
+        const PackedLstmWeights<T> &layer = stack.layers[k];
+        ok = writer.add(lstm_stack_tensor_name(k, 'W').c_str(), layer.weights, layer.rows(), layer.input_size,
+                        layer.stride) &&
+             writer.add(lstm_stack_tensor_name(k, 'U').c_str(), layer.weights + layer.x_stride, layer.rows(),
+                        layer.hidden_size, layer.stride) &&
+             writer.add(lstm_stack_tensor_name(k, 'b').c_str(), layer.bias, 1, layer.rows());
+    }
+    ok = ok && writer.add("head.W", stack.head.data(), out, stack.last_hidden(), stack.head_stride) &&
+         writer.add("head.b", stack.head_bias.data(), 1, out);
+    return ok && writer.save(file_name);
+}
+
+template <typename T>
+bool load_lstm_stack(const WeightFile &file, LstmStack<T> &stack) {
+    const WeightHeader &header = file.header();
+    if (header.model != WEIGHT_MODEL_LSTM_STACK) {
+        std::cerr << "Error: Weight file holds model " << header.model << ", expected an LSTM stack" << std::endl;
+        return false;
+    }
+    LstmActivation activation;
+    if (!weight_file_activation(header, activation)) {
+        return false;
+    }
+
+    std::vector<int> hidden_sizes;
+    for (int k = 0; file.find(lstm_stack_tensor_name(k, 'U').c_str()); k++) {
+        hidden_sizes.push_back(file.find(lstm_stack_tensor_name(k, 'U').c_str())->cols);
+    }
+    if (hidden_sizes.empty() || hidden_sizes.back() != (int)header.hidden_size) {
+        std::cerr << "Error: Weight file has no layers matching hidden size " << header.hidden_size << std::endl;
+        return false;
+    }
+
+    stack = LstmStack<T>(header.input_size, hidden_sizes, header.output_size);
+    stack.set_activation(activation);
+    for (int k = 0; k < stack.num_layers(); k++) {
+        PackedLstmWeights<T> &layer = stack.layers[k];
+        const int rows = layer.rows();
+        std::vector<T> W((size_t)rows * layer.input_size), U((size_t)rows * layer.hidden_size);
+        if (!file.copy(lstm_stack_tensor_name(k, 'W').c_str(), W.data(), rows, layer.input_size) ||
+            !file.copy(lstm_stack_tensor_name(k, 'U').c_str(), U.data(), rows, layer.hidden_size) ||
+            !file.copy(lstm_stack_tensor_name(k, 'b').c_str(), layer.bias_data(), 1, rows)) {
+            return false;
+        }
+        for (int r = 0; r < rows; r++) {
+            T *dst = layer.storage.data() + (size_t)r * layer.stride;
+            std::copy(&W[(size_t)r * layer.input_size], &W[(size_t)(r + 1) * layer.input_size], dst);
+            std::copy(&U[(size_t)r * layer.hidden_size], &U[(size_t)(r + 1) * layer.hidden_size],
+                      dst + layer.x_stride);
+        }
+    }
+
+    const int out = stack.output_size, hidden = stack.last_hidden();
+    std::vector<T> head((size_t)out * hidden);
+    if (!file.copy("head.W", head.data(), out, hidden) || !file.copy("head.b", stack.head_bias.data(), 1, out)) {
+        return false;
+    }
+    for (int r = 0; r < out; r++) {
+        std::copy(&head[(size_t)r * hidden], &head[(size_t)(r + 1) * hidden], stack.head_row(r));
+    }
+    return true;
+}
+
+#endif // LSTM_WEIGHT_IO_H
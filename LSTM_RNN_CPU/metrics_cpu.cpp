@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "prediction_metrics.h"
+
+// Native replacement for calculateAccuracy.py. The real file and every
+// prediction file are read one line at a time in lockstep and each row goes
+// straight into a PredictionMetrics, so memory stays flat however long the
+// files are. Values may be separated by spaces or commas, as in the
+// outputs_*.txt files. The previous real row scores the direction of each
+// prediction.
+
+// Next row of a text file; false at the end of the file
+static bool read_row(std::istream &file, std::vector<double> &row) {
+    std::string line;
+    while (std::getline(file, line)) {
+        row.clear();
+        const char *p = line.c_str();
+        char *end;
+        for (;;) {
+            while (*p == ' ' || *p == ',' || *p == '\t' || *p == '\r') {
+                p++;
+            }
+            if (*p == '\0') {
+                break;
+            }
+            const double value = std::strtod(p, &end);
+            if (end == p) {
+                break;
+            }
+            row.push_back(value);
+            p = end;
+        }
+        if (!row.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int main(int argc, char **argv) {
+    std::string output_file_name = "prediction_accuracy_metrics.txt";
+    std::string name_list = "Open,Close,High,Low,Volume";
+    std::vector<std::string> labels;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) {
+            output_file_name = argv[++i];
+        } else if (arg == "--names" && i + 1 < argc) {
+            name_list = argv[++i];
+        } else if (arg == "--label" && i + 1 < argc) {
+            labels.push_back(argv[++i]);
+        } else {
+            files.push_back(arg);
+        }
+    }
+
+    if (files.size() < 2) {
+        std::cerr << "Usage: " << argv[0] << " [--out File] [--names a,b,...] [--label Name]..."
+                  << " <Real File> <Prediction File> [Prediction File...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> names;
+    std::stringstream ss(name_list);
+    for (std::string item; std::getline(ss, item, ',');) {
+        names.push_back(item);
+    }
+
+    std::vector<std::unique_ptr<std::ifstream>> inputs;
+    for (const std::string &file_name : files) {
+        inputs.emplace_back(new std::ifstream(file_name));
+        if (!inputs.back()->is_open()) {
+            std::cerr << "Error: Could not open " << file_name << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    const size_t sources = files.size() - 1;
+    std::vector<PredictionMetrics> metrics;
+    std::vector<double> real, previous;
+    std::vector<std::vector<double>> predicted(sources);
+    bool have_previous = false;
+    long row = 0;
+    while (read_row(*inputs[0], real)) {
+        if (metrics.empty()) {
+            metrics.assign(sources, PredictionMetrics(real.size()));
+        }
+        for (size_t s = 0; s < sources; s++) {
+            if (!read_row(*inputs[s + 1], predicted[s])) {
+                std::cerr << "Error: Input files have different lengths (" << files[s + 1] << " ends at row " << row
+                          << ")." << std::endl;
+                return EXIT_FAILURE;
+            }
+            if (predicted[s].size() != real.size()) {
+                std::cerr << "Error: Row " << row + 1 << " of " << files[s + 1] << " has " << predicted[s].size()
+                          << " values, expected " << real.size() << "." << std::endl;
+                return EXIT_FAILURE;
+            }
+            metrics[s].add(predicted[s].data(), real.data(), have_previous ? previous.data() : nullptr);
+        }
+        previous.swap(real);
+        have_previous = true;
+        row++;
+    }
+    for (size_t s = 0; s < sources; s++) {
+        std::vector<double> extra;
+        if (read_row(*inputs[s + 1], extra)) {
+            std::cerr << "Error: Input files have different lengths (" << files[s + 1] << " is longer than "
+                      << files[0] << ")." << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (row == 0) {
+        std::cerr << "Error: No rows in " << files[0] << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ofstream output_file(output_file_name);
+    for (size_t s = 0; s < sources; s++) {
+        const std::string label = s < labels.size() ? labels[s] : files[s + 1];
+        if (s > 0) {
+            output_file << "\n";
+        }
+        metrics[s].write_report(output_file, label, names);
+        metrics[s].write_report(std::cout, label, names);
+    }
+    output_file.close();
+    std::cout << "Debug: Prediction accuracy metrics written to '" << output_file_name << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
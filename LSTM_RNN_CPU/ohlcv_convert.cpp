@@ -0,0 +1,50 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include "data_io.h"
+#include "ohlcv_file.h"
+
+// Converts any data file load_table understands (data.txt variants, CSV
+// exports, or another OHLCV file) into the binary columnar OHLCV format.
+int main(int argc, char **argv) {
+    OhlcvDtype dtype = OHLCV_F64;
+    std::string input_file, output_file;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--f32") {
+            dtype = OHLCV_F32;
+        } else if (arg == "--f64") {
+            dtype = OHLCV_F64;
+        } else if (input_file.empty()) {
+            input_file = arg;
+        } else {
+            output_file = arg;
+        }
+    }
+
+    if (input_file.empty() || output_file.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <Input Data File> <Output .ohlcv File> [--f32|--f64]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    DataTable table;
+    if (!load_table(input_file, table) || table.rows() == 0) {
+        std::cerr << "Error: No data rows in " << input_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    if (!save_ohlcv_file(output_file, table, dtype)) {
+        return EXIT_FAILURE;
+    }
+
+    // Read the result back through the mapping as a sanity check
+    OhlcvFile file;
+    if (!file.open(output_file)) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Debug: Wrote " << file.rows() << " rows x " << file.num_features() << " features ("
+              << (dtype == OHLCV_F32 ? "f32" : "f64") << (file.timestamps().empty() ? "" : ", timestamps")
+              << (file.ticker().empty() ? "" : ", ticker " + file.ticker()) << ") to '" << output_file << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+#include "ohlcv_file.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static uint64_t align_up(uint64_t offset) {
+    return (offset + OHLCV_ALIGN - 1) / OHLCV_ALIGN * OHLCV_ALIGN;
+}
+
+static size_t dtype_size(uint32_t dtype) {
+    return dtype == OHLCV_F32 ? sizeof(float) : sizeof(double);
+}
+
+// True when rows elements of element_size bytes starting at offset lie inside
+// length bytes. Divides instead of multiplying so a huge row count cannot wrap.
+static bool span_fits(uint64_t offset, uint64_t rows, uint64_t element_size, uint64_t length) {
+    return offset <= length && rows <= (length - offset) / element_size;
+}
+
+static std::string fixed_string(const char *text, size_t size) {
+    return std::string(text, strnlen(text, size));
+}
+
+bool OhlcvFile::open(const std::string &file_name) {
+    close();
+
+    int fd = ::open(file_name.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Error: Could not open file " << file_name << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(OhlcvHeader)) {
+        std::cerr << "Error: " << file_name << " is too small for an OHLCV header." << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    void *base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (base == MAP_FAILED) {
+        std::cerr << "Error: Could not map " << file_name << std::endl;
+        return false;
+    }
+    base_ = base;
+    length_ = st.st_size;
+
+    // Validate the header and that every column lies inside the file
+    const OhlcvHeader *header = static_cast<const OhlcvHeader *>(base_);
+    const char *problem = nullptr;
+    if (std::memcmp(header->magic, OHLCV_MAGIC, sizeof(header->magic)) != 0) {
+        problem = "bad magic";
+    } else if (header->version != OHLCV_VERSION) {
+        problem = "unsupported version";
+    } else if (header->dtype != OHLCV_F32 && header->dtype != OHLCV_F64) {
+        problem = "unknown dtype";
+    } else if (header->num_features == 0 || header->num_features > OHLCV_MAX_FEATURES) {
+        problem = "bad feature count";
+    } else {
+        for (uint32_t i = 0; i < header->num_features && !problem; i++) {
+            const uint64_t offset = header->column_offsets[i];
+            if (offset % OHLCV_ALIGN != 0 || offset < sizeof(OhlcvHeader) ||
+                !span_fits(offset, header->row_count, dtype_size(header->dtype), length_)) {
+                problem = "column out of range";
+            }
+        }
+        const uint64_t ts = header->timestamps_offset;
+        if (!problem && ts != 0 &&
+            (ts % OHLCV_ALIGN != 0 || !span_fits(ts, header->row_count, sizeof(int64_t), length_))) {
+            problem = "timestamps out of range";
+        }
+    }
+    if (problem) {
+        std::cerr << "Error: " << file_name << " is not a valid OHLCV file (" << problem << ")." << std::endl;
+        close();
+        return false;
+    }
+
+    header_ = header;
+    return true;
+}
+
+void OhlcvFile::close() {
+    if (base_) {
+        munmap(base_, length_);
+    }
+    base_ = nullptr;
+    length_ = 0;
+    header_ = nullptr;
+}
+
+std::string OhlcvFile::ticker() const {
+    return fixed_string(header_->ticker, OHLCV_NAME_SIZE);
+}
+
+std::string OhlcvFile::feature_name(int feature) const {
+    return fixed_string(header_->feature_names[feature], OHLCV_NAME_SIZE);
+}
+
+int OhlcvFile::feature_index(const std::string &name) const {
+    for (int i = 0; i < num_features(); i++) {
+        if (feature_name(i) == name) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+ColumnSpan<float> OhlcvFile::column_f32(int feature) const {
+    if (header_->dtype != OHLCV_F32 || feature < 0 || feature >= num_features()) {
+        return ColumnSpan<float>();
+    }
+    const char *base = static_cast<const char *>(base_);
+    return ColumnSpan<float>(reinterpret_cast<const float *>(base + header_->column_offsets[feature]), rows());
+}
+
+ColumnSpan<double> OhlcvFile::column_f64(int feature) const {
+    if (header_->dtype != OHLCV_F64 || feature < 0 || feature >= num_features()) {
+        return ColumnSpan<double>();
+    }
+    const char *base = static_cast<const char *>(base_);
+    return ColumnSpan<double>(reinterpret_cast<const double *>(base + header_->column_offsets[feature]), rows());
+}
+
+ColumnSpan<int64_t> OhlcvFile::timestamps() const {
+    if (header_->timestamps_offset == 0) {
+        return ColumnSpan<int64_t>();
+    }
+    const char *base = static_cast<const char *>(base_);
+    return ColumnSpan<int64_t>(reinterpret_cast<const int64_t *>(base + header_->timestamps_offset), rows());
+}
+
+double OhlcvFile::value(size_t row, int feature) const {
+    if (header_->dtype == OHLCV_F32) {
+        return column_f32(feature)[row];
+    }
+    return column_f64(feature)[row];
+}
+
+bool save_ohlcv_file(const std::string &file_name, const DataTable &table, OhlcvDtype dtype) {
+    const size_t num_features = table.num_features;
+    const uint64_t row_count = table.rows();
+    if (num_features == 0 || num_features > OHLCV_MAX_FEATURES) {
+        std::cerr << "Error: OHLCV files hold 1 to " << OHLCV_MAX_FEATURES << " features, got " << num_features << std::endl;
+        return false;
+    }
+
+    OhlcvHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, OHLCV_MAGIC, sizeof(header.magic));
+    header.version = OHLCV_VERSION;
+    header.dtype = dtype;
+    header.num_features = num_features;
+    header.prediction_days = table.prediction_days;
+    header.row_count = row_count;
+    std::strncpy(header.ticker, table.ticker.c_str(), OHLCV_NAME_SIZE - 1);
+
+    uint64_t offset = sizeof(OhlcvHeader);
+    for (size_t i = 0; i < num_features; i++) {
+        std::strncpy(header.feature_names[i], table.feature_names[i].c_str(), OHLCV_NAME_SIZE - 1);
+        header.column_offsets[i] = offset;
+        offset = align_up(offset + row_count * dtype_size(dtype));
+    }
+    if (table.timestamps.size() == row_count && row_count > 0) {
+        header.timestamps_offset = offset;
+        offset = align_up(offset + row_count * sizeof(int64_t));
+    }
+
+    std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open " << file_name << " for writing." << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    // Columns in file order, zero padding up to each aligned offset
+    const char zeros[OHLCV_ALIGN] = {0};
+    uint64_t written = sizeof(header);
+    for (size_t i = 0; i < num_features; i++) {
+        file.write(zeros, header.column_offsets[i] - written);
+        for (uint64_t r = 0; r < row_count; r++) {
+            const double v = table.row(r)[i];
+            if (dtype == OHLCV_F32) {
+                const float f = (float)v;
+                file.write(reinterpret_cast<const char *>(&f), sizeof(f));
+            } else {
+                file.write(reinterpret_cast<const char *>(&v), sizeof(v));
+            }
+        }
+        written = header.column_offsets[i] + row_count * dtype_size(dtype);
+    }
+    if (header.timestamps_offset) {
+        file.write(zeros, header.timestamps_offset - written);
+        file.write(reinterpret_cast<const char *>(table.timestamps.data()), row_count * sizeof(int64_t));
+        written = header.timestamps_offset + row_count * sizeof(int64_t);
+    }
+    file.write(zeros, offset - written);
+
+    if (!file.good()) {
+        std::cerr << "Error: Failed writing " << file_name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool is_ohlcv_file(const std::string &file_name) {
+    std::ifstream file(file_name, std::ios::binary);
+    char magic[8];
+    return file.read(magic, sizeof(magic)) && std::memcmp(magic, OHLCV_MAGIC, sizeof(magic)) == 0;
+}
+
+bool load_ohlcv_table(const std::string &file_name, DataTable &table) {
+    OhlcvFile file;
+    if (!file.open(file_name)) {
+        return false;
+    }
+
+    table = DataTable();
+    table.prediction_days = file.header().prediction_days;
+    table.num_features = file.num_features();
+    table.ticker = file.ticker();
+    for (int i = 0; i < file.num_features(); i++) {
+        table.feature_names.push_back(file.feature_name(i));
+    }
+    ColumnSpan<int64_t> ts = file.timestamps();
+    table.timestamps.assign(ts.begin(), ts.end());
+
+    table.values.resize(file.rows() * file.num_features());
+    for (int i = 0; i < file.num_features(); i++) {
+        for (size_t r = 0; r < file.rows(); r++) {
+            table.row(r)[i] = file.value(r, i);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#ifndef OHLCV_FILE_H
+#define OHLCV_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "data_io.h"
+
+// Binary columnar OHLCV file. A fixed 512-byte header is followed by one
+// 64-byte aligned column per feature and an optional int64 timestamp column,
+// so a memory-mapped file can hand out columns without parsing or copying.
+
+#define OHLCV_MAGIC "OHLCVCOL"
+#define OHLCV_VERSION 1
+#define OHLCV_HEADER_SIZE 512
+#define OHLCV_ALIGN 64
+#define OHLCV_MAX_FEATURES 16
+#define OHLCV_NAME_SIZE 16
+
+enum OhlcvDtype {
+    OHLCV_F32 = 1,
+    OHLCV_F64 = 2
+};
+
+// On-disk header, little-endian
+struct OhlcvHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t dtype;                                      // OhlcvDtype
+    uint32_t num_features;
+    uint32_t prediction_days;
+    uint64_t row_count;
+    uint64_t timestamps_offset;                          // 0 when the file has no timestamps
+    uint64_t column_offsets[OHLCV_MAX_FEATURES];
+    char ticker[OHLCV_NAME_SIZE];
+    char feature_names[OHLCV_MAX_FEATURES][OHLCV_NAME_SIZE];
+    uint8_t reserved[OHLCV_HEADER_SIZE - 40 - 8 * OHLCV_MAX_FEATURES - OHLCV_NAME_SIZE * (1 + OHLCV_MAX_FEATURES)];
+};
+
+static_assert(sizeof(OhlcvHeader) == OHLCV_HEADER_SIZE, "OhlcvHeader must stay 512 bytes");
+
+// Non-owning view of one column
+template <typename T>
+struct ColumnSpan {
+    const T *data;
+    size_t size;
+
+    ColumnSpan() : data(nullptr), size(0) {}
+    ColumnSpan(const T *d, size_t n) : data(d), size(n) {}
+    const T &operator[](size_t i) const { return data[i]; }
+    const T *begin() const { return data; }
+    const T *end() const { return data + size; }
+    bool empty() const { return size == 0; }
+};
+
+// Read-only memory mapping of an OHLCV file
+class OhlcvFile {
+public:
+    OhlcvFile() : base_(nullptr), length_(0), header_(nullptr) {}
+    ~OhlcvFile() { close(); }
+    OhlcvFile(const OhlcvFile &) = delete;
+    OhlcvFile &operator=(const OhlcvFile &) = delete;
+
+    // Map and validate the file, false (with a message on stderr) on any problem
+    bool open(const std::string &file_name);
+    void close();
+    bool is_open() const { return header_ != nullptr; }
+
+    const OhlcvHeader &header() const { return *header_; }
+    size_t rows() const { return header_->row_count; }
+    int num_features() const { return header_->num_features; }
+    OhlcvDtype dtype() const { return (OhlcvDtype)header_->dtype; }
+    std::string ticker() const;
+    std::string feature_name(int feature) const;
+    int feature_index(const std::string &name) const;   // -1 when missing
+
+    // Zero-copy column views; empty when the dtype does not match
+    ColumnSpan<float> column_f32(int feature) const;
+    ColumnSpan<double> column_f64(int feature) const;
+    ColumnSpan<int64_t> timestamps() const;
+
+    // Value at row/feature converted to double, whatever the stored dtype
+    double value(size_t row, int feature) const;
+
+private:
+    void *base_;
+    size_t length_;
+    const OhlcvHeader *header_;
+};
+
+// Write a table as an OHLCV file
+bool save_ohlcv_file(const std::string &file_name, const DataTable &table, OhlcvDtype dtype);
+
+// True when the file starts with OHLCV_MAGIC
+bool is_ohlcv_file(const std::string &file_name);
+
+// Copy an OHLCV file into a DataTable (for callers that still want rows)
+bool load_ohlcv_table(const std::string &file_name, DataTable &table);
+
+#endif // OHLCV_FILE_H
@@ -0,0 +1,239 @@
+#ifndef ONLINE_NORMALIZER_H
+#define ONLINE_NORMALIZER_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Welford online z-score statistics per feature. push() folds one bar in
+// O(features). With a window the oldest bar is swapped out in the same update,
+// so the statistics only cover the last window bars; the raw bars are kept in a
+// ring that is re-summed once per window to stop rounding drift from building
+// up.
+
+#define NORMALIZER_MAGIC "WELFORD1"
+#define NORMALIZER_FILE "normalizer.dat"   // saved next to weights.dat
+
+class OnlineNormalizer {
+public:
+    explicit OnlineNormalizer(int num_features = 0, long window = 0) { reset(num_features, window); }
+
+    // Drop all statistics; window 0 keeps every bar
+    void reset(int num_features, long window = 0) {
+        num_features_ = num_features;
+        window_ = window > 0 ? window : 0;
+        count_ = 0;
+        head_ = 0;
+        since_refresh_ = 0;
+        mean_.assign(num_features, 0.0);
+        m2_.assign(num_features, 0.0);
+        ring_.assign((size_t)window_ * num_features, 0.0);
+    }
+
+    int num_features() const { return num_features_; }
+    long window() const { return window_; }
+    long count() const { return count_; }   // bars currently covered
+
+    // Fold in one bar of num_features values
+    template <typename T>
+    void push(const T *bar) {
+        if (window_ > 0 && count_ == window_) {
+            // Full window: replace the oldest bar in one update
+            double *old = &ring_[(size_t)head_ * num_features_];
+            for (int f = 0; f < num_features_; f++) {
+                const double x = double(bar[f]);
+                const double delta = x - old[f];
+                const double mean = mean_[f] + delta / count_;
+                m2_[f] += delta * (x - mean + old[f] - mean_[f]);
+                m2_[f] = m2_[f] > 0.0 ? m2_[f] : 0.0;
+                mean_[f] = mean;
+                old[f] = x;
+            }
+            head_ = (head_ + 1) % window_;
+            if (++since_refresh_ >= window_) {
+                refresh();
+            }
+            return;
+        }
+
+        count_++;
+        for (int f = 0; f < num_features_; f++) {
+            const double x = double(bar[f]);
+            const double delta = x - mean_[f];
+            mean_[f] += delta / count_;
+            m2_[f] += delta * (x - mean_[f]);
+        }
+        if (window_ > 0) {
+            double *slot = &ring_[(size_t)(count_ - 1) * num_features_];
+            for (int f = 0; f < num_features_; f++) {
+                slot[f] = double(bar[f]);
+            }
+        }
+    }
+
+    // Fold in rows bars stored contiguously, num_features values apart
+    template <typename T>
+    void push_rows(const T *data, size_t rows) {
+        for (size_t r = 0; r < rows; r++) {
+            push(data + r * num_features_);
+        }
+    }
+
+    // Fold in rows bars stored column-major, columns[f] holding feature f,
+    // with the same arithmetic as push(). Each feature's update is a serial
+    // chain of divisions, so the features advance together and their chains
+    // overlap. A window keeps its ring in bar order, so there the bars are
+    // gathered and pushed one at a time.
+    template <typename T>
+    void push_columns(const T *const *columns, size_t rows) {
+        if (window_ > 0) {
+            std::vector<T> bar(num_features_);
+            for (size_t r = 0; r < rows; r++) {
+                for (int f = 0; f < num_features_; f++) {
+                    bar[f] = columns[f][r];
+                }
+                push(bar.data());
+            }
+            return;
+        }
+
+        double *mean = mean_.data(), *m2 = m2_.data();
+        for (size_t r = 0; r < rows; r++) {
+            count_++;
+            for (int f = 0; f < num_features_; f++) {
+                const double x = double(columns[f][r]);
+                const double delta = x - mean[f];
+                mean[f] += delta / count_;
+                m2[f] += delta * (x - mean[f]);
+            }
+        }
+    }
+
+    double mean(int f) const { return mean_[f]; }
+    double variance(int f) const { return count_ > 0 ? m2_[f] / count_ : 0.0; }   // population, as before
+    double std_dev(int f) const { return std::sqrt(variance(f)); }
+
+    // (x - mean) / std_dev, constant features map to 0. in and out may alias.
+    template <typename In, typename Out>
+    void normalize(const In *bar, Out *out) const {
+        for (int f = 0; f < num_features_; f++) {
+            const double sd = std_dev(f);
+            out[f] = Out(sd > 0.0 ? (double(bar[f]) - mean_[f]) / sd : 0.0);
+        }
+    }
+
+    template <typename In, typename Out>
+    void normalize_rows(const In *data, Out *out, size_t rows) const {
+        for (size_t r = 0; r < rows; r++) {
+            normalize(data + r * num_features_, out + r * num_features_);
+        }
+    }
+
+    double denormalize(int f, double value) const { return value * std_dev(f) + mean_[f]; }
+
+    // Binary state: magic, sizes, mean, M2 and the ring of raw bars
+    bool save(const std::string &file_name) const {
+        std::ofstream file(file_name, std::ios::binary);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open " << file_name << " for writing." << std::endl;
+            return false;
+        }
+        const int64_t sizes[5] = {num_features_, window_, count_, head_, since_refresh_};
+        file.write(NORMALIZER_MAGIC, 8);
+        file.write(reinterpret_cast<const char *>(sizes), sizeof(sizes));
+        file.write(reinterpret_cast<const char *>(mean_.data()), mean_.size() * sizeof(double));
+        file.write(reinterpret_cast<const char *>(m2_.data()), m2_.size() * sizeof(double));
+        file.write(reinterpret_cast<const char *>(ring_.data()), ring_.size() * sizeof(double));
+        return file.good();
+    }
+
+    // Restores a save() file. The sizes are checked against each other and
+    // against the file length before anything is allocated, so a corrupt or
+    // truncated file is rejected instead of steering push() out of the ring.
+    bool load(const std::string &file_name) {
+        std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open " << file_name << std::endl;
+            return false;
+        }
+        const int64_t length = (int64_t)file.tellg();
+        file.seekg(0);
+        char magic[8];
+        int64_t sizes[5];
+        if (!file.read(magic, 8) || std::memcmp(magic, NORMALIZER_MAGIC, 8) != 0) {
+            std::cerr << "Error: " << file_name << " is not a normalizer state file." << std::endl;
+            return false;
+        }
+        if (!file.read(reinterpret_cast<char *>(sizes), sizeof(sizes))) {
+            std::cerr << "Error: " << file_name << " is truncated." << std::endl;
+            return false;
+        }
+
+        // mean and M2 take num_features doubles each, the ring window * num_features
+        const int64_t features = sizes[0], window = sizes[1], count = sizes[2], head = sizes[3];
+        const int64_t payload = length - 8 - (int64_t)sizeof(sizes);
+        const int64_t doubles = payload / (int64_t)sizeof(double);
+        const char *problem = nullptr;
+        if (features < 0 || features > INT32_MAX || window < 0 || count < 0 || head < 0 || sizes[4] < 0) {
+            problem = "negative or oversized count";
+        } else if (window > 0 && (head >= window || count > window)) {
+            problem = "ring position outside the window";
+        } else if (payload % (int64_t)sizeof(double) != 0 || doubles < 2 * features) {
+            problem = "truncated";
+        } else if (features > 0 ? doubles % features != 0 || doubles / features - 2 != window : doubles != 0) {
+            problem = "ring size does not match the window";
+        }
+        if (problem) {
+            std::cerr << "Error: " << file_name << " is not a valid normalizer state file (" << problem << ")."
+                      << std::endl;
+            return false;
+        }
+
+        reset((int)features, (long)window);
+        count_ = (long)count;
+        head_ = (long)head;
+        since_refresh_ = (long)sizes[4];
+        file.read(reinterpret_cast<char *>(mean_.data()), mean_.size() * sizeof(double));
+        file.read(reinterpret_cast<char *>(m2_.data()), m2_.size() * sizeof(double));
+        file.read(reinterpret_cast<char *>(ring_.data()), ring_.size() * sizeof(double));
+        if (!file) {
+            std::cerr << "Error: " << file_name << " is truncated." << std::endl;
+            reset(num_features_, window_);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    // Exact two-pass statistics over the ring
+    void refresh() {
+        for (int f = 0; f < num_features_; f++) {
+            double sum = 0.0;
+            for (long i = 0; i < count_; i++) {
+                sum += ring_[(size_t)i * num_features_ + f];
+            }
+            const double mean = sum / count_;
+            double m2 = 0.0;
+            for (long i = 0; i < count_; i++) {
+                const double d = ring_[(size_t)i * num_features_ + f] - mean;
+                m2 += d * d;
+            }
+            mean_[f] = mean;
+            m2_[f] = m2;
+        }
+        since_refresh_ = 0;
+    }
+
+    int num_features_;
+    long window_;
+    long count_;
+    long head_;            // oldest bar in the ring once the window is full
+    long since_refresh_;
+    std::vector<double> mean_, m2_, ring_;
+};
+
+#endif // ONLINE_NORMALIZER_H
@@ -0,0 +1,150 @@
+#ifndef PREDICTION_METRICS_H
+#define PREDICTION_METRICS_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Streaming prediction metrics per feature: percent error (MAPE) and percent
+// accuracy with calculateAccuracy.py's definitions, RMSE, and the directional hit
+// rate (did the prediction move the same way from the previous real bar as the
+// real bar did). add() folds one prediction in O(features) as it lands, so a
+// backtest never has to write and re-read its outputs. Each thread keeps its
+// own instance and merge() combines them at the end; the sums are plain
+// additions, so the merged totals do not depend on how rows were split, up to
+// rounding.
+
+class PredictionMetrics {
+public:
+    explicit PredictionMetrics(int num_features = 0) { reset(num_features); }
+
+    void reset(int num_features) {
+        num_features_ = num_features;
+        rows_ = 0;
+        features_.assign(num_features, Feature());
+    }
+
+    // One prediction and the bar it targets. previous is the last real bar the
+    // model saw, or nullptr when there is none (no direction is scored then).
+    void add(const double *predicted, const double *real, const double *previous = nullptr) {
+        for (int i = 0; i < num_features_; i++) {
+            Feature &f = features_[i];
+            const double error = predicted[i] - real[i];
+            f.squared_error_sum += error * error;
+            f.count++;
+            // A row whose real value is 0 adds nothing to the percent sums but still
+            // counts in their denominator, as in calculateAccuracy.py. The script
+            // divides by the signed real value; for positive prices and volumes the
+            // two agree.
+            if (real[i] != 0.0) {
+                f.percent_error_sum += std::fabs(error / real[i]) * 100.0;
+                f.percent_count++;
+            }
+            if (previous) {
+                const double real_move = real[i] - previous[i];
+                const double predicted_move = predicted[i] - previous[i];
+                if (real_move != 0.0) {
+                    f.direction_count++;
+                    f.direction_hits += (real_move > 0.0) == (predicted_move > 0.0) && predicted_move != 0.0;
+                }
+            }
+        }
+        rows_++;
+    }
+
+    // Fold another instance's rows in; both must track the same features
+    void merge(const PredictionMetrics &other) {
+        for (int i = 0; i < num_features_ && i < other.num_features_; i++) {
+            Feature &f = features_[i];
+            const Feature &o = other.features_[i];
+            f.count += o.count;
+            f.percent_count += o.percent_count;
+            f.direction_count += o.direction_count;
+            f.direction_hits += o.direction_hits;
+            f.percent_error_sum += o.percent_error_sum;
+            f.squared_error_sum += o.squared_error_sum;
+        }
+        rows_ += other.rows_;
+    }
+
+    int num_features() const { return num_features_; }
+    uint64_t rows() const { return rows_; }
+
+    // Averaged over every row, so a row with real 0 scores 0% accuracy and 0% error
+    double mape(int i) const {
+        const Feature &f = features_[i];
+        return f.count ? f.percent_error_sum / f.count : 0.0;
+    }
+    double accuracy(int i) const {
+        const Feature &f = features_[i];
+        return f.count ? (100.0 * f.percent_count - f.percent_error_sum) / f.count : 0.0;
+    }
+    double rmse(int i) const {
+        const Feature &f = features_[i];
+        return f.count ? std::sqrt(f.squared_error_sum / f.count) : 0.0;
+    }
+    // Percent of scored moves predicted in the right direction; -1 when none were scored
+    double hit_rate(int i) const {
+        const Feature &f = features_[i];
+        return f.direction_count ? 100.0 * f.direction_hits / f.direction_count : -1.0;
+    }
+
+    // Over every feature value, as calculateAccuracy.py's overall lines
+    double overall_mape() const {
+        double sum = 0.0;
+        uint64_t count = 0;
+        for (const Feature &f : features_) {
+            sum += f.percent_error_sum;
+            count += f.count;
+        }
+        return count ? sum / count : 0.0;
+    }
+    double overall_accuracy() const {
+        double sum = 0.0;
+        uint64_t count = 0;
+        for (const Feature &f : features_) {
+            sum += 100.0 * f.percent_count - f.percent_error_sum;
+            count += f.count;
+        }
+        return count ? sum / count : 0.0;
+    }
+
+    // The prediction_accuracy_metrics.txt block for one source, extended with
+    // RMSE and hit rate. names labels the features (Feature N when missing).
+    void write_report(std::ostream &out, const std::string &label, const std::vector<std::string> &names) const {
+        char line[256];
+        out << label << " (" << rows_ << " predictions):\n";
+        for (int i = 0; i < num_features_; i++) {
+            const std::string name = i < (int)names.size() ? names[i] : "Feature " + std::to_string(i + 1);
+            std::snprintf(line, sizeof(line), "%s - Percent Accuracy: %.2f%%, Percent Error: %.2f%%, RMSE: %.6g",
+                          name.c_str(), accuracy(i), mape(i), rmse(i));
+            out << line;
+            if (hit_rate(i) >= 0.0) {
+                std::snprintf(line, sizeof(line), ", Hit Rate: %.2f%%", hit_rate(i));
+                out << line;
+            }
+            out << "\n";
+        }
+        std::snprintf(line, sizeof(line), "Overall Accuracy: %.2f%%\nOverall Error: %.2f%%\n", overall_accuracy(),
+                      overall_mape());
+        out << line;
+    }
+
+private:
+    struct Feature {
+        uint64_t count, percent_count, direction_count, direction_hits;
+        double percent_error_sum, squared_error_sum;
+
+        Feature() : count(0), percent_count(0), direction_count(0), direction_hits(0), percent_error_sum(0.0),
+                    squared_error_sum(0.0) {}
+    };
+
+    int num_features_;
+    uint64_t rows_;
+    std::vector<Feature> features_;
+};
+
+#endif // PREDICTION_METRICS_H
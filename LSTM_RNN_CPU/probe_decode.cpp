@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gate_probe.h"
+
+// Offline decoder for gate_probe.h captures. Prints the record counts and,
+// per field, the range, the mean and how often units saturate. Optional
+// outputs:
+//   --csv File     one row per record and unit: sequence,step,unit,i,f,g,o,c,h
+//   --npy Prefix   Prefix_{i,f,g,o,c,h}.npy float32 [records][hidden] and
+//                  Prefix_index.npy int32 [records][2] (sequence, step)
+//   --debug File   the testbench's old debug_output.dat text: h and c after the
+//                  last step of every sequence (one sequence per day)
+
+#define CLIP_LIMIT 50.0   // lstm_cell clips c to +-50
+
+// Start a .npy file (format 1.0) whose data follows in C order
+static bool write_npy_header(std::ofstream &file, const char *descr, uint64_t rows, uint64_t cols) {
+    std::string dict = std::string("{'descr': '") + descr + "', 'fortran_order': False, 'shape': (" +
+                       std::to_string(rows) + ", " + std::to_string(cols) + "), }";
+    const size_t unpadded = 10 + dict.size() + 1;
+    dict.append((64 - unpadded % 64) % 64, ' ');
+    dict += '\n';
+    const uint16_t length = uint16_t(dict.size());
+    file.write("\x93NUMPY\x01\x00", 8);
+    file.write(reinterpret_cast<const char *>(&length), 2);
+    file.write(dict.data(), dict.size());
+    return file.good();
+}
+
+struct FieldStats {
+    double min, max, sum;
+    uint64_t count, saturated;
+
+    FieldStats() : min(INFINITY), max(-INFINITY), sum(0.0), count(0), saturated(0) {}
+};
+
+int main(int argc, char **argv) {
+    std::string csv_file_name, npy_prefix, debug_file_name, probe_file_name;
+    double threshold = 0.99;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--csv" && i + 1 < argc) {
+            csv_file_name = argv[++i];
+        } else if (arg == "--npy" && i + 1 < argc) {
+            npy_prefix = argv[++i];
+        } else if (arg == "--debug" && i + 1 < argc) {
+            debug_file_name = argv[++i];
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            threshold = std::atof(argv[++i]);
+        } else {
+            probe_file_name = arg;
+        }
+    }
+
+    if (probe_file_name.empty() || threshold <= 0.5 || threshold >= 1.0) {
+        std::cerr << "Usage: " << argv[0] << " [--csv File] [--npy Prefix] [--debug File] [--threshold T]"
+                  << " <Probe File>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::ifstream file(probe_file_name, std::ios::binary);
+    GateProbeHeader header;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, GATE_PROBE_MAGIC, 8) != 0 || header.version != GATE_PROBE_VERSION ||
+        header.fields != GATE_PROBE_FIELDS ||
+        header.record_bytes != sizeof(GateProbeRecord) + GATE_PROBE_FIELDS * header.hidden_size * sizeof(float)) {
+        std::cerr << "Error: " << probe_file_name << " is not a gate probe file." << std::endl;
+        return EXIT_FAILURE;
+    }
+    const int hidden = header.hidden_size;
+    static const char *field_names[GATE_PROBE_FIELDS] = GATE_PROBE_FIELD_NAMES;
+
+    std::ofstream csv_file;
+    if (!csv_file_name.empty()) {
+        csv_file.open(csv_file_name);
+        csv_file << "sequence,step,unit";
+        for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+            csv_file << "," << field_names[k];
+        }
+        csv_file << "\n";
+    }
+    std::vector<std::unique_ptr<std::ofstream>> npy_files;
+    std::unique_ptr<std::ofstream> npy_index;
+    if (!npy_prefix.empty()) {
+        for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+            npy_files.emplace_back(new std::ofstream(npy_prefix + "_" + field_names[k] + ".npy", std::ios::binary));
+            write_npy_header(*npy_files.back(), "<f4", header.records, hidden);
+        }
+        npy_index.reset(new std::ofstream(npy_prefix + "_index.npy", std::ios::binary));
+        write_npy_header(*npy_index, "<i4", header.records, 2);
+    }
+
+    std::vector<FieldStats> stats(GATE_PROBE_FIELDS);
+    std::map<uint32_t, std::vector<float>> last_state;   // sequence -> h then c of its latest step
+    std::map<uint32_t, uint32_t> last_step;
+    std::vector<char> buffer(header.record_bytes);
+    uint64_t read = 0;
+    for (; read < header.records; read++) {
+        if (!file.read(buffer.data(), buffer.size())) {
+            std::cerr << "Error: " << probe_file_name << " is truncated after " << read << " records." << std::endl;
+            break;
+        }
+        GateProbeRecord record;
+        std::memcpy(&record, buffer.data(), sizeof(record));
+        const float *values = reinterpret_cast<const float *>(buffer.data() + sizeof(record));
+
+        for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+            FieldStats &s = stats[k];
+            for (int i = 0; i < hidden; i++) {
+                const double v = values[k * hidden + i];
+                s.min = std::min(s.min, v);
+                s.max = std::max(s.max, v);
+                s.sum += v;
+                s.count++;
+                bool saturated;
+                if (k == 4) {
+                    saturated = std::fabs(v) >= CLIP_LIMIT;             // c at the clip
+                } else if (k == 2 || k == 5) {
+                    saturated = std::fabs(v) > threshold;               // tanh outputs g and h near +-1
+                } else {
+                    saturated = v > threshold || v < 1.0 - threshold;   // sigmoid gates near 0 or 1
+                }
+                s.saturated += saturated;
+            }
+        }
+
+        if (csv_file.is_open()) {
+            for (int i = 0; i < hidden; i++) {
+                csv_file << record.sequence << "," << record.step << "," << i;
+                for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+                    csv_file << "," << values[k * hidden + i];
+                }
+                csv_file << "\n";
+            }
+        }
+        if (npy_index) {
+            for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+                npy_files[k]->write(reinterpret_cast<const char *>(values + k * hidden), hidden * sizeof(float));
+            }
+            const int32_t index[2] = {int32_t(record.sequence), int32_t(record.step)};
+            npy_index->write(reinterpret_cast<const char *>(index), sizeof(index));
+        }
+        if (!debug_file_name.empty() && (!last_step.count(record.sequence) || record.step >= last_step[record.sequence])) {
+            last_step[record.sequence] = record.step;
+            std::vector<float> &state = last_state[record.sequence];
+            state.assign(values + 5 * hidden, values + 6 * hidden);
+            state.insert(state.end(), values + 4 * hidden, values + 5 * hidden);
+        }
+    }
+
+    if (!debug_file_name.empty()) {
+        std::ofstream debug_file(debug_file_name);
+        int day = 0;
+        for (const auto &entry : last_state) {
+            debug_file << "Day " << ++day << " Debug Information:\n";
+            debug_file << "Hidden States (h): ";
+            for (int i = 0; i < hidden; i++) {
+                debug_file << double(entry.second[i]) << " ";
+            }
+            debug_file << "\nCell States (c): ";
+            for (int i = 0; i < hidden; i++) {
+                debug_file << double(entry.second[hidden + i]) << " ";
+            }
+            debug_file << "\n";
+        }
+    }
+
+    std::cout << "Debug: " << read << " timesteps of hidden size " << hidden << " (" << header.dropped
+              << " dropped before the capture)." << std::endl;
+    std::cout << "field       min        max       mean   saturated" << std::endl;
+    for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+        const FieldStats &s = stats[k];
+        if (s.count == 0) {
+            continue;
+        }
+        char line[128];
+        std::snprintf(line, sizeof(line), "%-5s %10.4f %10.4f %10.4f %10.2f%%", field_names[k], s.min, s.max,
+                      s.sum / s.count, 100.0 * s.saturated / s.count);
+        std::cout << line << std::endl;
+    }
+    return read == header.records ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,282 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include "lstm_quant.h"
+#include "lstm_rollout.h"
+#include "lstm_weight_io.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Sequence length
+#define RNN_HIDDEN 16     // RNN_HW hidden size
+
+// Calibrates and runs the quantized LSTM/RNN cells against the float engines
+// and writes a per-feature error report. The LSTM is rolled over each data file
+// exactly like lstm_cpu (window of the first SEQ_LENGTH bars, predictions fed
+// back, h/c kept across days) and compared with the float engine on the same
+// weights. The RNN scores the first SEQ_LENGTH bars of RNN_HW/data.txt like its
+// testbench, on the RNN_HW weights, and is also compared with the out.gold.dat
+// next to that file.
+
+// Per-feature absolute error against a reference
+struct FeatureError {
+    double abs_sum = 0.0, max_abs = 0.0, ref_abs_sum = 0.0;
+    long count = 0;
+
+    void add(double value, double reference) {
+        const double err = std::fabs(value - reference);
+        abs_sum += err;
+        max_abs = std::max(max_abs, err);
+        ref_abs_sum += std::fabs(reference);
+        count++;
+    }
+    double mae() const { return count ? abs_sum / count : 0.0; }
+    double relative() const { return ref_abs_sum > 0.0 ? 100.0 * abs_sum / ref_abs_sum : 0.0; }
+};
+
+// Numbers after the colon of every line: "Day N: v v v v v" or "Open: v"
+std::vector<double> read_gold(const std::string &file_name) {
+    std::vector<double> values;
+    std::ifstream file(file_name);
+    std::string line;
+    while (std::getline(file, line)) {
+        const size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::istringstream fields(line.substr(colon + 1));
+        double value;
+        while (fields >> value) {
+            values.push_back(value);
+        }
+    }
+    return values;
+}
+
+std::string gold_file_for(const std::string &data_file) {
+    const size_t slash = data_file.find_last_of('/');
+    return (slash == std::string::npos ? std::string() : data_file.substr(0, slash + 1)) + "out.gold.dat";
+}
+
+// The gold columns only when float_gold is given and has values
+void write_error_table(std::ostream &out, const std::string &label, const FeatureError *vs_float,
+                       const FeatureError *float_gold, const FeatureError *quant_gold, const char **names) {
+    const bool has_gold = float_gold && float_gold[0].count;
+    out << "Feature     MAE vs float   Max vs float   MAE% vs float";
+    if (has_gold) {
+        out << "   MAE float vs gold   MAE " << label << " vs gold";
+    }
+    out << "\n";
+    for (int f = 0; f < INPUT_SIZE; f++) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "%-10s  %12.6g   %12.6g   %12.4f%%", names[f], vs_float[f].mae(),
+                      vs_float[f].max_abs, vs_float[f].relative());
+        out << line;
+        if (has_gold) {
+            std::snprintf(line, sizeof(line), "   %17.6g   %*.6g", float_gold[f].mae(),
+                          (int)(11 + label.size()), quant_gold[f].mae());
+            out << line;
+        }
+        out << "\n";
+    }
+}
+
+template <typename Q>
+int run_report(const std::vector<std::string> &data_files, const std::string &rnn_file, int hidden_size,
+               const std::string &weights_file_name, const std::string &report_file_name, int repeat,
+               const std::string &activation_name) {
+    static const char *names[INPUT_SIZE] = {"Open", "Close", "High", "Low", "Volume"};
+    const char *label = QuantLimits<Q>::name();
+    std::ostringstream report;
+    report << "Quantized engine report: " << label << " weights, int32 accumulation, "
+           << (lstm_simd_vnni() ? "avx512-vnni" : lstm_simd_name(lstm_simd_level())) << " kernels\n";
+
+    if (!data_files.empty()) {
+        std::vector<LstmSeries> series(data_files.size());
+        for (size_t s = 0; s < data_files.size(); s++) {
+            if (!load_lstm_series(data_files[s], INPUT_SIZE, SEQ_LENGTH, series[s])) {
+                return EXIT_FAILURE;
+            }
+        }
+
+        WeightFile weight_file;
+        PackedLstmWeights<float> weights;
+        if (!weights_file_name.empty()) {
+            if (!weight_file.open(weights_file_name) || !load_packed_lstm_weights(weight_file, INPUT_SIZE, weights)) {
+                return EXIT_FAILURE;
+            }
+        } else {
+            LstmModelRuntime<float> model(INPUT_SIZE, hidden_size, SEQ_LENGTH);
+            model.initialize_weights_and_biases();
+            weights = pack_lstm_weights(model);
+        }
+        if (!activation_name.empty()) {
+            lstm_parse_activation(activation_name.c_str(), weights.activation);
+        }
+
+        // Calibration: the float engine over every series records the activation ranges
+        QuantCalibration calibration;
+        LstmWorkspace<float> ws(weights);
+        std::vector<std::vector<float>> float_predictions;
+        for (const LstmSeries &s : series) {
+            float_predictions.push_back(rollout(s, weights.hidden_size, [&](const float *x, float *h, float *c) {
+                calibration.observe_x(x, INPUT_SIZE);
+                calibration.observe_h(h, weights.hidden_size);
+                lstm_cell_packed(weights, ws, x, h, c, h, c);
+            }));
+        }
+
+        const QuantizedCell<Q> cell = quantize_lstm<Q>(weights, calibration);
+        QuantWorkspace<Q> qws(cell);
+
+        FeatureError vs_float[INPUT_SIZE];
+        for (size_t s = 0; s < series.size(); s++) {
+            const std::vector<float> quant = rollout(series[s], cell.hidden_size, [&](const float *x, float *h, float *c) {
+                lstm_cell_quant(cell, qws, x, h, c, h, c);
+            });
+            for (size_t k = 0; k < quant.size(); k++) {
+                const int f = k % INPUT_SIZE;
+                const double q = series[s].normalizer.denormalize(f, quant[k]);
+                const double ref = series[s].normalizer.denormalize(f, float_predictions[s][k]);
+                vs_float[f].add(q, ref);
+            }
+        }
+
+        const size_t float_bytes = (size_t)weights.rows() * weights.stride * sizeof(float) +
+                                   lstm_padded<float>(weights.rows()) * sizeof(float);
+        std::vector<float> h(weights.hidden_size), c(weights.hidden_size), out(INPUT_SIZE);
+        const double float_us = time_us(repeat, [&]() {
+            std::fill(h.begin(), h.end(), 0.0f);
+            std::fill(c.begin(), c.end(), 0.0f);
+            lstm_sequence_packed(weights, ws, series[0].window.data(), SEQ_LENGTH, h.data(), c.data(), out.data());
+        });
+        const double quant_us = time_us(repeat, [&]() {
+            std::fill(h.begin(), h.end(), 0.0f);
+            std::fill(c.begin(), c.end(), 0.0f);
+            lstm_sequence_quant(cell, qws, series[0].window.data(), SEQ_LENGTH, h.data(), c.data(), out.data());
+        });
+
+        report << "\nLSTM " << INPUT_SIZE << "x" << weights.hidden_size << ", "
+               << (weights_file_name.empty() ? std::string("random") : weights_file_name) << " weights, "
+               << lstm_activation_name(weights.activation) << " activations, " << series.size() << " data files, calibrated |x| <= " << calibration.x_max << ", |h| <= " << calibration.h_max << "\n"
+               << "Weights: float " << float_bytes << " B, " << label << " " << cell.weight_bytes() << " B ("
+               << double(float_bytes) / cell.weight_bytes() << "x smaller)\n"
+               << "Sequence of " << SEQ_LENGTH << ": float " << float_us << " us, " << label << " " << quant_us
+               << " us (" << float_us / quant_us << "x)\n"
+               << "Errors on denormalized predictions:\n";
+        write_error_table(report, label, vs_float, nullptr, nullptr, names);
+    }
+
+    if (!rnn_file.empty()) {
+        DataTable table;
+        if (!load_table(rnn_file, table) || table.num_features != INPUT_SIZE || table.rows() < SEQ_LENGTH) {
+            std::cerr << "Error: Expected " << SEQ_LENGTH << " rows of " << INPUT_SIZE << " values in " << rnn_file
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<float> x_seq(table.values.begin(), table.values.begin() + SEQ_LENGTH * INPUT_SIZE);
+
+        RnnModel<float> model(INPUT_SIZE, RNN_HIDDEN);
+        model.load_hw_weights();
+        if (!activation_name.empty()) {
+            lstm_parse_activation(activation_name.c_str(), model.activation);
+        }
+
+        QuantCalibration calibration;
+        std::vector<float> h_prev(RNN_HIDDEN, 0.0f), h(RNN_HIDDEN);
+        for (int t = 0; t < SEQ_LENGTH; t++) {
+            calibration.observe_x(&x_seq[t * INPUT_SIZE], INPUT_SIZE);
+            calibration.observe_h(h_prev.data(), RNN_HIDDEN);
+            model.rnn_cell(&x_seq[t * INPUT_SIZE], h_prev.data(), h.data());
+            h_prev = h;
+        }
+
+        const QuantizedCell<Q> cell = quantize_rnn<Q>(model, calibration);
+        QuantWorkspace<Q> qws(cell);
+        std::vector<float> h_quant(RNN_HIDDEN);
+        rnn_sequence_quant(cell, qws, x_seq.data(), SEQ_LENGTH, h_quant.data());
+
+        const std::vector<double> gold = read_gold(gold_file_for(rnn_file));
+        FeatureError vs_float[INPUT_SIZE], float_gold[INPUT_SIZE], quant_gold[INPUT_SIZE];
+        for (int f = 0; f < INPUT_SIZE; f++) {
+            vs_float[f].add(h_quant[f], h[f]);
+            if (f < (int)gold.size()) {
+                float_gold[f].add(h[f], gold[f]);
+                quant_gold[f].add(h_quant[f], gold[f]);
+            }
+        }
+
+        const size_t float_bytes = (model.W.size() + model.U.size() + model.b.size()) * sizeof(float);
+        const double float_us = time_us(repeat, [&]() { model.rnn_sequence(x_seq.data(), SEQ_LENGTH, h.data()); });
+        const double quant_us = time_us(repeat, [&]() {
+            rnn_sequence_quant(cell, qws, x_seq.data(), SEQ_LENGTH, h_quant.data());
+        });
+
+        report << "\nRNN " << INPUT_SIZE << "x" << RNN_HIDDEN << " (RNN_HW weights, " << lstm_activation_name(model.activation)
+               << " activations) on " << rnn_file << ", calibrated |x| <= " << calibration.x_max << ", |h| <= " << calibration.h_max << "\n"
+               << "Weights: float " << float_bytes << " B, " << label << " " << cell.weight_bytes() << " B ("
+               << double(float_bytes) / cell.weight_bytes() << "x smaller)\n"
+               << "Sequence of " << SEQ_LENGTH << ": float " << float_us << " us, " << label << " " << quant_us
+               << " us (" << float_us / quant_us << "x)\n"
+               << "Errors on the next-day prediction:\n";
+        write_error_table(report, label, vs_float, float_gold, quant_gold, names);
+    }
+
+    std::cout << report.str();
+    std::ofstream report_file(report_file_name);
+    report_file << report.str();
+    std::cout << "Debug: Report written to '" << report_file_name << "'." << std::endl;
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    bool use_int16 = false;
+    int hidden_size = 16;
+    int repeat = 2000;
+    std::string weights_file_name, rnn_file, activation_name, report_file_name = "quant_report.txt";
+    std::vector<std::string> data_files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--int8") {
+            use_int16 = false;
+        } else if (arg == "--int16") {
+            use_int16 = true;
+        } else if (arg == "--hidden" && i + 1 < argc) {
+            hidden_size = std::atoi(argv[++i]);
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--rnn" && i + 1 < argc) {
+            rnn_file = argv[++i];
+        } else if (arg == "--report" && i + 1 < argc) {
+            report_file_name = argv[++i];
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else {
+            data_files.push_back(arg);
+        }
+    }
+
+    if ((data_files.empty() && rnn_file.empty()) || hidden_size < INPUT_SIZE || repeat <= 0) {
+        std::cerr << "Usage: " << argv[0] << " [--int8|--int16] [--hidden N] [--weights File] [--act Tier]"
+                  << " [--rnn Data File] [--report File] [--repeat N] [Data File...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    LstmActivation activation;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (use_int16) {
+        return run_report<int16_t>(data_files, rnn_file, hidden_size, weights_file_name, report_file_name, repeat,
+                                   activation_name);
+    }
+    return run_report<int8_t>(data_files, rnn_file, hidden_size, weights_file_name, report_file_name, repeat,
+                              activation_name);
+}
@@ -0,0 +1,74 @@
+#ifndef RNN_MODEL_H
+#define RNN_MODEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "lstm_activation.h"
+#include "../RNN_HW/rnn_hw_weights.h"
+
+// Native float/double version of rnn_cell/rnn_sequence from RNN_HW/rnn.cpp:
+// h = tanh(W . x + U . h_prev + b), starting from a zero state.
+template <typename T>
+struct RnnModel {
+    typedef T value_type;
+    int input_size;
+    int hidden_size;
+
+    std::vector<T> W;   // [hidden][in]
+    std::vector<T> U;   // [hidden][hidden]
+    std::vector<T> b;   // [hidden]
+    LstmActivation activation;    // tanh tier, see lstm_activation.h
+
+    RnnModel(int in, int hidden)
+        : input_size(in), hidden_size(hidden), W(hidden * in), U(hidden * hidden), b(hidden),
+          activation(LSTM_ACT_LIBM) {}
+
+    // The hand-set weights of RNN_HW/rnn.cpp (RNN_HW/rnn_hw_weights.h), cut or zero-padded to this size
+    void load_hw_weights() {
+        static const double W_hw[RNN_HW_HIDDEN_SIZE][RNN_HW_INPUT_SIZE] = RNN_HW_W_INIT;
+        static const double U_hw[RNN_HW_HIDDEN_SIZE][RNN_HW_HIDDEN_SIZE] = RNN_HW_U_INIT;
+        static const double b_hw[RNN_HW_HIDDEN_SIZE] = RNN_HW_B_INIT;
+
+        std::fill(W.begin(), W.end(), T(0));
+        std::fill(U.begin(), U.end(), T(0));
+        std::fill(b.begin(), b.end(), T(0));
+        for (int i = 0; i < RNN_HW_HIDDEN_SIZE && i < hidden_size; i++) {
+            for (int j = 0; j < RNN_HW_INPUT_SIZE && j < input_size; j++) {
+                W[i * input_size + j] = T(W_hw[i][j]);
+            }
+            for (int j = 0; j < RNN_HW_HIDDEN_SIZE && j < hidden_size; j++) {
+                U[i * hidden_size + j] = T(U_hw[i][j]);
+            }
+            b[i] = T(b_hw[i]);
+        }
+    }
+
+    // One step, h must not alias h_prev
+    void rnn_cell(const T *x, const T *h_prev, T *h) const {
+        for (int i = 0; i < hidden_size; i++) {
+            T sum = b[i];
+            for (int j = 0; j < input_size; j++) {
+                sum += W[i * input_size + j] * x[j];
+            }
+            for (int j = 0; j < hidden_size; j++) {
+                sum += U[i * hidden_size + j] * h_prev[j];
+            }
+            h[i] = activation == LSTM_ACT_LIBM ? std::tanh(sum) : sum;
+        }
+        if (activation != LSTM_ACT_LIBM) {
+            lstm_tanh_n(h, hidden_size, activation);
+        }
+    }
+
+    // Whole sequence from a zero state, x_seq is seq_length x input_size row-major
+    void rnn_sequence(const T *x_seq, int seq_length, T *h) const {
+        std::vector<T> h_prev(hidden_size, T(0));
+        for (int t = 0; t < seq_length; t++) {
+            rnn_cell(x_seq + t * input_size, h_prev.data(), h);
+            std::copy(h, h + hidden_size, h_prev.begin());
+        }
+    }
+};
+
+#endif // RNN_MODEL_H
@@ -0,0 +1,214 @@
+#ifndef SERIES_STORE_H
+#define SERIES_STORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include "lstm_kernels.h"
+#include "ohlcv_file.h"
+#include "online_normalizer.h"
+
+// Column-major time-series storage. Each feature, and the optional timestamp
+// column, is one LSTM_ALIGN aligned contiguous array carved out of an arena.
+// A history with a known row count therefore costs one block allocation, a
+// feature walk streams through one column, and a window for inference is
+// gathered into row-major order only when it is needed. ingest fills it
+// (load_series), normalize_series z-scores it in place, and copy_window feeds
+// lstm_sequence.
+
+// Bump allocator over large LSTM_ALIGN aligned blocks. Everything is freed at
+// once by reset() or the destructor.
+class Arena {
+public:
+    explicit Arena(size_t block_bytes = size_t(1) << 20) : block_bytes_(block_bytes), reserved_(0) {}
+    ~Arena() { reset(); }
+    Arena(Arena &&other) : blocks_(std::move(other.blocks_)), block_bytes_(other.block_bytes_),
+                           reserved_(other.reserved_) {
+        other.blocks_.clear();
+        other.reserved_ = 0;
+    }
+    Arena &operator=(Arena &&other) {
+        std::swap(blocks_, other.blocks_);
+        std::swap(block_bytes_, other.block_bytes_);
+        std::swap(reserved_, other.reserved_);
+        return *this;
+    }
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    // bytes rounded up to LSTM_ALIGN; a request larger than a block gets its own block
+    void *allocate(size_t bytes) {
+        bytes = (bytes + LSTM_ALIGN - 1) / LSTM_ALIGN * LSTM_ALIGN;
+        if (blocks_.empty() || blocks_.back().size - blocks_.back().used < bytes) {
+            Block block;
+            block.size = std::max(bytes, block_bytes_);
+            block.used = 0;
+            block.data = static_cast<char *>(lstm_aligned_alloc(block.size));
+            blocks_.push_back(block);
+            reserved_ += block.size;
+        }
+        Block &block = blocks_.back();
+        void *p = block.data + block.used;
+        block.used += bytes;
+        return p;
+    }
+
+    void reset() {
+        for (const Block &block : blocks_) {
+            lstm_aligned_free(block.data);
+        }
+        blocks_.clear();
+        reserved_ = 0;
+    }
+
+    size_t blocks() const { return blocks_.size(); }
+    size_t bytes_reserved() const { return reserved_; }
+
+private:
+    struct Block {
+        char *data;
+        size_t size;
+        size_t used;
+    };
+
+    std::vector<Block> blocks_;
+    size_t block_bytes_;
+    size_t reserved_;
+};
+
+template <typename T>
+class SeriesStore {
+public:
+    int prediction_days;                     // 0 when the source has none
+    std::string ticker;
+    std::vector<std::string> feature_names;
+
+    SeriesStore() : prediction_days(0), num_features_(0), has_timestamps_(false), rows_(0), capacity_(0),
+                    timestamps_(nullptr) {}
+    SeriesStore(SeriesStore &&) = default;
+    SeriesStore &operator=(SeriesStore &&) = default;
+    SeriesStore(const SeriesStore &) = delete;
+    SeriesStore &operator=(const SeriesStore &) = delete;
+
+    // Drop every row and the arena; the next reserve sizes the one block
+    void reset(int num_features, bool timestamps = false) {
+        arena_.reset();
+        num_features_ = num_features;
+        has_timestamps_ = timestamps;
+        rows_ = 0;
+        capacity_ = 0;
+        columns_.assign(num_features, nullptr);
+        timestamps_ = nullptr;
+        prediction_days = 0;
+        ticker.clear();
+        feature_names.clear();
+    }
+
+    // Room for rows without reallocating. Growing moves the columns to fresh
+    // arena space (the old space is only reclaimed by reset), so reserve the
+    // final size up front when it is known.
+    void reserve(size_t rows) {
+        if (rows <= capacity_) {
+            return;
+        }
+        const size_t capacity = std::max(rows, 2 * capacity_);
+        const size_t column_bytes = (capacity * sizeof(T) + LSTM_ALIGN - 1) / LSTM_ALIGN * LSTM_ALIGN;
+        const size_t total = column_bytes * num_features_ + (has_timestamps_ ? capacity * sizeof(int64_t) : 0);
+        char *block = static_cast<char *>(arena_.allocate(total));
+        for (int f = 0; f < num_features_; f++) {
+            T *column = reinterpret_cast<T *>(block + f * column_bytes);
+            if (rows_ > 0) {
+                std::memcpy(column, columns_[f], rows_ * sizeof(T));
+            }
+            columns_[f] = column;
+        }
+        if (has_timestamps_) {
+            int64_t *timestamps = reinterpret_cast<int64_t *>(block + num_features_ * column_bytes);
+            if (rows_ > 0) {
+                std::memcpy(timestamps, timestamps_, rows_ * sizeof(int64_t));
+            }
+            timestamps_ = timestamps;
+        }
+        capacity_ = capacity;
+    }
+
+    // Set the row count, for callers that fill the columns directly
+    void resize(size_t rows) {
+        reserve(rows);
+        rows_ = rows;
+    }
+
+    // Append rows stored row-major, num_features values apart
+    template <typename In>
+    void append_rows(const In *data, size_t rows, const int64_t *timestamps = nullptr) {
+        reserve(rows_ + rows);
+        for (int f = 0; f < num_features_; f++) {
+            T *column = columns_[f] + rows_;
+            for (size_t r = 0; r < rows; r++) {
+                column[r] = T(data[r * num_features_ + f]);
+            }
+        }
+        if (has_timestamps_ && timestamps) {
+            std::memcpy(timestamps_ + rows_, timestamps, rows * sizeof(int64_t));
+        }
+        rows_ += rows;
+    }
+
+    // Forget the timestamp column, e.g. when only some rows had one
+    void clear_timestamps() {
+        has_timestamps_ = false;
+        timestamps_ = nullptr;
+    }
+
+    size_t rows() const { return rows_; }
+    int num_features() const { return num_features_; }
+    bool has_timestamps() const { return has_timestamps_; }
+    const Arena &arena() const { return arena_; }
+
+    ColumnSpan<T> column(int feature) const { return ColumnSpan<T>(columns_[feature], rows_); }
+    T *column_data(int feature) { return columns_[feature]; }
+    ColumnSpan<int64_t> timestamps() const {
+        return has_timestamps_ ? ColumnSpan<int64_t>(timestamps_, rows_) : ColumnSpan<int64_t>();
+    }
+    int64_t *timestamps_data() { return timestamps_; }
+
+    T value(size_t row, int feature) const { return columns_[feature][row]; }
+
+    // Row-major [rows][num_features] copy of rows starting at start, the view
+    // lstm_sequence takes; rows past the end of the series are zero
+    template <typename Out>
+    void copy_window(size_t start, size_t rows, Out *out) const {
+        const size_t available = start < rows_ ? std::min(rows, rows_ - start) : 0;
+        for (int f = 0; f < num_features_; f++) {
+            const T *column = columns_[f] + start;
+            for (size_t r = 0; r < available; r++) {
+                out[r * num_features_ + f] = Out(column[r]);
+            }
+        }
+        std::fill(out + available * num_features_, out + rows * num_features_, Out(0));
+    }
+
+private:
+    Arena arena_;
+    int num_features_;
+    bool has_timestamps_;
+    size_t rows_;
+    size_t capacity_;
+    std::vector<T *> columns_;
+    int64_t *timestamps_;
+};
+
+// Load any data file load_table understands. OHLCV files are copied column by
+// column; text files are parsed straight into the columns, sized from the line
+// count of the file.
+bool load_series(const std::string &file_name, SeriesStore<double> &store);
+
+// Fold every column into the normalizer, then z-score each column in place
+// (same values as normalize_table, column-major)
+void normalize_series(SeriesStore<double> &store, OnlineNormalizer &normalizer);
+
+#endif // SERIES_STORE_H
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "data_io.h"
+#include "serve_protocol.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Sequence length
+
+static_assert(INPUT_SIZE == SERVE_FEATURES, "wire bars are model input bars");
+
+// Client for serve_cpu. By default it replays a data file the way lstm_cpu
+// does: the first SEQ_LENGTH bars as a window, then each day's prediction goes
+// back as the next bar of the same session, whose state the daemon carries
+// from day to day. The predictions go to --out in the out.dat layout. With --bench N, --clients connections each send N window
+// requests back to back, and the client reports round-trip latency
+// percentiles and throughput.
+
+// One request and its response; false when the daemon is gone or refused it
+static bool serve_request(int fd, uint16_t type, const float *bars, int count, uint32_t id, float *prediction) {
+    const ServeRequestHeader request = {SERVE_REQUEST_MAGIC, type, uint16_t(count), id};
+    ServeResponseHeader response;
+    if (!serve_send_all(fd, &request, sizeof(request)) ||
+        !serve_send_all(fd, bars, (size_t)count * INPUT_SIZE * sizeof(float)) ||
+        !serve_recv_all(fd, &response, sizeof(response)) || response.magic != SERVE_RESPONSE_MAGIC) {
+        std::cerr << "Error: Lost the connection to the daemon." << std::endl;
+        return false;
+    }
+    if (response.status != SERVE_OK || response.count != 1 || response.id != id) {
+        std::cerr << "Error: Request " << id << " failed with status " << response.status << "." << std::endl;
+        return false;
+    }
+    return serve_recv_all(fd, prediction, INPUT_SIZE * sizeof(float));
+}
+
+static bool replay(const std::string &socket_path, const std::vector<float> &window, int prediction_days,
+                   const std::string &output_file_name) {
+    const int fd = serve_connect(socket_path);
+    if (fd < 0) {
+        std::cerr << "Error: Could not connect to '" << socket_path << "'." << std::endl;
+        return false;
+    }
+    std::ofstream output_file(output_file_name);
+    float prediction[INPUT_SIZE];
+    bool ok = serve_request(fd, SERVE_WINDOW, window.data(), window.size() / INPUT_SIZE, 0, prediction);
+    for (int day = 0; ok && day < prediction_days; ++day) {
+        output_file << "Day " << day + 1 << ": ";
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            output_file << prediction[i] << " ";
+        }
+        output_file << "\n";
+        if (day + 1 < prediction_days) {
+            ok = serve_request(fd, SERVE_BAR, prediction, 1, day + 1, prediction);
+        }
+    }
+    ::close(fd);
+    if (ok) {
+        std::cout << "Debug: Results written to '" << output_file_name << "'." << std::endl;
+    }
+    return ok;
+}
+
+static bool bench(const std::string &socket_path, const std::vector<float> &window, int requests, int clients) {
+    std::vector<std::vector<double>> latencies(clients);
+    std::vector<char> ok(clients, 1);
+    std::vector<std::thread> threads;
+    const auto start = std::chrono::steady_clock::now();
+    for (int k = 0; k < clients; k++) {
+        threads.emplace_back([&, k] {
+            const int fd = serve_connect(socket_path);
+            if (fd < 0) {
+                ok[k] = 0;
+                return;
+            }
+            float prediction[INPUT_SIZE];
+            latencies[k].reserve(requests);
+            for (int r = 0; r < requests && ok[k]; r++) {
+                const auto sent = std::chrono::steady_clock::now();
+                ok[k] = serve_request(fd, SERVE_WINDOW, window.data(), window.size() / INPUT_SIZE, r, prediction);
+                latencies[k].push_back(
+                    std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - sent).count());
+            }
+            ::close(fd);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (std::find(ok.begin(), ok.end(), 0) != ok.end()) {
+        std::cerr << "Error: Could not complete the run against '" << socket_path << "'." << std::endl;
+        return false;
+    }
+
+    std::vector<double> all;
+    for (const auto &l : latencies) {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) { return all[std::min(all.size() - 1, size_t(p * all.size()))]; };
+    std::cout << "Debug: " << all.size() << " requests from " << clients << " clients in " << seconds * 1e3
+              << " ms, " << all.size() / seconds << " requests/s." << std::endl;
+    std::cout << "Debug: Round trip us: p50 " << percentile(0.50) << ", p90 " << percentile(0.90) << ", p99 "
+              << percentile(0.99) << ", max " << all.back() << std::endl;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    std::string socket_path = SERVE_DEFAULT_SOCKET;
+    std::string output_file_name = "serve_out.dat";
+    std::string file_name;
+    int requests = 0;
+    int clients = 1;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            output_file_name = argv[++i];
+        } else if (arg == "--bench" && i + 1 < argc) {
+            requests = std::atoi(argv[++i]);
+        } else if (arg == "--clients" && i + 1 < argc) {
+            clients = std::atoi(argv[++i]);
+        } else {
+            file_name = arg;
+        }
+    }
+
+    if (file_name.empty() || requests < 0 || clients < 1) {
+        std::cerr << "Usage: " << argv[0] << " [--socket Path] [--out File] [--bench N] [--clients N] <Data File>"
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    DataTable table;
+    if (!load_table(file_name, table) || table.rows() == 0 || table.num_features != INPUT_SIZE) {
+        std::cerr << "Error: No " << INPUT_SIZE << "-feature data loaded from " << file_name << std::endl;
+        return EXIT_FAILURE;
+    }
+    // Raw bars: the daemon normalizes with its own statistics
+    const size_t rows = std::min<size_t>(table.rows(), SEQ_LENGTH);
+    std::vector<float> window(table.values.begin(), table.values.begin() + rows * INPUT_SIZE);
+
+    const bool ok = requests > 0 ? bench(socket_path, window, requests, clients)
+                                 : replay(socket_path, window, table.prediction_days, output_file_name);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,463 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <vector>
+#include "data_io.h"
+#include "lstm_batch.h"
+#include "lstm_weight_io.h"
+#include "serve_protocol.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Sequence length
+#define MAX_BATCH 64      // Sequences per GEMM
+#define WINDOW_US 200     // Longest a request waits for others to share its batch
+#define MAX_OUT_BYTES (1 << 20)   // Replies queued for a client that stopped reading before it is dropped
+
+static_assert(INPUT_SIZE == SERVE_FEATURES, "wire bars are model input bars");
+
+// Prediction daemon: the weights and normalizer stay loaded, and clients send
+// bars or windows over a Unix domain socket (serve_protocol.h). One thread
+// runs a ppoll loop. Requests parsed from all connections queue for one
+// lstm_sequence_batch call. A batch runs when it holds --max-batch requests or
+// when its oldest request has waited --window-us, whichever comes first. It
+// also runs at once when every open connection has a request in it, since no
+// one else can join. Requests that arrive while a batch computes are queued
+// for the next one. Each connection carries h/c from one prediction to the
+// next, like the rolling forecast of lstm_cpu and the testbench, so a second
+// request from a connection already in the batch runs the batch first.
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void request_stop(int) { stop_requested = 1; }
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct Connection {
+    int fd;
+    bool broken;                  // socket error, protocol error or overflow; closed by the loop
+    bool half_closed;             // the client shut down its write side; closed once its replies are sent
+    std::vector<char> in;         // received bytes of incomplete requests
+    std::vector<char> out;        // responses the socket has not taken yet
+    std::vector<float> window;    // [SEQ_LENGTH][INPUT_SIZE] normalized session window, newest bar last
+    std::vector<float> h, c;      // state the last prediction ended in, the next one starts from it
+    int pending;                  // predictions waiting for the batch
+
+    Connection(int f, int hidden_size)
+        : fd(f), broken(false), half_closed(false), window(SEQ_LENGTH * INPUT_SIZE, 0.0f), h(hidden_size, 0.0f),
+          c(hidden_size, 0.0f), pending(0) {}
+};
+
+class PredictionServer {
+public:
+    PredictionServer(const PackedLstmWeights<float> &weights, const OnlineNormalizer &normalizer, int max_batch,
+                     long window_us)
+        : weights_(weights), normalizer_(normalizer), ws_(weights, max_batch), max_batch_(max_batch),
+          window_ns_(window_us * 1000), listen_fd_(-1), deadline_ns_(0),
+          x_seq_((size_t)max_batch * SEQ_LENGTH * INPUT_SIZE), h_((size_t)max_batch * weights.hidden_size),
+          c_((size_t)max_batch * weights.hidden_size), output_((size_t)max_batch * INPUT_SIZE),
+          requests_(0), batches_(0), errors_(0), latency_total_ns_(0), latency_max_ns_(0) {}
+
+    ~PredictionServer() {
+        for (auto &conn : connections_) {
+            if (conn->fd >= 0) {
+                ::close(conn->fd);
+            }
+        }
+        if (listen_fd_ >= 0) {
+            ::close(listen_fd_);
+            ::unlink(socket_path_.c_str());
+        }
+    }
+
+    bool listen(const std::string &path) {
+        sockaddr_un address;
+        if (!serve_socket_address(path, address)) {
+            std::cerr << "Error: Socket path '" << path << "' is too long." << std::endl;
+            return false;
+        }
+        ::unlink(path.c_str());
+        listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listen_fd_ < 0 || ::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listen_fd_, 128) != 0) {
+            std::cerr << "Error: Could not listen on '" << path << "': " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        socket_path_ = path;
+        return true;
+    }
+
+    // Serve until SIGINT/SIGTERM
+    void run() {
+        std::vector<pollfd> fds;
+        std::vector<Connection *> polled;
+        while (!stop_requested) {
+            fds.assign(1, pollfd{listen_fd_, POLLIN, 0});
+            polled.clear();
+            for (auto &conn : connections_) {
+                if (!conn->broken) {
+                    const short events = (conn->half_closed ? 0 : POLLIN) | (conn->out.empty() ? 0 : POLLOUT);
+                    fds.push_back(pollfd{conn->fd, events, 0});
+                    polled.push_back(conn.get());
+                }
+            }
+
+            timespec timeout, *timeout_ptr = nullptr;
+            if (!pending_.empty()) {
+                const int64_t remaining = std::max<int64_t>(0, deadline_ns_ - now_ns());
+                timeout.tv_sec = remaining / 1000000000;
+                timeout.tv_nsec = remaining % 1000000000;
+                timeout_ptr = &timeout;
+            }
+            if (::ppoll(fds.data(), fds.size(), timeout_ptr, nullptr) < 0 && errno != EINTR) {
+                std::cerr << "Error: ppoll failed: " << std::strerror(errno) << std::endl;
+                break;
+            }
+
+            for (size_t i = 0; i < polled.size(); i++) {
+                const short events = fds[i + 1].revents;
+                if (polled[i]->half_closed) {
+                    // Nothing more to read; a hangup or error now means the replies cannot be delivered
+                    if (events & (POLLHUP | POLLERR)) {
+                        polled[i]->broken = true;
+                    }
+                } else if (events & (POLLIN | POLLHUP | POLLERR)) {
+                    receive(*polled[i]);
+                }
+                if ((events & POLLOUT) && !polled[i]->broken) {
+                    flush(*polled[i]);
+                }
+            }
+            if (fds[0].revents & POLLIN) {
+                accept_all();
+            }
+
+            if (!pending_.empty() && (now_ns() >= deadline_ns_ || !any_idle_connection())) {
+                run_batch();
+            }
+            sweep();
+        }
+    }
+
+    void print_stats() const {
+        std::cout << "Debug: Served " << requests_ << " predictions in " << batches_ << " batches (mean batch "
+                  << (batches_ > 0 ? double(requests_) / batches_ : 0.0) << "), " << errors_ << " bad requests."
+                  << std::endl;
+        if (requests_ > 0) {
+            std::cout << "Debug: Request to response: mean " << latency_total_ns_ / 1e3 / requests_ << " us, max "
+                      << latency_max_ns_ / 1e3 << " us." << std::endl;
+        }
+    }
+
+private:
+    struct Pending {
+        Connection *conn;
+        uint32_t id;
+        int64_t received_ns;
+    };
+
+    void accept_all() {
+        for (;;) {
+            const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                return;
+            }
+            connections_.emplace_back(new Connection(fd, weights_.hidden_size));
+        }
+    }
+
+    // A connection with nothing queued could still add to the batch; when every
+    // client is already waiting on it, holding it open only adds latency
+    bool any_idle_connection() const {
+        for (const auto &conn : connections_) {
+            if (!conn->broken && !conn->half_closed && conn->pending == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Read whatever the socket has and handle every complete request in it. At
+    // EOF the requests already buffered are still answered.
+    void receive(Connection &conn) {
+        char buffer[65536];
+        for (;;) {
+            const ssize_t n = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                conn.in.insert(conn.in.end(), buffer, buffer + n);
+                continue;
+            }
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            if (n == 0) {
+                conn.half_closed = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn.broken = true;
+            }
+            break;
+        }
+
+        size_t offset = 0;
+        while (!conn.broken && conn.in.size() - offset >= sizeof(ServeRequestHeader)) {
+            ServeRequestHeader header;
+            std::memcpy(&header, &conn.in[offset], sizeof(header));
+            if (header.magic != SERVE_REQUEST_MAGIC) {
+                conn.broken = true;   // out of sync, nothing later can be trusted
+                break;
+            }
+            const size_t payload = (size_t)header.count * INPUT_SIZE * sizeof(float);
+            if (conn.in.size() - offset < sizeof(header) + payload) {
+                break;
+            }
+            handle(conn, header, reinterpret_cast<const float *>(&conn.in[offset + sizeof(header)]));
+            offset += sizeof(header) + payload;
+        }
+        conn.in.erase(conn.in.begin(), conn.in.begin() + offset);
+        if (conn.half_closed) {
+            conn.in.clear();   // a partial request can no longer complete
+        }
+    }
+
+    void handle(Connection &conn, const ServeRequestHeader &header, const float *bars) {
+        const bool valid = (header.type == SERVE_WINDOW && header.count >= 1 && header.count <= SEQ_LENGTH) ||
+                           (header.type == SERVE_BAR && header.count >= 1);
+        if (!valid) {
+            errors_++;
+            respond(conn, header.id, SERVE_BAD_REQUEST, nullptr);
+            flush(conn);
+            return;
+        }
+
+        // A new window starts a new session from zero state. Every bar shifts
+        // the window and lands in its last row, as in lstm_cpu's rolling loop.
+        if (header.type == SERVE_WINDOW) {
+            std::fill(conn.window.begin(), conn.window.end(), 0.0f);
+            std::fill(conn.h.begin(), conn.h.end(), 0.0f);
+            std::fill(conn.c.begin(), conn.c.end(), 0.0f);
+        }
+        float bar[INPUT_SIZE];
+        for (int k = 0; k < header.count; k++) {
+            std::memcpy(bar, bars + k * INPUT_SIZE, sizeof(bar));   // the payload need not be aligned
+            std::copy(conn.window.begin() + INPUT_SIZE, conn.window.end(), conn.window.begin());
+            normalizer_.normalize(bar, &conn.window[(SEQ_LENGTH - 1) * INPUT_SIZE]);
+        }
+
+        // This prediction starts from the state the connection's previous one ends in
+        if (conn.pending > 0) {
+            run_batch();
+        }
+
+        const int64_t now = now_ns();
+        if (pending_.empty()) {
+            deadline_ns_ = now + window_ns_;
+        }
+        const size_t slot = pending_.size();
+        std::copy(conn.window.begin(), conn.window.end(), x_seq_.begin() + slot * SEQ_LENGTH * INPUT_SIZE);
+        std::copy(conn.h.begin(), conn.h.end(), h_.begin() + slot * weights_.hidden_size);
+        std::copy(conn.c.begin(), conn.c.end(), c_.begin() + slot * weights_.hidden_size);
+        pending_.push_back(Pending{&conn, header.id, now});
+        conn.pending++;
+        if ((int)pending_.size() == max_batch_) {
+            run_batch();
+        }
+    }
+
+    void run_batch() {
+        const int batch = pending_.size();
+        const int hidden = weights_.hidden_size;
+        lstm_sequence_batch(weights_, ws_, x_seq_.data(), SEQ_LENGTH, h_.data(), c_.data(), output_.data(), batch);
+
+        const int64_t now = now_ns();
+        float prediction[INPUT_SIZE];
+        for (int b = 0; b < batch; b++) {
+            const Pending &request = pending_[b];
+            std::copy(h_.begin() + (size_t)b * hidden, h_.begin() + (size_t)(b + 1) * hidden, request.conn->h.begin());
+            std::copy(c_.begin() + (size_t)b * hidden, c_.begin() + (size_t)(b + 1) * hidden, request.conn->c.begin());
+            for (int i = 0; i < INPUT_SIZE; i++) {
+                prediction[i] = float(normalizer_.denormalize(i, output_[(size_t)b * INPUT_SIZE + i]));
+            }
+            request.conn->pending--;
+            if (!request.conn->broken) {
+                respond(*request.conn, request.id, SERVE_OK, prediction);
+            }
+            latency_total_ns_ += now - request.received_ns;
+            latency_max_ns_ = std::max(latency_max_ns_, now - request.received_ns);
+        }
+        for (const Pending &request : pending_) {
+            if (!request.conn->broken && !request.conn->out.empty()) {
+                flush(*request.conn);
+            }
+        }
+        requests_ += batch;
+        batches_++;
+        pending_.clear();
+    }
+
+    void respond(Connection &conn, uint32_t id, ServeStatus status, const float *prediction) {
+        if (conn.out.size() + sizeof(ServeResponseHeader) + INPUT_SIZE * sizeof(float) > MAX_OUT_BYTES) {
+            conn.broken = true;   // the client is not reading its replies
+            return;
+        }
+        const ServeResponseHeader header = {SERVE_RESPONSE_MAGIC, uint16_t(status), uint16_t(prediction ? 1 : 0), id};
+        const char *p = reinterpret_cast<const char *>(&header);
+        conn.out.insert(conn.out.end(), p, p + sizeof(header));
+        if (prediction) {
+            p = reinterpret_cast<const char *>(prediction);
+            conn.out.insert(conn.out.end(), p, p + INPUT_SIZE * sizeof(float));
+        }
+    }
+
+    // Hand queued responses to the socket; what does not fit waits for POLLOUT
+    void flush(Connection &conn) {
+        size_t sent = 0;
+        while (sent < conn.out.size()) {
+            const ssize_t n = ::send(conn.fd, &conn.out[sent], conn.out.size() - sent, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && errno == EINTR) {
+                continue;
+            } else {
+                if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+                    conn.broken = true;
+                }
+                break;
+            }
+        }
+        conn.out.erase(conn.out.begin(), conn.out.begin() + sent);
+    }
+
+    // Close broken connections, and half-closed ones with every reply sent,
+    // once no queued request points at them
+    void sweep() {
+        for (size_t i = 0; i < connections_.size();) {
+            Connection &conn = *connections_[i];
+            if ((conn.broken || (conn.half_closed && conn.out.empty())) && conn.pending == 0) {
+                ::close(conn.fd);
+                connections_[i] = std::move(connections_.back());
+                connections_.pop_back();
+            } else {
+                i++;
+            }
+        }
+    }
+
+    const PackedLstmWeights<float> &weights_;
+    const OnlineNormalizer &normalizer_;
+    LstmBatchWorkspace<float> ws_;
+    const int max_batch_;
+    const int64_t window_ns_;
+    int listen_fd_;
+    std::string socket_path_;
+    std::vector<std::unique_ptr<Connection>> connections_;
+    std::vector<Pending> pending_;
+    int64_t deadline_ns_;   // when the oldest pending request has waited the batching window
+    std::vector<float> x_seq_, h_, c_, output_;
+    long requests_, batches_, errors_;
+    int64_t latency_total_ns_, latency_max_ns_;
+};
+
+int main(int argc, char **argv) {
+    int hidden_size = 16;
+    int max_batch = MAX_BATCH;
+    long window_us = WINDOW_US;
+    std::string socket_path = SERVE_DEFAULT_SOCKET;
+    std::string weights_file_name, activation_name, data_file_name;
+    std::string normalizer_file_name = NORMALIZER_FILE;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg == "--hidden" && i + 1 < argc) {
+            hidden_size = std::atoi(argv[++i]);
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else if (arg == "--normalizer" && i + 1 < argc) {
+            normalizer_file_name = argv[++i];
+        } else if (arg == "--data" && i + 1 < argc) {
+            data_file_name = argv[++i];
+        } else if (arg == "--max-batch" && i + 1 < argc) {
+            max_batch = std::atoi(argv[++i]);
+        } else if (arg == "--window-us" && i + 1 < argc) {
+            window_us = std::atol(argv[++i]);
+        } else {
+            hidden_size = 0;
+            break;
+        }
+    }
+
+    if (hidden_size < INPUT_SIZE || max_batch < 1 || window_us < 0) {
+        std::cerr << "Usage: " << argv[0] << " [--socket Path] [--hidden N] [--weights File] [--act Tier]"
+                  << " [--normalizer File | --data File] [--max-batch N] [--window-us N]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Statistics from --data, else the state file lstm_cpu and the testbench save
+    OnlineNormalizer normalizer(INPUT_SIZE);
+    if (!data_file_name.empty()) {
+        DataTable table;
+        if (!load_table(data_file_name, table) || table.rows() == 0 || table.num_features != INPUT_SIZE) {
+            std::cerr << "Error: No " << INPUT_SIZE << "-feature data loaded from " << data_file_name << std::endl;
+            return EXIT_FAILURE;
+        }
+        std::vector<double> normalized_data;
+        normalize_table(table, normalizer, normalized_data);
+    } else if (!normalizer.load(normalizer_file_name) || normalizer.num_features() != INPUT_SIZE) {
+        std::cerr << "Error: No " << INPUT_SIZE << "-feature normalizer state, pass --data or --normalizer."
+                  << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    // Weights from --weights (activation recorded in the file), else the usual initialization
+    WeightFile weight_file;
+    PackedLstmWeights<float> weights;
+    if (!weights_file_name.empty()) {
+        if (!weight_file.open(weights_file_name) || !load_packed_lstm_weights(weight_file, INPUT_SIZE, weights)) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        LstmModelRuntime<float> model(INPUT_SIZE, hidden_size, SEQ_LENGTH);
+        model.initialize_weights_and_biases();
+        weights = pack_lstm_weights(model);
+    }
+    if (!activation_name.empty()) {
+        weights.activation = activation;
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;   // no SA_RESTART, so ppoll returns EINTR
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    PredictionServer server(weights, normalizer, max_batch, window_us);
+    if (!server.listen(socket_path)) {
+        return EXIT_FAILURE;
+    }
+    std::cout << "Debug: Serving hidden size " << weights.hidden_size << " with " << lstm_simd_name(lstm_simd_level())
+              << " kernels and " << lstm_activation_name(weights.activation) << " activations on '" << socket_path
+              << "', batches of up to " << max_batch << " within " << window_us << " us." << std::endl;
+    server.run();
+    server.print_stats();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#ifndef SERVE_PROTOCOL_H
+#define SERVE_PROTOCOL_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Wire format of the serve_cpu prediction daemon, a stream over a Unix domain
+// socket. Native byte order, since both ends share the host. Every request is
+// a 12-byte header followed by count raw (not normalized) bars of
+// SERVE_FEATURES float32 values. The daemon answers each request with a 12-byte
+// header followed by count bars; count is 1 (the denormalized next-bar
+// prediction), or 0 on error.
+//
+// Every connection has a session: a window of the last seq_length normalized
+// bars and the LSTM state. Each bar shifts the window and becomes its last row,
+// so until seq_length bars have arrived the window is zero-padded at the
+// start. SERVE_WINDOW starts a new session (empty window, zero state) with the
+// given bars, SERVE_BAR appends to the current one, and both then predict from
+// the window. The state carries over from one prediction to the next, as in
+// the rolling forecast of lstm_cpu and the LSTM_RNN_HW testbench. Predictions
+// come back in request order on each connection; an error reply is sent at
+// once and may overtake predictions still waiting for their batch, so match
+// replies by id.
+
+#define SERVE_FEATURES 5
+#define SERVE_REQUEST_MAGIC 0x51524c53u    // "SLRQ"
+#define SERVE_RESPONSE_MAGIC 0x53524c53u   // "SLRS"
+#define SERVE_DEFAULT_SOCKET "lstm_serve.sock"
+
+enum ServeRequestType {
+    SERVE_WINDOW = 1,   // start a new session with count (<= seq_length) bars
+    SERVE_BAR = 2       // append count bars to the session window
+};
+
+enum ServeStatus {
+    SERVE_OK = 0,
+    SERVE_BAD_REQUEST = 1   // unknown type or count out of range
+};
+
+struct ServeRequestHeader {
+    uint32_t magic;
+    uint16_t type;
+    uint16_t count;   // bars of SERVE_FEATURES floats that follow
+    uint32_t id;      // echoed in the response
+};
+
+struct ServeResponseHeader {
+    uint32_t magic;
+    uint16_t status;
+    uint16_t count;   // predicted bars of SERVE_FEATURES floats that follow
+    uint32_t id;
+};
+
+static_assert(sizeof(ServeRequestHeader) == 12 && sizeof(ServeResponseHeader) == 12, "packed wire headers");
+
+inline bool serve_socket_address(const std::string &path, sockaddr_un &address) {
+    if (path.size() >= sizeof(address.sun_path)) {
+        return false;
+    }
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+// Blocking helpers for clients: the whole buffer or false
+inline bool serve_send_all(int fd, const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        const ssize_t n = ::send(fd, p, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+inline bool serve_recv_all(int fd, void *data, size_t size) {
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        const ssize_t n = ::recv(fd, p, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// Connected client socket, or -1
+inline int serve_connect(const std::string &path) {
+    sockaddr_un address;
+    if (!serve_socket_address(path, address)) {
+        return -1;
+    }
+    const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#endif // SERVE_PROTOCOL_H
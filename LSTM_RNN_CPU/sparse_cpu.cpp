@@ -0,0 +1,262 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include "lstm_rollout.h"
+#include "lstm_sparse.h"
+#include "lstm_weight_io.h"
+#include "prediction_metrics.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Sequence length
+
+// Sweeps block-sparse pruning of the LSTM recurrent weights and reports the
+// accuracy/speed trade-off. For every hidden size the dense packed engine is
+// rolled over each data file exactly like lstm_cpu (window of the first
+// SEQ_LENGTH bars, predictions fed back, h/c kept across days), then every
+// sparsity level is pruned, checked against the dense kernels on the same
+// pruned weights, rolled the same way and scored per feature against the dense
+// predictions. A tick is one cell step, the unit a live feed pays per new bar;
+// --budget-us marks the levels that fit and names the lowest one per size.
+// Without --weights every size is pruned from random weights, which the report
+// says; the accuracy columns then show how pruning moves an untrained model.
+
+// Comma-separated numbers, e.g. "16,64,256" or "0,0.5,0.9"
+std::vector<double> parse_list(const std::string &list) {
+    std::vector<double> values;
+    std::stringstream ss(list);
+    for (std::string item; std::getline(ss, item, ',');) {
+        if (!item.empty()) {
+            values.push_back(std::atof(item.c_str()));
+        }
+    }
+    return values;
+}
+
+// Mean per-tick time over one sequence: the state is carried so every step sees a live h
+template <typename Cell>
+double tick_us(int repeat, int hidden_size, const std::vector<float> &window, Cell cell) {
+    std::vector<float> h(hidden_size, 0.0f), c(hidden_size, 0.0f);
+    return time_us(repeat, [&]() {
+        std::fill(h.begin(), h.end(), 0.0f);
+        std::fill(c.begin(), c.end(), 0.0f);
+        for (int t = 0; t < SEQ_LENGTH; t++) {
+            cell(&window[t * INPUT_SIZE], h.data(), c.data());
+        }
+    }) / SEQ_LENGTH;
+}
+
+int sweep_hidden_size(std::ostringstream &report, const std::vector<LstmSeries> &series, PackedLstmWeights<float> weights,
+                      const std::string &weights_label, const std::vector<double> &levels, double budget_us, int repeat,
+                      std::string &budget_summary) {
+    static const std::vector<std::string> names = {"Open", "Close", "High", "Low", "Volume"};
+    const int hidden = weights.hidden_size;
+
+    LstmWorkspace<float> ws(weights);
+    std::vector<std::vector<float>> dense_predictions;
+    for (const LstmSeries &s : series) {
+        dense_predictions.push_back(rollout(s, hidden, [&](const float *x, float *h, float *c) {
+            lstm_cell_packed(weights, ws, x, h, c, h, c);
+        }));
+    }
+    const size_t dense_bytes = (size_t)weights.rows() * weights.stride * sizeof(float) +
+                               lstm_padded<float>(weights.rows()) * sizeof(float);
+    const double dense_us = tick_us(repeat, hidden, series[0].window, [&](const float *x, float *h, float *c) {
+        lstm_cell_packed(weights, ws, x, h, c, h, c);
+    });
+
+    report << "\nLSTM " << INPUT_SIZE << "x" << hidden << ", " << weights_label << ", "
+           << lstm_activation_name(weights.activation) << " activations, " << series.size() << " data files\n"
+           << "Dense: " << dense_bytes << " B, " << dense_us << " us per tick, " << dense_us * SEQ_LENGTH
+           << " us per sequence of " << SEQ_LENGTH << "\n";
+
+    char line[512];
+    std::snprintf(line, sizeof(line), "%8s %7s %10s %9s %8s %10s %7s", "Sparsity", "Blocks", "Bytes", "Tick us",
+                  "Speedup", "Check", "Budget");
+    report << line;
+    for (const std::string &name : names) {
+        std::snprintf(line, sizeof(line), " %9s", name.c_str());
+        report << line;
+    }
+    report << "   (accuracy % vs dense)\n";
+
+    double fitting_level = -1.0;
+    for (double level : levels) {
+        const SparseLstmWeights<float> sparse = prune_lstm_weights(weights, level);
+        SparseLstmWorkspace<float> sws(sparse);
+
+        // Kernel check: the sparse cell against the dense kernels on the same pruned weights
+        const PackedLstmWeights<float> pruned = densify_lstm_weights(sparse);
+        LstmWorkspace<float> pws(pruned);
+        std::vector<float> h_sparse(hidden, 0.0f), c_sparse(hidden, 0.0f), h_dense(hidden, 0.0f), c_dense(hidden, 0.0f);
+        std::vector<float> out(INPUT_SIZE);
+        lstm_sequence_sparse(sparse, sws, series[0].window.data(), SEQ_LENGTH, h_sparse.data(), c_sparse.data(), out.data());
+        lstm_sequence_packed(pruned, pws, series[0].window.data(), SEQ_LENGTH, h_dense.data(), c_dense.data(), out.data());
+        double check = 0.0;
+        for (int i = 0; i < hidden; i++) {
+            check = std::max(check, (double)std::fabs(h_sparse[i] - h_dense[i]));
+        }
+        if (check > 1e-4) {
+            std::cerr << "Error: Sparse kernel differs from dense by " << check << " at hidden " << hidden
+                      << ", sparsity " << level << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        PredictionMetrics metrics(INPUT_SIZE);
+        std::vector<double> predicted(INPUT_SIZE), reference(INPUT_SIZE);
+        for (size_t s = 0; s < series.size(); s++) {
+            const std::vector<float> pred = rollout(series[s], hidden, [&](const float *x, float *h, float *c) {
+                lstm_cell_sparse(sparse, sws, x, h, c, h, c);
+            });
+            for (size_t k = 0; k + INPUT_SIZE <= pred.size(); k += INPUT_SIZE) {
+                for (int f = 0; f < INPUT_SIZE; f++) {
+                    predicted[f] = series[s].normalizer.denormalize(f, pred[k + f]);
+                    reference[f] = series[s].normalizer.denormalize(f, dense_predictions[s][k + f]);
+                }
+                metrics.add(predicted.data(), reference.data());
+            }
+        }
+
+        const double sparse_us = tick_us(repeat, hidden, series[0].window, [&](const float *x, float *h, float *c) {
+            lstm_cell_sparse(sparse, sws, x, h, c, h, c);
+        });
+        const bool fits = budget_us <= 0.0 || sparse_us <= budget_us;
+        if (fits && fitting_level < 0.0) {
+            fitting_level = sparse.sparsity();
+        }
+
+        std::snprintf(line, sizeof(line), "%7.1f%% %7d %10zu %9.3f %7.2fx %10.2g %7s", 100.0 * sparse.sparsity(),
+                      sparse.blocks(), sparse.weight_bytes(), sparse_us, dense_us / sparse_us, check,
+                      budget_us <= 0.0 ? "-" : fits ? "ok" : "over");
+        report << line;
+        for (int f = 0; f < INPUT_SIZE; f++) {
+            std::snprintf(line, sizeof(line), " %8.3f%%", metrics.accuracy(f));
+            report << line;
+        }
+        report << "\n";
+    }
+
+    if (budget_us > 0.0) {
+        std::ostringstream summary;
+        summary << "Hidden " << hidden << ": ";
+        if (dense_us <= budget_us) {
+            summary << "dense fits (" << dense_us << " us)";
+        } else if (fitting_level >= 0.0) {
+            summary << "lowest fitting sparsity " << 100.0 * fitting_level << "%";
+        } else {
+            summary << "no level fits";
+        }
+        budget_summary += summary.str() + "\n";
+    }
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char **argv) {
+    int repeat = 200;
+    double budget_us = 0.0;
+    std::string hidden_list = "16,64,256", level_list = "0,0.25,0.5,0.75,0.9";
+    std::string weights_file_name, activation_name, report_file_name = "sparse_report.txt";
+    std::vector<std::string> data_files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hidden" && i + 1 < argc) {
+            hidden_list = argv[++i];
+        } else if (arg == "--levels" && i + 1 < argc) {
+            level_list = argv[++i];
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--budget-us" && i + 1 < argc) {
+            budget_us = std::atof(argv[++i]);
+        } else if (arg == "--report" && i + 1 < argc) {
+            report_file_name = argv[++i];
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else {
+            data_files.push_back(arg);
+        }
+    }
+
+    std::vector<double> hidden_sizes = parse_list(hidden_list), levels = parse_list(level_list);
+    std::sort(levels.begin(), levels.end());
+    bool valid = !data_files.empty() && repeat > 0 && !levels.empty() && !hidden_sizes.empty();
+    for (double hidden : hidden_sizes) {
+        valid = valid && hidden >= INPUT_SIZE;
+    }
+    for (double level : levels) {
+        valid = valid && level >= 0.0 && level <= 1.0;
+    }
+    if (!valid) {
+        std::cerr << "Usage: " << argv[0] << " [--hidden N,N,...] [--weights File] [--act Tier]"
+                  << " [--levels s,s,...] [--budget-us T] [--report File] [--repeat N] <Data File...>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<LstmSeries> series(data_files.size());
+    for (size_t s = 0; s < data_files.size(); s++) {
+        if (!load_lstm_series(data_files[s], INPUT_SIZE, SEQ_LENGTH, series[s])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ostringstream report;
+    report << "Block-sparse engine report: " << LSTM_GATES << "x" << LSTM_SPARSE_BLOCK
+           << " blocks of the recurrent weights pruned by magnitude, " << lstm_simd_name(lstm_simd_level())
+           << " kernels";
+    if (budget_us > 0.0) {
+        report << ", tick budget " << budget_us << " us";
+    }
+    report << "\n";
+    if (weights_file_name.empty()) {
+        report << "No --weights: every hidden size is pruned from random weights, so the accuracy columns show how "
+                  "pruning moves an untrained model, not a trained one\n";
+    }
+
+    std::string budget_summary;
+    WeightFile weight_file;
+    if (!weights_file_name.empty()) {
+        // A trained model fixes the hidden size
+        PackedLstmWeights<float> weights;
+        if (!weight_file.open(weights_file_name) || !load_packed_lstm_weights(weight_file, INPUT_SIZE, weights)) {
+            return EXIT_FAILURE;
+        }
+        if (!activation_name.empty()) {
+            weights.activation = activation;
+        }
+        if (sweep_hidden_size(report, series, std::move(weights), weights_file_name + " weights", levels, budget_us,
+                              repeat, budget_summary) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        for (double hidden : hidden_sizes) {
+            LstmModelRuntime<float> model(INPUT_SIZE, (int)hidden, SEQ_LENGTH);
+            model.initialize_weights_and_biases();
+            PackedLstmWeights<float> weights = pack_lstm_weights(model);
+            weights.activation = activation;
+            if (sweep_hidden_size(report, series, std::move(weights), "random weights", levels, budget_us, repeat,
+                                  budget_summary) != EXIT_SUCCESS) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    if (!budget_summary.empty()) {
+        report << "\nWithin " << budget_us << " us per tick:\n" << budget_summary;
+    }
+
+    std::cout << report.str();
+    std::ofstream report_file(report_file_name);
+    report_file << report.str();
+    std::cout << "Debug: Report written to '" << report_file_name << "'." << std::endl;
+    return EXIT_SUCCESS;
+}
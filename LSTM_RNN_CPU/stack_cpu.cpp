@@ -0,0 +1,196 @@
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "data_io.h"
+#include "lstm_stack.h"
+#include "lstm_weight_io.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Default sequence length
+
+// "50,50" to {50, 50}
+static bool parse_layers(const std::string &text, std::vector<int> &hidden_sizes) {
+    hidden_sizes.clear();
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        const int hidden = std::atoi(item.c_str());
+        if (hidden <= 0) {
+            return false;
+        }
+        hidden_sizes.push_back(hidden);
+    }
+    return !hidden_sizes.empty();
+}
+
+// Seconds per sequence of fn over repeat runs
+template <typename Fn>
+static double time_per_sequence(int repeat, Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeat; i++) {
+        fn();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / repeat;
+}
+
+// Stacked LSTM with a dense head (the Keras LSTM(50) -> LSTM(50) -> Dense(5)
+// shape). Rolls the prediction forward like lstm_cpu, every window from zero
+// state as Keras predicts, running the layers as a wavefront across cores.
+int main(int argc, char **argv) {
+    std::string layers_text = "50,50";
+    int seq_length = SEQ_LENGTH;
+    int repeat = 200;
+    bool serial = false;
+    std::string data_file;
+    std::string weights_file_name, activation_name;
+    std::string output_file_name = "out.dat";
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--layers" && i + 1 < argc) {
+            layers_text = argv[++i];
+        } else if (arg == "--seq" && i + 1 < argc) {
+            seq_length = std::atoi(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            repeat = std::atoi(argv[++i]);
+        } else if (arg == "--serial") {
+            serial = true;
+        } else if (arg == "--weights" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else if (arg == "--out" && i + 1 < argc) {
+            output_file_name = argv[++i];
+        } else {
+            data_file = arg;
+        }
+    }
+
+    std::vector<int> hidden_sizes;
+    if (data_file.empty() || !parse_layers(layers_text, hidden_sizes) || seq_length <= 0 || repeat < 0) {
+        std::cerr << "Usage: " << argv[0] << " [--layers N,N,...] [--seq N] [--repeat N] [--serial]"
+                  << " [--weights File] [--act Tier] [--out File] <Data File>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    DataTable table;
+    if (!load_table(data_file, table) || table.rows() == 0 || table.num_features != INPUT_SIZE) {
+        std::cerr << "Error: Expected " << INPUT_SIZE << "-feature data in " << data_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    OnlineNormalizer normalizer(INPUT_SIZE);
+    std::vector<double> normalized_data;
+    normalize_table(table, normalizer, normalized_data);
+
+    // Weights from --weights when it exists, else the usual initialization
+    // (saved to --weights when given, as lstm_cpu does)
+    LstmStack<float> stack;
+    if (!weights_file_name.empty() && std::ifstream(weights_file_name).good()) {
+        WeightFile weight_file;
+        if (!weight_file.open(weights_file_name) || !load_lstm_stack(weight_file, stack)) {
+            return EXIT_FAILURE;
+        }
+        if (stack.input_size() != INPUT_SIZE || stack.output_size != INPUT_SIZE) {
+            std::cerr << "Error: Stack maps " << stack.input_size() << " to " << stack.output_size
+                      << " features; expected " << INPUT_SIZE << std::endl;
+            return EXIT_FAILURE;
+        }
+        if (!activation_name.empty()) {
+            stack.set_activation(activation);
+        }
+    } else {
+        stack = LstmStack<float>(INPUT_SIZE, hidden_sizes, INPUT_SIZE);
+        stack.initialize_weights_and_biases();
+        stack.set_activation(activation);
+        if (!weights_file_name.empty()) {
+            if (!save_lstm_stack(weights_file_name, stack)) {
+                return EXIT_FAILURE;
+            }
+            std::cout << "Debug: Initialized stack saved to '" << weights_file_name << "'." << std::endl;
+        }
+    }
+
+    std::cout << "Debug: Stack of " << stack.num_layers() << " layers (";
+    for (int k = 0; k < stack.num_layers(); k++) {
+        std::cout << (k ? "," : "") << stack.layers[k].hidden_size;
+    }
+    std::cout << ") with a " << stack.output_size << "-output head, " << (serial ? "serial" : "wavefront")
+              << " execution and " << lstm_activation_name(stack.layers.front().activation) << " activations."
+              << std::endl;
+
+    std::vector<float> input_seq(seq_length * INPUT_SIZE, 0.0f);
+    for (int i = 0; i < seq_length && i < (int)(normalized_data.size() / INPUT_SIZE); ++i) {
+        for (int j = 0; j < INPUT_SIZE; ++j) {
+            input_seq[i * INPUT_SIZE + j] = float(normalized_data[i * INPUT_SIZE + j]);
+        }
+    }
+
+    LstmStackState<float> state(stack);
+    LstmStackPipeline<float> pipeline(stack, seq_length);
+    float serial_out[INPUT_SIZE], wavefront_out[INPUT_SIZE];
+
+    // Both schedules on the first window: they must agree bit for bit
+    if (repeat > 0) {
+        const double serial_time = time_per_sequence(repeat, [&] {
+            state.reset();
+            lstm_stack_sequence(stack, state, input_seq.data(), seq_length, serial_out);
+        });
+        const double wavefront_time = time_per_sequence(repeat, [&] {
+            pipeline.state().reset();
+            pipeline.run(input_seq.data(), seq_length, wavefront_out);
+        });
+        bool same = true;
+        for (int j = 0; j < INPUT_SIZE; j++) {
+            same = same && serial_out[j] == wavefront_out[j];
+        }
+        std::cout << "Debug: Serial " << serial_time * 1e6 << " us, wavefront " << wavefront_time * 1e6
+                  << " us per sequence (" << stack.num_layers() << " threads); outputs "
+                  << (same ? "identical" : "DIFFER") << "." << std::endl;
+        if (!same) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::ofstream output_file(output_file_name);
+    float output_data[INPUT_SIZE] = {0};
+    for (int day = 0; day < table.prediction_days; ++day) {
+        if (serial) {
+            state.reset();
+            lstm_stack_sequence(stack, state, input_seq.data(), seq_length, output_data);
+        } else {
+            pipeline.state().reset();
+            if (!pipeline.run(input_seq.data(), seq_length, output_data)) {
+                std::cerr << "Error: Sequence length " << seq_length << " exceeds the pipeline buffers." << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+
+        output_file << "Day " << day + 1 << ": ";
+        for (int i = 0; i < INPUT_SIZE; ++i) {
+            output_file << normalizer.denormalize(i, double(output_data[i])) << " ";
+        }
+        output_file << "\n";
+
+        // Shift input sequence for the next prediction
+        for (int i = 0; i < (seq_length - 1) * INPUT_SIZE; ++i) {
+            input_seq[i] = input_seq[i + INPUT_SIZE];
+        }
+        for (int j = 0; j < INPUT_SIZE; ++j) {
+            input_seq[(seq_length - 1) * INPUT_SIZE + j] = output_data[j];
+        }
+    }
+    output_file.close();
+    std::cout << "Debug: Results written to '" << output_file_name << "'." << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,501 @@
+#ifndef TEXT_INGEST_H
+#define TEXT_INGEST_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#ifndef INGEST_NO_THREADS
+#include <thread>
+#endif
+
+#if __cplusplus >= 201703L && defined(__has_include)
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+#endif
+
+// Header-only so the HLS testbenches and the XRT host can include it by
+// relative path without extra build steps. Floating-point std::from_chars is
+// used when the standard library provides it (GCC 11+); older toolchains, such
+// as the compilers bundled with Vitis, fall back to strtod on the same buffer.
+#if defined(__cpp_lib_to_chars)
+#define INGEST_FROM_CHARS 1
+#else
+#define INGEST_FROM_CHARS 0
+#endif
+
+// Text layouts found in the repo, detected from the first lines of a file
+enum IngestDialect {
+    INGEST_TESTBENCH,   // prediction-days line, Price/Ticker/Date rows, date-prefixed CSV (LSTM_RNN_HW/data.txt)
+    INGEST_BITSTREAM,   // prediction-days line, plain CSV (Bitstream data inputs)
+    INGEST_CSV,         // CSV export without a prediction-days line (SPY_data.csv)
+    INGEST_WHITESPACE   // whitespace-separated values only (RNN_HW/data.txt)
+};
+
+inline const char *ingest_dialect_name(IngestDialect dialect) {
+    switch (dialect) {
+    case INGEST_TESTBENCH: return "testbench";
+    case INGEST_BITSTREAM: return "bitstream";
+    case INGEST_CSV: return "csv";
+    default: return "whitespace";
+    }
+}
+
+// Parsed file. Values are row-major in one contiguous vector.
+template <typename T>
+struct IngestTable {
+    IngestDialect dialect;
+    int prediction_days;                     // 0 when the file has no prediction-days line
+    size_t num_features;
+    std::string ticker;                      // from the "Ticker" row, empty otherwise
+    std::vector<std::string> feature_names;  // header row minus the date column, empty without one
+    std::vector<int64_t> timestamps;         // UTC epoch seconds per row, empty without a date column
+    std::vector<T> values;                   // [rows][num_features]
+
+    IngestTable() : dialect(INGEST_CSV), prediction_days(0), num_features(0) {}
+
+    size_t rows() const { return num_features ? values.size() / num_features : 0; }
+    const T *row(size_t r) const { return &values[r * num_features]; }
+    T *row(size_t r) { return &values[r * num_features]; }
+};
+
+inline bool ingest_is_blank(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+// Parse a number at p, stopping at end. Leading blanks and '+' are skipped.
+// Returns the character after the number, or nullptr when there is none.
+inline const char *ingest_parse_number(const char *p, const char *end, double &value) {
+    while (p < end && ingest_is_blank(*p)) {
+        p++;
+    }
+    if (p < end && *p == '+') {
+        p++;
+    }
+#if INGEST_FROM_CHARS
+    std::from_chars_result result = std::from_chars(p, end, value);
+    return result.ec == std::errc() ? result.ptr : nullptr;
+#else
+    // The ingest buffer is NUL-terminated, so strtod cannot run past it
+    char *stop = nullptr;
+    value = std::strtod(p, &stop);
+    return stop == p || stop > end ? nullptr : stop;
+#endif
+}
+
+// Fixed-width unsigned digits, false on anything else
+inline bool ingest_digits(const char *&p, const char *end, int count, int &value) {
+    value = 0;
+    for (int i = 0; i < count; i++, p++) {
+        if (p >= end || *p < '0' || *p > '9') {
+            return false;
+        }
+        value = value * 10 + (*p - '0');
+    }
+    return true;
+}
+
+// Days since 1970-01-01 for a proleptic Gregorian date
+inline int64_t ingest_days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = (unsigned)(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int64_t)doe - 719468;
+}
+
+// "YYYY-MM-DD[ HH:MM:SS][+HH:MM]" to UTC epoch seconds
+inline bool ingest_parse_timestamp(const char *p, const char *end, int64_t &seconds) {
+    while (p < end && ingest_is_blank(*p)) {
+        p++;
+    }
+    int year, month, day, hour = 0, minute = 0, second = 0;
+    if (!ingest_digits(p, end, 4, year) || p >= end || *p++ != '-' || !ingest_digits(p, end, 2, month) ||
+        p >= end || *p++ != '-' || !ingest_digits(p, end, 2, day) || month < 1 || month > 12 || day < 1 || day > 31) {
+        return false;
+    }
+    if (p < end && (*p == ' ' || *p == 'T')) {
+        const char *q = p + 1;
+        if (ingest_digits(q, end, 2, hour) && q < end && *q++ == ':' && ingest_digits(q, end, 2, minute) &&
+            q < end && *q++ == ':' && ingest_digits(q, end, 2, second)) {
+            p = q;
+        } else {
+            hour = minute = 0;
+        }
+    }
+
+    int64_t offset = 0;
+    if (p < end && (*p == '+' || *p == '-')) {
+        const int sign = *p == '-' ? -1 : 1;
+        const char *q = p + 1;
+        int tz_hour, tz_minute;
+        if (ingest_digits(q, end, 2, tz_hour) && q < end && *q++ == ':' && ingest_digits(q, end, 2, tz_minute)) {
+            offset = sign * (tz_hour * 3600 + tz_minute * 60);
+        }
+    }
+
+    seconds = ingest_days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset;
+    return true;
+}
+
+// Split [begin, end) on sep into strings, only used for the few metadata rows
+inline std::vector<std::string> ingest_split(const char *begin, const char *end, char sep) {
+    std::vector<std::string> fields;
+    while (begin <= end) {
+        const char *stop = std::find(begin, end, sep);
+        const char *last = stop;
+        while (last > begin && ingest_is_blank(last[-1])) {
+            last--;
+        }
+        fields.emplace_back(begin, last);
+        begin = stop + 1;
+    }
+    return fields;
+}
+
+// Parse one data line, handing each number to emit(column, value). Returns the
+// number of values, or 0 when the line is not numeric apart from an optional
+// leading date field or does not hold expected values (0 takes any count). A
+// rejected line may already have emitted values, so sinks only count a row
+// once it is accepted. *date_begin is set when the leading field was present.
+template <typename Emit>
+size_t ingest_parse_fields(const char *p, const char *end, char sep, size_t expected, Emit emit,
+                           const char **date_begin) {
+    size_t count = 0;
+    *date_begin = nullptr;
+
+    for (int column = 0; p < end; column++) {
+        if (sep == ' ') {
+            while (p < end && ingest_is_blank(*p)) {
+                p++;
+            }
+            if (p == end) {
+                break;
+            }
+        }
+        double number;
+        const char *stop = ingest_parse_number(p, end, number);
+        const char *after = stop;
+        if (stop) {
+            while (after < end && ingest_is_blank(*after)) {
+                after++;
+            }
+        }
+        // A number must fill its whole field
+        if (stop && (after == end || (sep == ' ' ? after != stop : *after == sep))) {
+            if (expected && count == expected) {
+                return 0;
+            }
+            emit(count++, number);
+            p = after;
+        } else if (column == 0 && sep != ' ') {
+            *date_begin = p;
+            p = std::find(p, end, sep);
+        } else {
+            return 0;
+        }
+        if (p < end && *p == sep) {
+            p++;
+        }
+    }
+    return expected && count != expected ? 0 : count;
+}
+
+// Blank-trimmed end of the line starting at p
+inline const char *ingest_line_end(const char *p, const char *eol) {
+    while (eol > p && ingest_is_blank(eol[-1])) {
+        eol--;
+    }
+    return eol;
+}
+
+// Everything about a text file except its values: what comes before the first
+// data row (which fixes the separator and num_features), then the row count
+// and the names and dialect worked out once the rows are parsed
+struct IngestLayout {
+    char sep;
+    bool has_days;
+    bool metadata;                           // header, ticker or date rows before the data
+    bool dated;                              // the first data row has a leading timestamp
+    int prediction_days;                     // 0 when the file has no prediction-days line
+    size_t num_features;
+    std::string ticker;                      // from the "Ticker" row, empty otherwise
+    std::vector<std::string> header;         // the header row as written
+    size_t rows;
+    bool stamped;                            // every row has a timestamp
+    std::vector<std::string> feature_names;  // header row minus the date column, empty without one
+    IngestDialect dialect;
+
+    IngestLayout() : sep(','), has_days(false), metadata(false), dated(false), prediction_days(0), num_features(0),
+                     rows(0), stamped(false), dialect(INGEST_CSV) {}
+};
+
+// Read the prediction-days line and the metadata rows. Returns the start of
+// the first data row, or end when there is none.
+inline const char *ingest_scan(const char *p, const char *end, IngestLayout &layout) {
+    // Skip a UTF-8 byte order mark
+    if (end - p >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) {
+        p += 3;
+    }
+
+    // Optional prediction-days line: a lone integer
+    const char *eol = std::find(p, end, '\n');
+    {
+        const char *q = p;
+        int days = 0;
+        bool digits = false;
+        while (q < eol && ingest_is_blank(*q)) {
+            q++;
+        }
+        while (q < eol && *q >= '0' && *q <= '9') {
+            days = days * 10 + (*q++ - '0');
+            digits = true;
+        }
+        while (q < eol && ingest_is_blank(*q)) {
+            q++;
+        }
+        if (digits && q == eol) {
+            layout.prediction_days = days;
+            layout.has_days = true;
+            p = eol < end ? eol + 1 : end;
+        }
+    }
+
+    // Comma-separated unless the first remaining line has no comma
+    eol = std::find(p, end, '\n');
+    layout.sep = std::find(p, eol, ',') != eol ? ',' : ' ';
+
+    // Metadata rows up to the first data row, which fixes num_features
+    while (p < end) {
+        eol = std::find(p, end, '\n');
+        const char *line_end = ingest_line_end(p, eol);
+        const char *date_begin = nullptr;
+        int64_t seconds;
+        if (line_end > p) {
+            layout.num_features = ingest_parse_fields(p, line_end, layout.sep, 0, [](size_t, double) {}, &date_begin);
+        }
+        if (line_end == p) {
+            // Blank line
+        } else if (layout.num_features) {
+            layout.dated = date_begin && ingest_parse_timestamp(date_begin, line_end, seconds);
+            return p;
+        } else {
+            std::vector<std::string> fields = ingest_split(p, line_end, layout.sep);
+            layout.metadata = true;
+            if (fields[0] == "Ticker" && fields.size() > 1) {
+                layout.ticker = fields[1];
+            } else if (layout.header.empty() && fields[0] != "Date") {
+                layout.header = fields;
+            }
+        }
+        p = eol < end ? eol + 1 : end;
+    }
+    return end;
+}
+
+// Data lines [begin, end) whose rows are written from index first on
+struct IngestChunk {
+    const char *begin;
+    const char *end;
+    size_t first;
+    size_t rows;
+    size_t stamped;
+    size_t skipped;
+};
+
+template <typename Sink>
+void ingest_chunk(const IngestLayout &layout, IngestChunk &chunk, Sink &sink) {
+    size_t row = chunk.first;
+    chunk.stamped = chunk.skipped = 0;
+    const char *p = chunk.begin;
+    while (p < chunk.end) {
+        const char *eol = static_cast<const char *>(std::memchr(p, '\n', chunk.end - p));
+        eol = eol ? eol : chunk.end;
+        const char *line_end = ingest_line_end(p, eol);
+        const char *date_begin;
+        int64_t seconds;
+        if (line_end == p) {
+            // Blank line
+        } else if (!ingest_parse_fields(p, line_end, layout.sep, layout.num_features,
+                                        [&](size_t f, double value) { sink.set(row, f, value); }, &date_begin)) {
+            chunk.skipped++;
+        } else {
+            if (layout.dated && date_begin && ingest_parse_timestamp(date_begin, line_end, seconds)) {
+                sink.set_timestamp(row, seconds);
+                chunk.stamped++;
+            }
+            row++;
+        }
+        p = eol + 1;
+    }
+    chunk.rows = row - chunk.first;
+}
+
+// Parse the data rows [p, end) in place into sink, which provides
+//   reserve(layout, rows)        room for at most rows rows of layout.num_features
+//   set(row, feature, value)
+//   set_timestamp(row, seconds)  only called when layout.dated
+//   move_rows(from, to, count)   move rows down to to < from, in order
+// Every line holds at most one row, so each chunk writes from the index of its
+// first line and no rows are parsed into temporary storage; blank or
+// malformed lines leave gaps that are closed afterwards. Sets layout.rows and
+// layout.stamped; the sink keeps its reserved size.
+template <typename Sink>
+void ingest_rows(const char *p, const char *end, const std::string &file_name, IngestLayout &layout, Sink &sink,
+                 int threads) {
+#ifdef INGEST_NO_THREADS
+    threads = 1;
+#else
+    if (threads <= 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+#endif
+    const size_t min_chunk = 1 << 20;
+    const size_t remaining = end - p;
+    threads = std::max(1, std::min(threads, (int)(remaining / min_chunk)));
+
+    // Split large files at line boundaries, one chunk per thread
+    std::vector<IngestChunk> chunks(threads);
+    size_t lines = 0;
+    for (int i = 0; i < threads; i++) {
+        IngestChunk &chunk = chunks[i];
+        chunk.begin = i == 0 ? p : chunks[i - 1].end;
+        chunk.end = end;
+        if (i + 1 < threads) {
+            const char *split = std::max(chunk.begin, p + remaining * (i + 1) / threads);
+            const char *next = static_cast<const char *>(std::memchr(split, '\n', end - split));
+            chunk.end = next ? next + 1 : end;
+        }
+        chunk.first = lines;
+        lines += std::count(chunk.begin, chunk.end, '\n') + 1;
+    }
+    sink.reserve(layout, lines);
+
+    if (threads == 1) {
+        ingest_chunk(layout, chunks[0], sink);
+    }
+#ifndef INGEST_NO_THREADS
+    else {
+        std::vector<std::thread> workers;
+        for (int i = 1; i < threads; i++) {
+            workers.emplace_back([&, i] { ingest_chunk(layout, chunks[i], sink); });
+        }
+        ingest_chunk(layout, chunks[0], sink);
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+#endif
+
+    size_t rows = 0, stamped = 0, skipped = 0;
+    for (const IngestChunk &chunk : chunks) {
+        if (chunk.first != rows && chunk.rows) {
+            sink.move_rows(chunk.first, rows, chunk.rows);
+        }
+        rows += chunk.rows;
+        stamped += chunk.stamped;
+        skipped += chunk.skipped;
+    }
+    if (skipped) {
+        std::cerr << "Warning: Skipped " << skipped << " malformed lines in " << file_name << std::endl;
+    }
+    layout.rows = rows;
+    layout.stamped = layout.dated && stamped == rows;
+}
+
+// Load any text data file from a single buffer into sink (see ingest_rows).
+// Header, ticker and date rows are recognised by content instead of by
+// position, and data rows are parsed straight into the sink with no per-row
+// allocation. With threads > 1 the data lines of large files are split at
+// line boundaries and parsed in parallel; threads <= 0 uses every core.
+// Define INGEST_NO_THREADS to build without std::thread (the HLS testbenches).
+// A file without data rows never calls reserve.
+template <typename Sink>
+bool ingest_text(const std::string &file_name, IngestLayout &layout, Sink &sink, int threads = 1) {
+    std::ifstream file(file_name, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open file " << file_name << std::endl;
+        return false;
+    }
+    const std::streamoff size = file.tellg();
+    std::vector<char> buffer(size + 1, '\0');
+    file.seekg(0);
+    file.read(buffer.data(), size);
+    file.close();
+
+    layout = IngestLayout();
+    const char *end = buffer.data() + size;
+    const char *data = ingest_scan(buffer.data(), end, layout);
+    if (layout.num_features) {
+        ingest_rows(data, end, file_name, layout, sink, threads);
+    }
+
+    const bool labelled = layout.stamped || (!layout.header.empty() && layout.header.size() == layout.num_features + 1);
+    if (!layout.header.empty()) {
+        layout.feature_names.assign(layout.header.begin() + (labelled ? 1 : 0), layout.header.end());
+        if (layout.feature_names.size() != layout.num_features) {
+            layout.feature_names.clear();
+        }
+    }
+
+    if (layout.sep == ' ') {
+        layout.dialect = INGEST_WHITESPACE;
+    } else if (!layout.has_days) {
+        layout.dialect = INGEST_CSV;
+    } else {
+        layout.dialect = layout.metadata || labelled ? INGEST_TESTBENCH : INGEST_BITSTREAM;
+    }
+    return true;
+}
+
+// ingest_rows sink for an IngestTable
+template <typename T>
+struct IngestTableSink {
+    IngestTable<T> &table;
+
+    explicit IngestTableSink(IngestTable<T> &table) : table(table) {}
+
+    void reserve(const IngestLayout &layout, size_t rows) {
+        table.num_features = layout.num_features;
+        table.values.resize(rows * layout.num_features);
+        table.timestamps.resize(layout.dated ? rows : 0);
+    }
+    void set(size_t row, size_t feature, double value) { table.values[row * table.num_features + feature] = T(value); }
+    void set_timestamp(size_t row, int64_t seconds) { table.timestamps[row] = seconds; }
+    void move_rows(size_t from, size_t to, size_t count) {
+        const size_t n = table.num_features;
+        std::copy(table.values.begin() + from * n, table.values.begin() + (from + count) * n,
+                  table.values.begin() + to * n);
+        if (!table.timestamps.empty()) {
+            std::copy(table.timestamps.begin() + from, table.timestamps.begin() + from + count,
+                      table.timestamps.begin() + to);
+        }
+    }
+};
+
+// Load any text data file into a table, see ingest_text above
+template <typename T>
+bool ingest_text(const std::string &file_name, IngestTable<T> &table, int threads = 1) {
+    table = IngestTable<T>();
+    IngestLayout layout;
+    IngestTableSink<T> sink(table);
+    if (!ingest_text(file_name, layout, sink, threads)) {
+        return false;
+    }
+    table.values.resize(layout.rows * layout.num_features);
+    table.timestamps.resize(layout.stamped ? layout.rows : 0);
+    table.dialect = layout.dialect;
+    table.prediction_days = layout.prediction_days;
+    table.num_features = layout.num_features;
+    table.ticker = layout.ticker;
+    table.feature_names = layout.feature_names;
+    return true;
+}
+
+#endif // TEXT_INGEST_H
@@ -0,0 +1,151 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool. Each worker owns a deque: it pops its own work
+// from the front and, when empty, steals from the back of the others. Tasks get
+// the worker index so they can keep per-worker state (model workspaces, caches).
+class ThreadPool {
+public:
+    typedef std::function<void(int)> Task;
+
+    explicit ThreadPool(int threads = 0)
+        : queued_(0), pending_(0), next_(0), stop_(false) {
+        if (threads <= 0) {
+            threads = std::thread::hardware_concurrency();
+        }
+        if (threads <= 0) {
+            threads = 1;
+        }
+        for (int i = 0; i < threads; i++) {
+            queues_.emplace_back(new Queue());
+        }
+        for (int i = 0; i < threads; i++) {
+            workers_.emplace_back(&ThreadPool::worker_loop, this, i);
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int size() const { return (int)workers_.size(); }
+
+    // Queue a task, spread round-robin over the worker deques
+    void submit(Task task) {
+        const int target = next_.fetch_add(1) % size();
+        pending_.fetch_add(1);
+        {
+            std::lock_guard<std::mutex> lock(queues_[target]->mutex);
+            queues_[target]->tasks.push_back(std::move(task));
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queued_++;
+        }
+        wake_.notify_one();
+    }
+
+    // Block until every submitted task has finished
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_.load() == 0; });
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    bool pop_local(int worker, Task &task) {
+        Queue &q = *queues_[worker];
+        std::lock_guard<std::mutex> lock(q.mutex);
+        if (q.tasks.empty()) {
+            return false;
+        }
+        task = std::move(q.tasks.front());
+        q.tasks.pop_front();
+        return true;
+    }
+
+    bool steal(int worker, Task &task) {
+        for (int i = 1; i < size(); i++) {
+            Queue &q = *queues_[(worker + i) % size()];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (!q.tasks.empty()) {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void worker_loop(int worker) {
+        for (;;) {
+            Task task;
+            if (pop_local(worker, task) || steal(worker, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    queued_--;
+                }
+                task(worker);
+                if (pending_.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    done_.notify_all();
+                }
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stop_ || queued_ > 0; });
+            if (stop_ && queued_ == 0) {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    long queued_;                 // tasks sitting in any deque, guarded by mutex_
+    std::atomic<long> pending_;   // tasks submitted but not finished
+    std::atomic<unsigned> next_;
+    bool stop_;
+};
+
+// Split [begin, end) into grain-sized ranges and run fn(worker, lo, hi) on the pool
+template <typename Fn>
+void parallel_for(ThreadPool &pool, long begin, long end, long grain, Fn fn) {
+    if (grain < 1) {
+        grain = 1;
+    }
+    for (long lo = begin; lo < end; lo += grain) {
+        const long hi = lo + grain < end ? lo + grain : end;
+        pool.submit([fn, lo, hi](int worker) { fn(worker, lo, hi); });
+    }
+    pool.wait();
+}
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,230 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Scoped-span tracing for the HLS testbench and the XRT host (any driver can use it).
+// Off unless LSTM_TRACE names an output file. Then each TRACE_SCOPE("stage")
+// records its start and duration into a ring buffer owned by the calling
+// thread, with no lock and no allocation on the hot path. When disabled, a
+// scope costs one relaxed atomic load. At the end of main, the TraceSession
+// writes the spans of every thread as Chrome trace JSON (open it in
+// chrome://tracing or ui.perfetto.dev) and prints a per-stage summary.
+//
+// Span names must be string literals (only the pointer is stored). Each thread
+// keeps the last TRACE_RING_SIZE spans; older ones are counted as dropped.
+
+#define TRACE_RING_SIZE (1 << 16)
+
+struct TraceEvent {
+    const char *name;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+struct TraceBuffer {
+    int tid;
+    uint64_t count;          // spans ever recorded, the ring holds the last TRACE_RING_SIZE
+    std::vector<TraceEvent> ring;
+
+    explicit TraceBuffer(int id) : tid(id), count(0), ring(TRACE_RING_SIZE) {}
+};
+
+inline std::atomic<bool> &trace_enabled_flag() {
+    static std::atomic<bool> enabled(false);
+    return enabled;
+}
+
+inline bool trace_enabled() {
+    return trace_enabled_flag().load(std::memory_order_relaxed);
+}
+
+inline int64_t trace_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Every thread's buffer, kept alive after the thread exits so it can be exported
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+};
+
+inline TraceRegistry &trace_registry() {
+    static TraceRegistry registry;
+    return registry;
+}
+
+inline TraceBuffer &trace_thread_buffer() {
+    thread_local std::shared_ptr<TraceBuffer> buffer;
+    if (!buffer) {
+        TraceRegistry &registry = trace_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        buffer = std::make_shared<TraceBuffer>((int)registry.buffers.size() + 1);
+        registry.buffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Record a span measured elsewhere (e.g. a kernel run from start() to wait())
+inline void trace_span(const char *name, int64_t start_ns, int64_t end_ns) {
+    if (!trace_enabled()) {
+        return;
+    }
+    TraceBuffer &buffer = trace_thread_buffer();
+    TraceEvent &event = buffer.ring[buffer.count % TRACE_RING_SIZE];
+    event.name = name;
+    event.start_ns = start_ns;
+    event.duration_ns = end_ns - start_ns;
+    buffer.count++;
+}
+
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : name_(name), start_ns_(trace_enabled() ? trace_now_ns() : 0) {}
+    ~TraceScope() {
+        if (start_ns_ != 0) {
+            trace_span(name_, start_ns_, trace_now_ns());
+        }
+    }
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    int64_t start_ns_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+// Chrome trace JSON ("X" complete events, microseconds) of every recorded span
+inline bool trace_write_json(const std::string &file_name) {
+    std::ofstream file(file_name);
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open trace file " << file_name << std::endl;
+        return false;
+    }
+    TraceRegistry &registry = trace_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    int64_t origin = INT64_MAX;
+    for (const auto &buffer : registry.buffers) {
+        const uint64_t kept = std::min<uint64_t>(buffer->count, TRACE_RING_SIZE);
+        for (uint64_t i = buffer->count - kept; i < buffer->count; i++) {
+            origin = std::min(origin, buffer->ring[i % TRACE_RING_SIZE].start_ns);
+        }
+    }
+
+    file << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    file << std::fixed << std::setprecision(3);
+    for (const auto &buffer : registry.buffers) {
+        const uint64_t kept = std::min<uint64_t>(buffer->count, TRACE_RING_SIZE);
+        for (uint64_t i = buffer->count - kept; i < buffer->count; i++) {
+            const TraceEvent &event = buffer->ring[i % TRACE_RING_SIZE];
+            file << (first ? "" : ",\n") << "{\"name\": \"" << event.name << "\", \"cat\": \"stage\", \"ph\": \"X\", "
+                 << "\"pid\": 1, \"tid\": " << buffer->tid << ", \"ts\": " << (event.start_ns - origin) / 1e3
+                 << ", \"dur\": " << event.duration_ns / 1e3 << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+// Per-stage count, total, mean and max, with each stage's share of the traced wall time
+inline void trace_print_summary(std::ostream &out) {
+    struct Stage {
+        uint64_t count;
+        int64_t total_ns;
+        int64_t max_ns;
+    };
+    std::map<std::string, Stage> stages;
+    int64_t begin = INT64_MAX, end = INT64_MIN;
+    uint64_t dropped = 0;
+
+    TraceRegistry &registry = trace_registry();
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for (const auto &buffer : registry.buffers) {
+            const uint64_t kept = std::min<uint64_t>(buffer->count, TRACE_RING_SIZE);
+            dropped += buffer->count - kept;
+            for (uint64_t i = buffer->count - kept; i < buffer->count; i++) {
+                const TraceEvent &event = buffer->ring[i % TRACE_RING_SIZE];
+                Stage &stage = stages[event.name];
+                stage.count++;
+                stage.total_ns += event.duration_ns;
+                stage.max_ns = std::max(stage.max_ns, event.duration_ns);
+                begin = std::min(begin, event.start_ns);
+                end = std::max(end, event.start_ns + event.duration_ns);
+            }
+        }
+    }
+    if (stages.empty()) {
+        return;
+    }
+
+    const double wall_ns = double(end - begin);
+    out << "Trace summary (" << std::fixed << std::setprecision(3) << wall_ns / 1e6 << " ms traced";
+    if (dropped > 0) {
+        out << ", " << dropped << " spans dropped";
+    }
+    out << ")\n";
+    out << std::left << std::setw(24) << "stage" << std::right << std::setw(10) << "count" << std::setw(14)
+        << "total ms" << std::setw(14) << "mean us" << std::setw(14) << "max us" << std::setw(10) << "% wall" << "\n";
+    for (const auto &entry : stages) {
+        const Stage &stage = entry.second;
+        out << std::left << std::setw(24) << entry.first << std::right << std::setw(10) << stage.count
+            << std::setw(14) << stage.total_ns / 1e6 << std::setw(14) << stage.total_ns / 1e3 / stage.count
+            << std::setw(14) << stage.max_ns / 1e3 << std::setw(10) << std::setprecision(1)
+            << 100.0 * stage.total_ns / wall_ns << std::setprecision(3) << "\n";
+    }
+    out.unsetf(std::ios::floatfield);
+}
+
+// Turns tracing on when LSTM_TRACE is set; on destruction writes the JSON to
+// that file and the summary to stdout. One per process, at the top of main.
+class TraceSession {
+public:
+    TraceSession() {
+        const char *file_name = std::getenv("LSTM_TRACE");
+        if (file_name && *file_name) {
+            file_name_ = file_name;
+            trace_enabled_flag().store(true);
+        }
+    }
+
+    ~TraceSession() {
+        if (file_name_.empty()) {
+            return;
+        }
+        trace_enabled_flag().store(false);
+        trace_print_summary(std::cout);
+        if (trace_write_json(file_name_)) {
+            std::cout << "Debug: Trace written to '" << file_name_ << "'." << std::endl;
+        }
+    }
+
+    TraceSession(const TraceSession &) = delete;
+    TraceSession &operator=(const TraceSession &) = delete;
+
+private:
+    std::string file_name_;
+};
+
+#endif // TRACE_H
@@ -0,0 +1,192 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "ap_fixed_emu.h"
+#include "data_io.h"
+#include "lstm_train.h"
+#include "lstm_weight_io.h"
+
+#define INPUT_SIZE 5      // Input feature size
+#define SEQ_LENGTH 60     // Default sequence length
+
+// ap_fixed format of the LSTM_RNN_HW kernel, which reads the saved weights.dat
+#define KERNEL_FIXED_WIDTH 64
+#define KERNEL_FIXED_INT 32
+
+// Truncate every weight to the kernel's ap_fixed grid (AP_TRN, as the kernel's
+// own conversion) so the file's values are exact in fixed_type
+template <typename T>
+void quantize_to_kernel(PackedLstmWeights<T> &weights) {
+    T *params = weights.storage.data();
+    for (size_t i = 0; i < weights.storage.size(); i++) {
+        params[i] = T(ap_fixed_emu<KERNEL_FIXED_WIDTH, KERNEL_FIXED_INT>(double(params[i])).to_double());
+    }
+}
+
+// Nightly retraining of the W_*/U_*/b_* parameters: windows of seq_length
+// normalized bars predict the next bar, minibatches run data-parallel on the
+// pool, and the result is written as the split F64 weights.dat the
+// LSTM_RNN_HW testbench, lstm_cpu and the other drivers load.
+int main(int argc, char **argv) {
+    int hidden_size = 16;
+    int seq_length = SEQ_LENGTH;
+    int bptt = 0;
+    int epochs = 30;
+    int batch = 32;
+    int threads = 0;
+    unsigned seed = 1;
+    double learning_rate = 1e-2;
+    double validation = 0.1;
+    bool zero_state = false;
+    std::string data_file;
+    std::string init_file_name, activation_name;
+    std::string weights_file_name = "weights.dat";
+    std::string stats_file_name = NORMALIZER_FILE;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--hidden" && i + 1 < argc) {
+            hidden_size = std::atoi(argv[++i]);
+        } else if (arg == "--seq" && i + 1 < argc) {
+            seq_length = std::atoi(argv[++i]);
+        } else if (arg == "--bptt" && i + 1 < argc) {
+            bptt = std::atoi(argv[++i]);
+        } else if (arg == "--epochs" && i + 1 < argc) {
+            epochs = std::atoi(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            batch = std::atoi(argv[++i]);
+        } else if (arg == "--lr" && i + 1 < argc) {
+            learning_rate = std::atof(argv[++i]);
+        } else if (arg == "--val" && i + 1 < argc) {
+            validation = std::atof(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = (unsigned)std::atol(argv[++i]);
+        } else if (arg == "--init" && i + 1 < argc) {
+            init_file_name = argv[++i];
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else if (arg == "--stats" && i + 1 < argc) {
+            stats_file_name = argv[++i];
+        } else if (arg == "--zero-state") {
+            zero_state = true;
+        } else if (arg == "--out" && i + 1 < argc) {
+            weights_file_name = argv[++i];
+        } else {
+            data_file = arg;
+        }
+    }
+
+    if (data_file.empty() || hidden_size < INPUT_SIZE || seq_length <= 0 || epochs <= 0 || batch <= 0 ||
+        learning_rate <= 0.0 || validation < 0.0 || validation >= 1.0) {
+        std::cerr << "Usage: " << argv[0] << " [--hidden N] [--seq N] [--bptt N] [--epochs N] [--batch N] [--lr X]"
+                  << " [--val Fraction] [--threads N] [--seed N] [--init File] [--act Tier] [--stats File]"
+                  << " [--zero-state] [--out File] <Data File>" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    LstmActivation activation = LSTM_ACT_LIBM;
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    DataTable table;
+    if (!load_table(data_file, table) || table.num_features != INPUT_SIZE) {
+        std::cerr << "Error: Expected " << INPUT_SIZE << "-feature data in " << data_file << std::endl;
+        return EXIT_FAILURE;
+    }
+    const long rows = table.rows();
+    if (rows <= seq_length + 1) {
+        std::cerr << "Error: Need more than " << seq_length + 1 << " rows, got " << rows << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    OnlineNormalizer normalizer(INPUT_SIZE);
+    std::vector<double> normalized_data;
+    normalize_table(table, normalizer, normalized_data);
+    normalizer.save(stats_file_name);
+    const std::vector<float> series(normalized_data.begin(), normalized_data.end());
+
+    // Start from --init (any layout), else the usual initialization
+    LstmModelRuntime<float> model(INPUT_SIZE, hidden_size, seq_length);
+    std::srand(seed);
+    model.initialize_weights_and_biases();
+    if (!init_file_name.empty()) {
+        WeightFile init_file;
+        if (!init_file.open(init_file_name) || !load_lstm_weights(init_file, model)) {
+            return EXIT_FAILURE;
+        }
+        if (!weight_file_activation(init_file.header(), activation)) {
+            return EXIT_FAILURE;
+        }
+        if (!activation_name.empty()) {
+            lstm_parse_activation(activation_name.c_str(), activation);
+        }
+    }
+    PackedLstmWeights<float> weights = pack_lstm_weights(model);
+    weights.activation = activation;
+
+    // Chronological split: the most recent windows are held out
+    const long windows = rows - seq_length;
+    const long held_out = (long)(windows * validation);
+    std::vector<long> train_starts(windows - held_out), val_starts(held_out);
+    for (long i = 0; i < windows; i++) {
+        (i < windows - held_out ? train_starts[i] : val_starts[i - (windows - held_out)]) = i;
+    }
+
+    LstmTrainConfig config;
+    config.seq_length = seq_length;
+    config.bptt = bptt;
+    config.learning_rate = learning_rate;
+    config.carry_state = !zero_state;
+
+    ThreadPool pool(threads);
+    LstmTrainer<float> trainer(weights, config, pool);
+    std::mt19937 rng(seed);
+
+    std::cout << "Debug: Training on " << train_starts.size() << " windows (" << held_out << " held out), "
+              << epochs << " epochs of batch " << batch << " on " << pool.size() << " threads with "
+              << lstm_activation_name(weights.activation) << " activations, "
+              << (zero_state ? "every window from zero state." : "state carried from window to window.")
+              << std::endl;
+    auto start = std::chrono::steady_clock::now();
+
+    // Start states follow the weights once per epoch, before training and again before validation
+    trainer.carry_states(series.data(), windows);
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        std::shuffle(train_starts.begin(), train_starts.end(), rng);
+        double train_loss = 0.0;
+        for (size_t first = 0; first < train_starts.size(); first += batch) {
+            const int count = (int)std::min<size_t>(batch, train_starts.size() - first);
+            train_loss += trainer.step(series.data(), &train_starts[first], count) * count;
+        }
+        train_loss /= train_starts.size();
+        trainer.carry_states(series.data(), windows);
+        const double val_loss = trainer.evaluate(series.data(), val_starts.data(), held_out);
+
+        std::cout << "Debug: Epoch " << epoch << " train MSE " << std::setprecision(6) << train_loss;
+        if (held_out > 0) {
+            std::cout << ", validation MSE " << val_loss;
+        }
+        std::cout << std::endl;
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> elapsed = end - start;
+    std::cout << "Debug: " << trainer.steps() << " steps in " << elapsed.count() << " ms" << std::endl;
+
+    quantize_to_kernel(weights);
+    if (!save_lstm_weights(weights_file_name, weights, WEIGHT_F64, KERNEL_FIXED_WIDTH, KERNEL_FIXED_INT)) {
+        std::cerr << "Error: Could not save weights file!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Debug: Weights written to " << weights_file_name << std::endl;
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <cstdlib>
+#include <string>
+#include "lstm_weight_io.h"
+
+// Rewrites an LSTM weight file in another layout or dtype: --packed stores the
+// PackedLstmWeights block padded for the chosen dtype so lstm_cpu, batch_cpu
+// and backtest_cpu can map it in place; the default split layout is what the
+// HLS testbench reads.
+int main(int argc, char **argv) {
+    WeightDtype dtype = WEIGHT_F64;
+    bool packed_layout = false;
+    std::string input_file, output_file, activation_name;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--f32") {
+            dtype = WEIGHT_F32;
+        } else if (arg == "--f64") {
+            dtype = WEIGHT_F64;
+        } else if (arg == "--packed") {
+            packed_layout = true;
+        } else if (arg == "--split") {
+            packed_layout = false;
+        } else if (arg == "--act" && i + 1 < argc) {
+            activation_name = argv[++i];
+        } else if (input_file.empty()) {
+            input_file = arg;
+        } else {
+            output_file = arg;
+        }
+    }
+
+    if (input_file.empty() || output_file.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <Input Weight File> <Output Weight File> [--split|--packed] [--f32|--f64]"
+                  << " [--act Tier]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    WeightFile input;
+    PackedLstmWeights<double> weights;
+    if (!input.open(input_file) || !load_packed_lstm_weights(input, input.header().input_size, weights)) {
+        return EXIT_FAILURE;
+    }
+    if (!activation_name.empty() && !lstm_parse_activation(activation_name.c_str(), weights.activation)) {
+        std::cerr << "Error: Unknown or unavailable activation tier '" << activation_name << "'." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    bool saved;
+    if (!packed_layout) {
+        saved = save_lstm_weights(output_file, weights, dtype);
+    } else if (dtype == WEIGHT_F32) {
+        saved = save_packed_lstm_weights<float>(output_file, weights);
+    } else {
+        saved = save_packed_lstm_weights<double>(output_file, weights);
+    }
+    if (!saved) {
+        return EXIT_FAILURE;
+    }
+
+    // Read the result back through the mapping as a sanity check
+    WeightFile output;
+    if (!output.open(output_file)) {
+        return EXIT_FAILURE;
+    }
+    const WeightHeader &header = output.header();
+    std::cout << "Debug: Wrote LSTM " << header.input_size << "x" << header.hidden_size << " ("
+              << (header.layout == WEIGHT_LAYOUT_PACKED ? "packed" : "split") << ", "
+              << (header.dtype == WEIGHT_F32 ? "f32" : "f64") << ", "
+              << lstm_activation_name(LstmActivation(header.activation)) << " activations, " << header.num_tensors << " tensors) to '"
+              << output_file << "'." << std::endl;
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,324 @@
+#ifndef WEIGHT_FILE_H
+#define WEIGHT_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Versioned weight container shared by every model in the repo. A 4 KiB
+// header (model type, dimensions, dtype, fixed-point format, gate layout,
+// payload checksum and a tensor directory) is followed by 64-byte aligned
+// row-major tensors, so a read-only mapping can be handed to the CPU engines
+// without copying. Files are written to a temporary name and renamed into
+// place, so concurrent readers never map a half-written file.
+
+#define WEIGHT_MAGIC "WEIGHTS1"
+#define WEIGHT_VERSION 1
+#define WEIGHT_HEADER_SIZE 4096
+#define WEIGHT_ALIGN 64
+#define WEIGHT_MAX_TENSORS 64
+#define WEIGHT_NAME_SIZE 24
+#define WEIGHT_GATE_ORDER "ifco"   // LSTM gate order (input, forget, candidate, output), same as Keras
+
+enum WeightModel {
+    WEIGHT_MODEL_LSTM = 1,
+    WEIGHT_MODEL_RNN = 2,
+    WEIGHT_MODEL_LSTM_STACK = 3    // lstm_stack.h: per-layer "lK.W"/"lK.U"/"lK.b" and "head.W"/"head.b"
+};
+
+enum WeightDtype {
+    WEIGHT_F32 = 1,
+    WEIGHT_F64 = 2
+};
+
+enum WeightLayout {
+    WEIGHT_LAYOUT_SPLIT = 1,    // W_g [hidden][in], U_g [hidden][hidden], b_g [hidden] per gate, as in lstm_rnn.h
+    WEIGHT_LAYOUT_PACKED = 2    // "packed" [4*hidden][x_stride + h_stride] and "bias" [4*hidden], as in lstm_packed.h
+};
+
+struct WeightTensorInfo {
+    char name[WEIGHT_NAME_SIZE];
+    uint32_t rows;
+    uint32_t cols;
+    uint32_t ld;           // elements between rows, >= cols
+    uint32_t reserved;
+    uint64_t offset;       // from the start of the file, WEIGHT_ALIGN aligned
+};
+
+// On-disk header, little-endian
+struct WeightHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t model;          // WeightModel
+    uint32_t dtype;          // WeightDtype of every tensor
+    uint32_t layout;         // WeightLayout
+    uint32_t fixed_width;    // ap_fixed<W, I> the values are exact in, 0 for plain floating point
+    uint32_t fixed_int;
+    uint32_t input_size;
+    uint32_t hidden_size;
+    uint32_t output_size;
+    uint32_t x_stride;       // packed layout only
+    uint32_t h_stride;
+    uint32_t num_tensors;
+    char gate_order[4];
+    uint32_t activation;     // LstmActivation tier the model runs with, 0 (libm) by default
+    uint64_t payload_size;   // bytes after the header
+    uint64_t checksum;       // FNV-1a 64 of the payload
+    WeightTensorInfo tensors[WEIGHT_MAX_TENSORS];
+    uint8_t reserved[WEIGHT_HEADER_SIZE - 80 - WEIGHT_MAX_TENSORS * sizeof(WeightTensorInfo)];
+};
+
+static_assert(sizeof(WeightTensorInfo) == 48, "WeightTensorInfo must stay 48 bytes");
+static_assert(sizeof(WeightHeader) == WEIGHT_HEADER_SIZE, "WeightHeader must stay 4096 bytes");
+
+inline size_t weight_dtype_size(uint32_t dtype) {
+    return dtype == WEIGHT_F32 ? sizeof(float) : sizeof(double);
+}
+
+inline uint64_t weight_checksum(const unsigned char *data, size_t size) {
+    uint64_t hash = 1469598103934665603ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Builds a container in memory and writes it in one go
+class WeightFileWriter {
+public:
+    WeightFileWriter(WeightModel model, WeightDtype dtype, WeightLayout layout, int input_size, int hidden_size,
+                     int output_size) {
+        std::memset(&header_, 0, sizeof(header_));
+        std::memcpy(header_.magic, WEIGHT_MAGIC, sizeof(header_.magic));
+        std::memcpy(header_.gate_order, WEIGHT_GATE_ORDER, sizeof(header_.gate_order));
+        header_.version = WEIGHT_VERSION;
+        header_.model = model;
+        header_.dtype = dtype;
+        header_.layout = layout;
+        header_.input_size = input_size;
+        header_.hidden_size = hidden_size;
+        header_.output_size = output_size;
+    }
+
+    // Record the ap_fixed<width, integer> format the values come from
+    void set_fixed_format(int width, int integer) {
+        header_.fixed_width = width;
+        header_.fixed_int = integer;
+    }
+
+    void set_activation(int activation) {
+        header_.activation = activation;
+    }
+
+    void set_strides(int x_stride, int h_stride) {
+        header_.x_stride = x_stride;
+        header_.h_stride = h_stride;
+    }
+
+    // Append a rows x cols tensor read ld_src elements apart, converted to the
+    // file dtype through double. ld 0 stores the rows densely.
+    template <typename T>
+    bool add(const char *name, const T *data, int rows, int cols, int ld_src = 0, int ld = 0) {
+        if (header_.num_tensors >= WEIGHT_MAX_TENSORS || std::strlen(name) >= WEIGHT_NAME_SIZE) {
+            std::cerr << "Error: Cannot add weight tensor " << name << std::endl;
+            return false;
+        }
+        ld_src = ld_src > 0 ? ld_src : cols;
+        ld = ld > 0 ? ld : cols;
+        const size_t element = weight_dtype_size(header_.dtype);
+        const size_t offset = (payload_.size() + WEIGHT_ALIGN - 1) / WEIGHT_ALIGN * WEIGHT_ALIGN;
+
+        WeightTensorInfo &info = header_.tensors[header_.num_tensors++];
+        std::strncpy(info.name, name, WEIGHT_NAME_SIZE - 1);
+        info.rows = rows;
+        info.cols = cols;
+        info.ld = ld;
+        info.offset = WEIGHT_HEADER_SIZE + offset;
+
+        payload_.resize(offset + (size_t)rows * ld * element, 0);
+        unsigned char *dst = payload_.data() + offset;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                const double value = double(data[(size_t)r * ld_src + c]);
+                unsigned char *slot = dst + ((size_t)r * ld + c) * element;
+                if (header_.dtype == WEIGHT_F32) {
+                    const float f = (float)value;
+                    std::memcpy(slot, &f, sizeof(f));
+                } else {
+                    std::memcpy(slot, &value, sizeof(value));
+                }
+            }
+        }
+        return true;
+    }
+
+    bool save(const std::string &file_name) {
+        payload_.resize((payload_.size() + WEIGHT_ALIGN - 1) / WEIGHT_ALIGN * WEIGHT_ALIGN, 0);
+        header_.payload_size = payload_.size();
+        header_.checksum = weight_checksum(payload_.data(), payload_.size());
+
+        const std::string temp_name = file_name + ".tmp";
+        std::ofstream file(temp_name, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            std::cerr << "Error: Could not open " << temp_name << " for writing." << std::endl;
+            return false;
+        }
+        file.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+        file.write(reinterpret_cast<const char *>(payload_.data()), payload_.size());
+        file.close();
+        if (!file.good() || std::rename(temp_name.c_str(), file_name.c_str()) != 0) {
+            std::cerr << "Error: Failed writing " << file_name << std::endl;
+            std::remove(temp_name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    WeightHeader header_;
+    std::vector<unsigned char> payload_;
+};
+
+// Read-only memory mapping of a weight container
+class WeightFile {
+public:
+    WeightFile() : base_(nullptr), length_(0), header_(nullptr) {}
+    ~WeightFile() { close(); }
+    WeightFile(const WeightFile &) = delete;
+    WeightFile &operator=(const WeightFile &) = delete;
+
+    // Map and validate the file (header, tensor bounds and checksum), false
+    // with a message on stderr on any problem
+    bool open(const std::string &file_name) {
+        close();
+        int fd = ::open(file_name.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: Could not open " << file_name << std::endl;
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(WeightHeader)) {
+            std::cerr << "Error: " << file_name << " is too small for a weight header." << std::endl;
+            ::close(fd);
+            return false;
+        }
+        void *base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            std::cerr << "Error: Could not map " << file_name << std::endl;
+            return false;
+        }
+        base_ = base;
+        length_ = st.st_size;
+
+        const WeightHeader *header = static_cast<const WeightHeader *>(base_);
+        const unsigned char *bytes = static_cast<const unsigned char *>(base_);
+        const char *problem = nullptr;
+        if (std::memcmp(header->magic, WEIGHT_MAGIC, sizeof(header->magic)) != 0) {
+            problem = "bad magic, old raw weights.dat files need regenerating";
+        } else if (header->version != WEIGHT_VERSION) {
+            problem = "unsupported version";
+        } else if (header->dtype != WEIGHT_F32 && header->dtype != WEIGHT_F64) {
+            problem = "unknown dtype";
+        } else if (header->num_tensors > WEIGHT_MAX_TENSORS) {
+            problem = "bad tensor count";
+        } else if (sizeof(WeightHeader) + header->payload_size != length_) {
+            problem = "truncated";
+        } else if (weight_checksum(bytes + sizeof(WeightHeader), header->payload_size) != header->checksum) {
+            problem = "checksum mismatch";
+        } else {
+            for (uint32_t i = 0; i < header->num_tensors && !problem; i++) {
+                // rows * ld elements must fit after offset; divided, so large sizes cannot wrap
+                const WeightTensorInfo &t = header->tensors[i];
+                if (t.offset % WEIGHT_ALIGN != 0 || t.offset < sizeof(WeightHeader) || t.ld < t.cols ||
+                    t.offset > length_ ||
+                    (uint64_t)t.rows * t.ld > (length_ - t.offset) / weight_dtype_size(header->dtype)) {
+                    problem = "tensor out of range";
+                }
+            }
+        }
+        if (problem) {
+            std::cerr << "Error: " << file_name << " is not a valid weight file (" << problem << ")." << std::endl;
+            close();
+            return false;
+        }
+        header_ = header;
+        return true;
+    }
+
+    void close() {
+        if (base_) {
+            munmap(base_, length_);
+        }
+        base_ = nullptr;
+        length_ = 0;
+        header_ = nullptr;
+    }
+
+    bool is_open() const { return header_ != nullptr; }
+    const WeightHeader &header() const { return *header_; }
+
+    const WeightTensorInfo *find(const char *name) const {
+        for (uint32_t i = 0; i < header_->num_tensors; i++) {
+            if (std::strncmp(header_->tensors[i].name, name, WEIGHT_NAME_SIZE) == 0) {
+                return &header_->tensors[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Zero-copy view of a tensor, nullptr when it is missing, has another
+    // shape or is stored in another dtype
+    template <typename T>
+    const T *tensor(const char *name, int rows, int cols) const {
+        const WeightTensorInfo *t = find(name);
+        if (!t || (int)t->rows != rows || (int)t->cols != cols || weight_dtype_size(header_->dtype) != sizeof(T) ||
+            (header_->dtype == WEIGHT_F32) != (sizeof(T) == sizeof(float))) {
+            return nullptr;
+        }
+        return reinterpret_cast<const T *>(static_cast<const char *>(base_) + t->offset);
+    }
+
+    // Copy a tensor into dense rows x cols storage, converting through double
+    // (works for float, double and ap_fixed alike)
+    template <typename T>
+    bool copy(const char *name, T *out, int rows, int cols) const {
+        const WeightTensorInfo *t = find(name);
+        if (!t || (int)t->rows != rows || (int)t->cols != cols) {
+            std::cerr << "Error: Weight tensor " << name << " missing or not " << rows << "x" << cols << std::endl;
+            return false;
+        }
+        const char *base = static_cast<const char *>(base_) + t->offset;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                const size_t index = (size_t)r * t->ld + c;
+                double value;
+                if (header_->dtype == WEIGHT_F32) {
+                    float f;
+                    std::memcpy(&f, base + index * sizeof(float), sizeof(f));
+                    value = f;
+                } else {
+                    std::memcpy(&value, base + index * sizeof(double), sizeof(value));
+                }
+                out[(size_t)r * cols + c] = T(value);
+            }
+        }
+        return true;
+    }
+
+private:
+    void *base_;
+    size_t length_;
+    const WeightHeader *header_;
+};
+
+#endif // WEIGHT_FILE_H
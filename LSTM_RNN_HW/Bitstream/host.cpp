@@ -5,104 +5,196 @@
 #include <fstream>
 #include <vector>
 #include <string>
-#include <sstream>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include "../../LSTM_RNN_CPU/text_ingest.h"
+#include "../../LSTM_RNN_CPU/online_normalizer.h"
+#include "../../LSTM_RNN_CPU/trace.h"
+
+#define INPUT_SIZE 5      // Input feature size, same as lstm_rnn.h
+#define SEQ_LENGTH 60     // Window the kernel reads, same as lstm_rnn.h
 
 // Utility function to read data file
-std::vector<std::vector<float>> read_data_file(const std::string &file_path, int &prediction_days) {
+IngestTable<float> read_data_file(const std::string &file_path, int &prediction_days) {
     std::cout << "Debug: Reading text data file: " << file_path << std::endl;
-    std::ifstream file(file_path);
-    if (!file.is_open()) {
-        std::cerr << "Error: Unable to open data file " << file_path << std::endl;
+    TRACE_SCOPE("parse");
+    IngestTable<float> data;
+    if (!ingest_text(file_path, data, 0)) {
         exit(EXIT_FAILURE);
     }
+    prediction_days = data.prediction_days;
+    std::cout << "Debug: Prediction days: " << prediction_days << std::endl;
+    std::cout << "Debug: Data file read successfully (" << ingest_dialect_name(data.dialect) << "). Rows: "
+              << data.rows() << std::endl;
+    return data;
+}
 
-    std::vector<std::vector<float>> data;
-    std::string line;
+// One independent series: its normalized rolling window and predictions. Days
+// of a series depend on each other, different series do not.
+struct Stream {
+    std::string output_file_name;
+    OnlineNormalizer normalizer;
+    std::vector<float> window;     // [SEQ_LENGTH][INPUT_SIZE]
+    int prediction_days;
+    std::vector<float> predictions;
 
-    // Read the number of predictions (first line)
-    if (std::getline(file, line)) {
-        prediction_days = std::stoi(line);
-        std::cout << "Debug: Prediction days: " << prediction_days << std::endl;
-    }
+    Stream() : normalizer(INPUT_SIZE), window(SEQ_LENGTH * INPUT_SIZE, 0.0f), prediction_days(0) {}
 
-    // Process the remaining lines (numeric data)
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::vector<float> row;
-        std::string value;
+    bool done() const { return (int)(predictions.size() / INPUT_SIZE) >= prediction_days; }
 
-        while (std::getline(iss, value, ',')) {
-            row.push_back(std::stof(value));
-        }
+    // Record a prediction and roll it into the window for the next day
+    void advance(const float *prediction) {
+        predictions.insert(predictions.end(), prediction, prediction + INPUT_SIZE);
+        std::copy(window.begin() + INPUT_SIZE, window.end(), window.begin());
+        std::copy(prediction, prediction + INPUT_SIZE, window.end() - INPUT_SIZE);
+    }
+};
+
+// Input/output buffers on one compute unit with a run object that is built
+// once, bound to them, and restarted for every command
+struct Slot {
+    xrt::bo input_bo;
+    xrt::bo output_bo;
+    xrt::run run;
+    int stream;
+    int64_t start_ns;      // when the current command was started, for the trace
+
+    Slot(xrt::device &device, xrt::kernel &kernel)
+        : input_bo(device, SEQ_LENGTH * INPUT_SIZE * sizeof(float), kernel.group_id(0)),
+          output_bo(device, INPUT_SIZE * sizeof(float), kernel.group_id(1)), run(kernel), stream(-1), start_ns(0) {
+        run.set_arg(0, input_bo);
+        run.set_arg(1, output_bo);
+    }
+};
+
+// Keep every slot busy: while a compute unit runs one slot's command, the host
+// syncs the next window into another slot of the same unit (ping-pong at depth
+// 2), and completions are drained oldest first. Independent streams spread
+// over the compute units; each stream has at most one command in flight.
+void run_streams(xrt::device &device, const xrt::uuid &xclbin_uuid, int compute_units, int depth,
+                 std::vector<Stream> &streams) {
+    std::vector<xrt::kernel> kernels;
+    for (int cu = 1; cu <= compute_units; cu++) {
+        const std::string name = compute_units == 1
+            ? std::string("lstm_sequence")
+            : "lstm_sequence:{lstm_sequence_" + std::to_string(cu) + "}";
+        kernels.emplace_back(device, xclbin_uuid, name);
+    }
 
-        if (!row.empty()) {
-            data.push_back(row);
+    // Slots interleaved by compute unit, so consecutive starts land on different units
+    std::vector<std::unique_ptr<Slot>> slots;
+    for (int d = 0; d < depth; d++) {
+        for (int cu = 0; cu < compute_units; cu++) {
+            slots.emplace_back(new Slot(device, kernels[cu]));
         }
     }
+    std::cout << "Debug: " << slots.size() << " slots on " << compute_units << " compute units." << std::endl;
 
-    file.close();
-    std::cout << "Debug: Data file read successfully. Rows: " << data.size() << std::endl;
-    return data;
-}
-
-// Utility function to normalize data
-void normalize_data(std::vector<std::vector<float>> &data, std::vector<float> &means, std::vector<float> &std_devs) {
-    size_t num_features = data[0].size();
-    size_t num_samples = data.size();
-
-    means.assign(num_features, 0.0f);
-    std_devs.assign(num_features, 0.0f);
-
-    // Calculate means
-    for (const auto &row : data) {
-        for (size_t i = 0; i < num_features; ++i) {
-            means[i] += row[i];
+    std::deque<int> ready, free_slots;
+    for (size_t s = 0; s < streams.size(); s++) {
+        if (!streams[s].done()) {
+            ready.push_back((int)s);
         }
     }
-    for (size_t i = 0; i < num_features; ++i) {
-        means[i] /= num_samples;
+    for (size_t i = 0; i < slots.size(); i++) {
+        free_slots.push_back((int)i);
     }
 
-    // Calculate standard deviations
-    for (const auto &row : data) {
-        for (size_t i = 0; i < num_features; ++i) {
-            std_devs[i] += (row[i] - means[i]) * (row[i] - means[i]);
+    std::deque<int> in_flight;
+    float prediction[INPUT_SIZE];
+    while (!ready.empty() || !in_flight.empty()) {
+        while (!ready.empty() && !free_slots.empty()) {
+            Slot &slot = *slots[free_slots.front()];
+            slot.stream = ready.front();
+            {
+                TRACE_SCOPE("buffer_write_sync");
+                slot.input_bo.write(streams[slot.stream].window.data());
+                slot.input_bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+            }
+            slot.start_ns = trace_enabled() ? trace_now_ns() : 0;
+            slot.run.start();
+            in_flight.push_back(free_slots.front());
+            free_slots.pop_front();
+            ready.pop_front();
         }
-    }
-    for (size_t i = 0; i < num_features; ++i) {
-        std_devs[i] = std::sqrt(std_devs[i] / num_samples);
-    }
 
-    // Normalize data
-    for (auto &row : data) {
-        for (size_t i = 0; i < num_features; ++i) {
-            row[i] = (row[i] - means[i]) / std_devs[i];
+        const int oldest = in_flight.front();
+        in_flight.pop_front();
+        Slot &slot = *slots[oldest];
+        {
+            TRACE_SCOPE("kernel_wait");
+            if (slot.run.wait() != ERT_CMD_STATE_COMPLETED) {
+                std::cerr << "Error: Kernel run failed." << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+        // Start to completion as the host sees it, including time queued on the unit
+        if (slot.start_ns != 0) {
+            trace_span("kernel_run", slot.start_ns, trace_now_ns());
+        }
+        {
+            TRACE_SCOPE("read_back");
+            slot.output_bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+            slot.output_bo.read(prediction);
         }
-    }
 
-    std::cout << "Debug: Data normalization complete." << std::endl;
+        Stream &stream = streams[slot.stream];
+        stream.advance(prediction);
+        if (!stream.done()) {
+            ready.push_back(slot.stream);
+        }
+        slot.stream = -1;
+        free_slots.push_back(oldest);
+    }
 }
 
 int main(int argc, char **argv) {
-    if (argc < 3) {
-        std::cerr << "Usage: " << argv[0] << " <XCLBIN File> <Data File>" << std::endl;
-        return EXIT_FAILURE;
+    TraceSession trace_session;
+    int compute_units = 1;
+    int depth = 2;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--cus" && i + 1 < argc) {
+            compute_units = std::atoi(argv[++i]);
+        } else if (arg == "--depth" && i + 1 < argc) {
+            depth = std::atoi(argv[++i]);
+        } else {
+            files.push_back(arg);
+        }
     }
 
-    const std::string xclbin_file = argv[1];
-    const std::string data_file = argv[2];
-
-    // Read and normalize data
-    int prediction_days = 0;
-    auto raw_data = read_data_file(data_file, prediction_days);
-    if (raw_data.empty()) {
-        std::cerr << "Error: Data file is empty or invalid." << std::endl;
+    if (files.size() < 2 || compute_units < 1 || depth < 1) {
+        std::cerr << "Usage: " << argv[0] << " [--cus N] [--depth N] <XCLBIN File> <Data File> [Data File...]"
+                  << std::endl;
         return EXIT_FAILURE;
     }
+    const std::string xclbin_file = files[0];
+
+    // Read and normalize every series; one file writes output.dat, several
+    // write output_1.dat, output_2.dat, ... in argument order
+    std::vector<Stream> streams(files.size() - 1);
+    for (size_t s = 0; s < streams.size(); s++) {
+        int prediction_days = 0;
+        auto raw_data = read_data_file(files[s + 1], prediction_days);
+        if (raw_data.rows() == 0 || raw_data.num_features != INPUT_SIZE) {
+            std::cerr << "Error: Data file is empty or invalid." << std::endl;
+            return EXIT_FAILURE;
+        }
 
-    std::vector<float> means, std_devs;
-    normalize_data(raw_data, means, std_devs);
+        TRACE_SCOPE("normalize");
+        Stream &stream = streams[s];
+        stream.normalizer.push_rows(raw_data.values.data(), raw_data.rows());
+        for (int i = 0; i < SEQ_LENGTH && i < (int)raw_data.rows(); ++i) {
+            stream.normalizer.normalize(raw_data.row(i), &stream.window[i * INPUT_SIZE]);
+        }
+        stream.prediction_days = prediction_days;
+        stream.output_file_name = streams.size() == 1 ? "output.dat" : "output_" + std::to_string(s + 1) + ".dat";
+    }
+    std::cout << "Debug: Data normalization complete." << std::endl;
 
     // Initialize device and load XCLBIN
     std::cout << "Debug: Initializing device and loading XCLBIN..." << std::endl;
@@ -110,55 +202,33 @@ int main(int argc, char **argv) {
     auto xclbin_uuid = device.load_xclbin(xclbin_file);
     std::cout << "Debug: XCLBIN loaded successfully." << std::endl;
 
-    // Create kernel
-    auto kernel = xrt::kernel(device, xclbin_uuid, "lstm_sequence");
-    std::cout << "Debug: Kernel 'lstm_sequence' created successfully." << std::endl;
-
-    // Allocate buffers
-    size_t input_size = raw_data.size() * raw_data[0].size() * sizeof(float);
-    size_t output_size = raw_data[0].size() * sizeof(float);
-
-    auto input_bo = xrt::bo(device, input_size, kernel.group_id(0));
-    auto output_bo = xrt::bo(device, output_size, kernel.group_id(1));
-    std::cout << "Debug: Input and output buffers allocated." << std::endl;
-
-    // Write initial data to input buffer
-    input_bo.write(raw_data.data());
-    input_bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
-    std::cout << "Debug: Input data transferred to device." << std::endl;
-
-    std::ofstream output_file("output.dat");
-    std::vector<float> predictions(raw_data[0].size());
-
-    // Run kernel for each prediction day
-    for (int day = 0; day < prediction_days; ++day) {
-        auto run = xrt::run(kernel);
-        run.set_arg(0, input_bo);
-        run.set_arg(1, output_bo);
-        run.start();
-        run.wait();
-        std::cout << "Debug: Kernel execution for day " << day + 1 << " complete." << std::endl;
-
-        // Read and save predictions
-        output_bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
-        output_bo.read(predictions.data());
-
-        // Denormalize and write to output
-        for (size_t i = 0; i < predictions.size(); ++i) {
-            float denormalized = predictions[i] * std_devs[i] + means[i];
-            output_file << denormalized << " ";
+    auto start = std::chrono::steady_clock::now();
+    run_streams(device, xclbin_uuid, compute_units, depth, streams);
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    long days = 0;
+    for (const Stream &stream : streams) {
+        std::vector<double> denormalized(stream.predictions.size());
+        {
+            TRACE_SCOPE("denormalize");
+            for (size_t k = 0; k < denormalized.size(); ++k) {
+                denormalized[k] = stream.normalizer.denormalize(k % INPUT_SIZE, stream.predictions[k]);
+            }
         }
-        output_file << std::endl;
 
-        // Update input sequence with latest predictions
-        std::vector<float> new_input(predictions);
-        input_bo.write(new_input.data());
-        input_bo.sync(XCL_BO_SYNC_BO_TO_DEVICE);
+        TRACE_SCOPE("output_file");
+        std::ofstream output_file(stream.output_file_name);
+        for (size_t day = 0; day < denormalized.size() / INPUT_SIZE; ++day) {
+            for (int i = 0; i < INPUT_SIZE; ++i) {
+                output_file << denormalized[day * INPUT_SIZE + i] << " ";
+            }
+            output_file << std::endl;
+        }
+        days += stream.prediction_days;
+        std::cout << "Debug: Results written to '" << stream.output_file_name << "'." << std::endl;
     }
-
-    output_file.close();
-    std::cout << "Debug: Results written to 'output.dat'." << std::endl;
+    std::cout << "Debug: " << days << " kernel runs for " << streams.size() << " series in " << elapsed.count()
+              << " ms." << std::endl;
 
     return EXIT_SUCCESS;
 }
-
@@ -0,0 +1,80 @@
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include "xrt_emu/xrt_emu.h"
+#include "../lstm_rnn.h"
+#include "../../LSTM_RNN_CPU/weight_file.h"
+#include "../../LSTM_RNN_CPU/trace.h"
+#ifdef LSTM_PROBE
+#include "../../LSTM_RNN_CPU/gate_probe.h"
+#endif
+
+// lstm_sequence compute unit for the XRT stand-in: the HLS source itself,
+// built with -DAP_FIXED_EMU, so the emulated card runs the kernel's
+// ap_fixed<64, 32> arithmetic (hls::exp/tanh approximated, see
+// ap_fixed_emu.h). Arguments follow host.cpp: a float window
+// [SEQ_LENGTH][INPUT_SIZE] and a float prediction [INPUT_SIZE]; every run
+// starts from zero state.
+
+extern fixed_type W_i[HIDDEN_SIZE][INPUT_SIZE], U_i[HIDDEN_SIZE][HIDDEN_SIZE], b_i[HIDDEN_SIZE];
+extern fixed_type W_f[HIDDEN_SIZE][INPUT_SIZE], U_f[HIDDEN_SIZE][HIDDEN_SIZE], b_f[HIDDEN_SIZE];
+extern fixed_type W_c[HIDDEN_SIZE][INPUT_SIZE], U_c[HIDDEN_SIZE][HIDDEN_SIZE], b_c[HIDDEN_SIZE];
+extern fixed_type W_o[HIDDEN_SIZE][INPUT_SIZE], U_o[HIDDEN_SIZE][HIDDEN_SIZE], b_o[HIDDEN_SIZE];
+
+static fixed_type *const gate_W[4] = {&W_i[0][0], &W_f[0][0], &W_c[0][0], &W_o[0][0]};
+static fixed_type *const gate_U[4] = {&U_i[0][0], &U_f[0][0], &U_c[0][0], &U_o[0][0]};
+static fixed_type *const gate_b[4] = {b_i, b_f, b_c, b_o};
+
+// The weights baked into the bitstream: weights.dat (or $XRT_EMU_WEIGHTS) as
+// the testbench wrote it, else the testbench's initialization
+static void load_kernel_weights() {
+    const char *env = std::getenv("XRT_EMU_WEIGHTS");
+    const std::string file_name = env ? env : "weights.dat";
+    WeightFile weight_file;
+    bool loaded = std::ifstream(file_name).good() && weight_file.open(file_name);
+    if (loaded) {
+        const WeightHeader &header = weight_file.header();
+        loaded = header.model == WEIGHT_MODEL_LSTM && header.input_size == INPUT_SIZE &&
+                 header.hidden_size == HIDDEN_SIZE;
+        for (int g = 0; g < 4 && loaded; g++) {
+            const std::string gate(1, WEIGHT_GATE_ORDER[g]);
+            loaded = weight_file.copy(("W_" + gate).c_str(), gate_W[g], HIDDEN_SIZE, INPUT_SIZE) &&
+                     weight_file.copy(("U_" + gate).c_str(), gate_U[g], HIDDEN_SIZE, HIDDEN_SIZE) &&
+                     weight_file.copy(("b_" + gate).c_str(), gate_b[g], 1, HIDDEN_SIZE);
+        }
+    }
+    if (!loaded) {
+        std::cout << "Debug: Emulated kernel has no " << file_name << ", using initialized weights." << std::endl;
+        initialize_weights_and_biases();
+    }
+}
+
+static void lstm_sequence_emu(const xrt_emu::KernelArgs &args) {
+    static std::once_flag weights_loaded;
+    std::call_once(weights_loaded, load_kernel_weights);
+    TRACE_SCOPE("cu_compute");
+
+    const float *window = args.buffer<float>(0);
+    float *prediction = args.buffer<float>(1);
+
+    fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE];
+    for (int t = 0; t < SEQ_LENGTH; t++) {
+        for (int j = 0; j < INPUT_SIZE; j++) {
+            x_seq[t][j] = window[t * INPUT_SIZE + j];
+        }
+    }
+    fixed_type h[HIDDEN_SIZE] = {0}, c[HIDDEN_SIZE] = {0}, output_data[INPUT_SIZE];
+    fixed_type i_gate[HIDDEN_SIZE], f_gate[HIDDEN_SIZE], o_gate[HIDDEN_SIZE], g_gate[HIDDEN_SIZE];
+    lstm_sequence(x_seq, h, c, output_data, i_gate, f_gate, o_gate, g_gate);
+    for (int j = 0; j < INPUT_SIZE; j++) {
+        prediction[j] = output_data[j].to_float();
+    }
+}
+
+static xrt_emu::KernelRegistrar lstm_sequence_registrar("lstm_sequence", lstm_sequence_emu);
+
+#ifdef LSTM_PROBE
+// make emu EMU_DEFINES=-DLSTM_PROBE: every compute unit's timesteps, written at exit
+static GateProbeSession probe_session;
+#endif
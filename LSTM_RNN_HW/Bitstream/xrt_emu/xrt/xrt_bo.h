@@ -0,0 +1,2 @@
+// xrt::bo from the CPU stand-in, see ../xrt_emu.h
+#include "../xrt_emu.h"
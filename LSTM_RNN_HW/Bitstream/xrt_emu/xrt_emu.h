@@ -0,0 +1,478 @@
+#ifndef XRT_EMU_H
+#define XRT_EMU_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// CPU stand-in for the subset of the XRT native API the Bitstream hosts use
+// (xrt::device, xrt::kernel, xrt::bo, xrt::run). Put this directory first on
+// the include path and <xrt/xrt_*.h> resolve here instead of $XILINX_XRT.
+//
+// load_xclbin() does not read the xclbin. It gives every kernel registered with
+// xrt_emu::register_kernel() XRT_EMU_CUS compute units, named "<kernel>_1" and
+// so on as v++ names them. Each compute unit is a thread that runs its queued
+// commands in order. Buffers keep a host copy and a device copy, and only
+// sync() moves data between them, so a host that skips a sync sees stale data
+// just as it would on the card.
+//
+// Latency model, from XRT_EMU_LATENCY ("launch=US,sync=US,gbps=X,compute=US",
+// any subset, defaults below):
+//   launch   per-command dispatch overhead on the compute unit
+//   sync     fixed cost of every bo.sync(), plus bytes / gbps
+//   compute  lower bound on kernel time; the CPU run is padded up to it
+// All delays are sleeps, so transfers on the host thread overlap kernels on
+// compute unit threads the way DMA overlaps the card.
+
+enum xclBOSyncDirection {
+    XCL_BO_SYNC_BO_TO_DEVICE = 0,
+    XCL_BO_SYNC_BO_FROM_DEVICE = 1
+};
+
+enum ert_cmd_state {
+    ERT_CMD_STATE_NEW = 1,
+    ERT_CMD_STATE_QUEUED = 2,
+    ERT_CMD_STATE_RUNNING = 3,
+    ERT_CMD_STATE_COMPLETED = 4,
+    ERT_CMD_STATE_ERROR = 5,
+    ERT_CMD_STATE_ABORT = 6,
+    ERT_CMD_STATE_SUBMITTED = 7,
+    ERT_CMD_STATE_TIMEOUT = 8
+};
+
+namespace xrt_emu {
+
+struct LatencyModel {
+    double launch_us;
+    double sync_us;
+    double gbps;
+    double compute_us;
+
+    LatencyModel() : launch_us(20.0), sync_us(10.0), gbps(12.0), compute_us(0.0) {}
+
+    static LatencyModel from_env() {
+        LatencyModel model;
+        const char *text = std::getenv("XRT_EMU_LATENCY");
+        std::string spec = text ? text : "";
+        size_t pos = 0;
+        while (pos < spec.size()) {
+            size_t end = spec.find(',', pos);
+            end = end == std::string::npos ? spec.size() : end;
+            const std::string item = spec.substr(pos, end - pos);
+            const size_t eq = item.find('=');
+            if (eq != std::string::npos) {
+                const std::string key = item.substr(0, eq);
+                const double value = std::atof(item.c_str() + eq + 1);
+                if (key == "launch") {
+                    model.launch_us = value;
+                } else if (key == "sync") {
+                    model.sync_us = value;
+                } else if (key == "gbps" && value > 0.0) {
+                    model.gbps = value;
+                } else if (key == "compute") {
+                    model.compute_us = value;
+                }
+            }
+            pos = end + 1;
+        }
+        return model;
+    }
+
+    double transfer_us(size_t bytes) const { return sync_us + bytes / (gbps * 1e3); }
+};
+
+inline void delay_us(double us) {
+    if (us > 0.0) {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::micro>(us));
+    }
+}
+
+// Kernel arguments as the compute unit sees them: device memory of buffer
+// arguments, raw bits of scalar ones
+class KernelArgs {
+public:
+    template <typename T>
+    T *buffer(int index) const { return static_cast<T *>(slot(index).ptr); }
+
+    template <typename T>
+    T scalar(int index) const {
+        T value;
+        std::memcpy(&value, &slot(index).bits, sizeof(T));
+        return value;
+    }
+
+    struct Slot {
+        void *ptr;
+        uint64_t bits;
+        Slot() : ptr(nullptr), bits(0) {}
+    };
+
+    void set_buffer(int index, void *ptr) { grow(index).ptr = ptr; }
+    void set_bits(int index, uint64_t bits) { grow(index).bits = bits; }
+
+private:
+    const Slot &slot(int index) const {
+        if (index < 0 || index >= (int)slots_.size()) {
+            throw std::out_of_range("xrt_emu: kernel argument not set");
+        }
+        return slots_[index];
+    }
+    Slot &grow(int index) {
+        if (index >= (int)slots_.size()) {
+            slots_.resize(index + 1);
+        }
+        return slots_[index];
+    }
+
+    std::vector<Slot> slots_;
+};
+
+typedef std::function<void(const KernelArgs &)> KernelFn;
+
+inline std::map<std::string, KernelFn> &kernel_registry() {
+    static std::map<std::string, KernelFn> registry;
+    return registry;
+}
+
+// Make a CPU function available as kernel `name` in every loaded xclbin
+inline void register_kernel(const std::string &name, KernelFn fn) {
+    kernel_registry()[name] = fn;
+}
+
+struct KernelRegistrar {
+    KernelRegistrar(const std::string &name, KernelFn fn) { register_kernel(name, fn); }
+};
+
+// Completion state of one xrt::run
+struct Command {
+    std::mutex mutex;
+    std::condition_variable done;
+    ert_cmd_state state;
+    KernelArgs args;
+    Command() : state(ERT_CMD_STATE_NEW) {}
+
+    void finish(ert_cmd_state result) {
+        std::lock_guard<std::mutex> lock(mutex);
+        state = result;
+        done.notify_all();
+    }
+};
+
+// One compute unit: a thread draining its command queue in order
+class ComputeUnit {
+public:
+    ComputeUnit(const std::string &name, KernelFn fn, const LatencyModel &latency)
+        : name_(name), fn_(fn), latency_(latency), stop_(false), thread_(&ComputeUnit::loop, this) {}
+
+    ~ComputeUnit() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+    }
+
+    const std::string &name() const { return name_; }
+
+    size_t queued() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    void submit(const std::shared_ptr<Command> &command) {
+        {
+            std::lock_guard<std::mutex> lock(command->mutex);
+            command->state = ERT_CMD_STATE_QUEUED;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(command);
+        }
+        wake_.notify_all();
+    }
+
+private:
+    void loop() {
+        for (;;) {
+            std::shared_ptr<Command> command;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                wake_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                command = queue_.front();
+            }
+            {
+                std::lock_guard<std::mutex> lock(command->mutex);
+                command->state = ERT_CMD_STATE_RUNNING;
+            }
+
+            delay_us(latency_.launch_us);
+            auto start = std::chrono::steady_clock::now();
+            ert_cmd_state result = ERT_CMD_STATE_COMPLETED;
+            try {
+                fn_(command->args);
+            } catch (const std::exception &) {
+                result = ERT_CMD_STATE_ERROR;
+            }
+            std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            delay_us(latency_.compute_us - elapsed.count());
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                queue_.pop_front();
+            }
+            command->finish(result);
+        }
+    }
+
+    std::string name_;
+    KernelFn fn_;
+    LatencyModel latency_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<std::shared_ptr<Command>> queue_;   // front is running
+    bool stop_;
+    std::thread thread_;
+};
+
+class Device {
+public:
+    Device() : latency_(LatencyModel::from_env()) {}
+
+    const LatencyModel &latency() const { return latency_; }
+
+    // Instantiate XRT_EMU_CUS (default 2) compute units of every registered kernel
+    void load() {
+        const char *text = std::getenv("XRT_EMU_CUS");
+        const int cus = text && std::atoi(text) > 0 ? std::atoi(text) : 2;
+        std::lock_guard<std::mutex> lock(mutex_);
+        units_.clear();
+        for (const auto &entry : kernel_registry()) {
+            for (int i = 1; i <= cus; i++) {
+                units_.emplace_back(new ComputeUnit(entry.first + "_" + std::to_string(i), entry.second, latency_));
+            }
+        }
+    }
+
+    // "name" selects every compute unit of the kernel, "name:{cu_a,cu_b}" the listed ones
+    std::vector<ComputeUnit *> find(const std::string &spec) {
+        const size_t brace = spec.find(":{");
+        const std::string kernel = spec.substr(0, brace);
+        std::vector<std::string> wanted;
+        if (brace != std::string::npos) {
+            std::string list = spec.substr(brace + 2);
+            list = list.substr(0, list.find('}'));
+            size_t pos = 0;
+            while (pos <= list.size()) {
+                size_t end = list.find(',', pos);
+                end = end == std::string::npos ? list.size() : end;
+                wanted.push_back(list.substr(pos, end - pos));
+                pos = end + 1;
+            }
+        }
+
+        std::vector<ComputeUnit *> found;
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto &unit : units_) {
+            const std::string &name = unit->name();
+            const bool of_kernel = name.compare(0, kernel.size() + 1, kernel + "_") == 0;
+            if (of_kernel && (wanted.empty() || std::find(wanted.begin(), wanted.end(), name) != wanted.end())) {
+                found.push_back(unit.get());
+            }
+        }
+        if (found.empty() || (!wanted.empty() && found.size() != wanted.size())) {
+            throw std::runtime_error("xrt_emu: no compute unit matches '" + spec + "'");
+        }
+        return found;
+    }
+
+private:
+    LatencyModel latency_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<ComputeUnit>> units_;
+};
+
+// Host and device copies of one buffer object
+struct Buffer {
+    std::vector<unsigned char> host;
+    std::vector<unsigned char> device;
+    explicit Buffer(size_t size) : host(size, 0), device(size, 0) {}
+};
+
+} // namespace xrt_emu
+
+namespace xrt {
+
+class uuid {
+public:
+    uuid() {}
+    explicit uuid(const std::string &value) : value_(value) {}
+    std::string to_string() const { return value_; }
+private:
+    std::string value_;
+};
+
+typedef int memory_group;
+
+class device {
+public:
+    explicit device(unsigned int index) : impl_(std::make_shared<xrt_emu::Device>()) { (void)index; }
+
+    uuid load_xclbin(const std::string &xclbin_file) {
+        impl_->load();
+        return uuid(xclbin_file);
+    }
+
+    const std::shared_ptr<xrt_emu::Device> &emu() const { return impl_; }
+
+private:
+    std::shared_ptr<xrt_emu::Device> impl_;
+};
+
+class bo {
+public:
+    bo() {}
+    bo(const device &dev, size_t size, memory_group group)
+        : device_(dev.emu()), impl_(std::make_shared<xrt_emu::Buffer>(size)) { (void)group; }
+
+    size_t size() const { return impl_->host.size(); }
+
+    template <typename T>
+    T map() { return reinterpret_cast<T>(impl_->host.data()); }
+
+    void write(const void *src) { write(src, size(), 0); }
+    void write(const void *src, size_t bytes, size_t seek) {
+        check(bytes, seek);
+        std::memcpy(impl_->host.data() + seek, src, bytes);
+    }
+
+    void read(void *dst) { read(dst, size(), 0); }
+    void read(void *dst, size_t bytes, size_t skip) {
+        check(bytes, skip);
+        std::memcpy(dst, impl_->host.data() + skip, bytes);
+    }
+
+    void sync(xclBOSyncDirection dir) { sync(dir, size(), 0); }
+    void sync(xclBOSyncDirection dir, size_t bytes, size_t offset) {
+        check(bytes, offset);
+        xrt_emu::delay_us(device_->latency().transfer_us(bytes));
+        if (dir == XCL_BO_SYNC_BO_TO_DEVICE) {
+            std::memcpy(impl_->device.data() + offset, impl_->host.data() + offset, bytes);
+        } else {
+            std::memcpy(impl_->host.data() + offset, impl_->device.data() + offset, bytes);
+        }
+    }
+
+    void *device_data() const { return impl_->device.data(); }
+
+private:
+    void check(size_t bytes, size_t offset) const {
+        if (offset + bytes > size()) {
+            throw std::out_of_range("xrt_emu: buffer access out of range");
+        }
+    }
+
+    std::shared_ptr<xrt_emu::Device> device_;
+    std::shared_ptr<xrt_emu::Buffer> impl_;
+};
+
+class kernel {
+public:
+    kernel() {}
+    kernel(const device &dev, const uuid &xclbin_id, const std::string &name)
+        : device_(dev.emu()), units_(dev.emu()->find(name)) {
+        (void)xclbin_id;
+    }
+
+    // Single memory bank in the emulation
+    int group_id(int argno) const {
+        (void)argno;
+        return 0;
+    }
+
+    // Least loaded of the kernel's compute units
+    xrt_emu::ComputeUnit *pick() const {
+        xrt_emu::ComputeUnit *best = units_.front();
+        size_t best_queued = best->queued();
+        for (size_t i = 1; i < units_.size() && best_queued > 0; i++) {
+            const size_t queued = units_[i]->queued();
+            if (queued < best_queued) {
+                best = units_[i];
+                best_queued = queued;
+            }
+        }
+        return best;
+    }
+
+private:
+    std::shared_ptr<xrt_emu::Device> device_;   // keeps the compute units alive
+    std::vector<xrt_emu::ComputeUnit *> units_;
+};
+
+class run {
+public:
+    run() {}
+    explicit run(const kernel &krnl) : kernel_(krnl), command_(std::make_shared<xrt_emu::Command>()) {}
+
+    void set_arg(int index, const bo &buffer) { command_->args.set_buffer(index, buffer.device_data()); }
+    void set_arg(int index, bo &buffer) { set_arg(index, static_cast<const bo &>(buffer)); }
+
+    template <typename T>
+    void set_arg(int index, T value) {
+        static_assert(sizeof(T) <= sizeof(uint64_t), "scalar kernel arguments are at most 64 bits");
+        uint64_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(T));
+        command_->args.set_bits(index, bits);
+    }
+
+    // Queue on the least loaded compute unit; a run may be restarted once it completed
+    void start() {
+        if (state() == ERT_CMD_STATE_QUEUED || state() == ERT_CMD_STATE_RUNNING) {
+            throw std::runtime_error("xrt_emu: run started while still in flight");
+        }
+        kernel_.pick()->submit(command_);
+    }
+
+    ert_cmd_state wait(const std::chrono::milliseconds &timeout = std::chrono::milliseconds(0)) {
+        std::unique_lock<std::mutex> lock(command_->mutex);
+        auto finished = [this] {
+            return command_->state != ERT_CMD_STATE_QUEUED && command_->state != ERT_CMD_STATE_RUNNING;
+        };
+        if (timeout.count() > 0) {
+            if (!command_->done.wait_for(lock, timeout, finished)) {
+                return ERT_CMD_STATE_TIMEOUT;
+            }
+        } else {
+            command_->done.wait(lock, finished);
+        }
+        return command_->state;
+    }
+
+    ert_cmd_state state() const {
+        std::lock_guard<std::mutex> lock(command_->mutex);
+        return command_->state;
+    }
+
+private:
+    kernel kernel_;
+    std::shared_ptr<xrt_emu::Command> command_;
+};
+
+} // namespace xrt
+
+#endif // XRT_EMU_H
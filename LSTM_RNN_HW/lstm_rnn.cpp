@@ -3,6 +3,9 @@
 #include <fstream>
 #include <iostream>
 #include <vector>
+#if defined(LSTM_PROBE) && !defined(__SYNTHESIS__)
+#include "../LSTM_RNN_CPU/gate_probe.h"
+#endif
 
 // Xavier initialization
 fixed_type xavier_initialization(int input_size, int output_size) {
@@ -48,45 +51,6 @@ void initialize_weights_and_biases() {
     }
 }
 
-// Save weights to a file
-void save_weights(const std::string &filename, fixed_type weights[][INPUT_SIZE], int rows, int cols) {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << filename << " for saving weights." << std::endl;
-        return;
-    }
-
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            file << weights[i][j].to_double() << " ";
-        }
-        file << "\n";
-    }
-
-    file.close();
-}
-
-// Load weights from a file
-bool load_weights(const std::string &filename, fixed_type weights[][INPUT_SIZE], int rows, int cols) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
-        return false;
-    }
-
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            double value;
-            if (!(file >> value)) {
-                return false;
-            }
-            weights[i][j] = fixed_type(value);
-        }
-    }
-
-    file.close();
-    return true;
-}
-
 // Activation functions
 inline fixed_type sigmoid(fixed_type x) {
     fixed_type result = (fixed_type)1.0 / ((fixed_type)1.0 + hls::exp(-x));
@@ -128,6 +92,22 @@ void lstm_cell(fixed_type x[INPUT_SIZE], fixed_type h_prev[HIDDEN_SIZE], fixed_t
     }
 }
 
+#if defined(LSTM_PROBE) && !defined(__SYNTHESIS__)
+// C-simulation only: hand one timestep's gates and states to the probe
+static void probe_step(int t, const fixed_type i_gate[HIDDEN_SIZE], const fixed_type f_gate[HIDDEN_SIZE],
+                       const fixed_type g_gate[HIDDEN_SIZE], const fixed_type o_gate[HIDDEN_SIZE],
+                       const fixed_type c[HIDDEN_SIZE], const fixed_type h[HIDDEN_SIZE]) {
+    const fixed_type *fields[GATE_PROBE_FIELDS] = {i_gate, f_gate, g_gate, o_gate, c, h};
+    float values[GATE_PROBE_FIELDS][HIDDEN_SIZE];
+    for (int k = 0; k < GATE_PROBE_FIELDS; k++) {
+        for (int i = 0; i < HIDDEN_SIZE; i++) {
+            values[k][i] = fields[k][i].to_float();
+        }
+    }
+    GateProbe::instance().record(t, &values[0][0], HIDDEN_SIZE);
+}
+#endif
+
 // LSTM sequence processing with gate debugging
 void lstm_sequence(fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE], fixed_type h[HIDDEN_SIZE], fixed_type c[HIDDEN_SIZE],
                    fixed_type output_data[INPUT_SIZE],
@@ -135,6 +115,11 @@ void lstm_sequence(fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE], fixed_type h[HIDDEN
                    fixed_type g_gate[HIDDEN_SIZE], fixed_type o_gate[HIDDEN_SIZE]) {
     for (int t = 0; t < SEQ_LENGTH; t++) {
         lstm_cell(x_seq[t], h, c, h, c, i_gate, f_gate, g_gate, o_gate);
+#if defined(LSTM_PROBE) && !defined(__SYNTHESIS__)
+        if (gate_probe_enabled()) {
+            probe_step(t, i_gate, f_gate, g_gate, o_gate, c, h);
+        }
+#endif
     }
 
     for (int i = 0; i < INPUT_SIZE; i++) {
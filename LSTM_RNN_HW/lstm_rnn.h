@@ -1,7 +1,11 @@
 #ifndef LSTM_RNN_H
 #define LSTM_RNN_H
 
+#ifdef AP_FIXED_EMU
+#include "../LSTM_RNN_CPU/ap_fixed_emu.h"   // native ap_fixed and approximate hls::exp/tanh for C-simulation
+#else
 #include <hls_math.h>
+#endif
 #include <vector>
 #include <string>
 #include <fstream>
@@ -44,8 +48,4 @@ void lstm_sequence(fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE], fixed_type h[HIDDEN
 
 void initialize_weights_and_biases();
 
-// Weight management functions
-void save_weights(const std::string &filename, fixed_type weights[][INPUT_SIZE], int rows, int cols);
-bool load_weights(const std::string &filename, fixed_type weights[][INPUT_SIZE], int rows, int cols);
-
 #endif // LSTM_RNN_H
\ No newline at end of file
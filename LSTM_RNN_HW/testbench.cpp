@@ -4,155 +4,114 @@
 #include <cmath>
 #include <cstdlib>
 #include <string>
-#include <sstream>
 #include <algorithm>
 #include "lstm_rnn.h"
 
+#define INGEST_NO_THREADS
+#include "../LSTM_RNN_CPU/text_ingest.h"
+#include "../LSTM_RNN_CPU/online_normalizer.h"
+#include "../LSTM_RNN_CPU/weight_file.h"
+#include "../LSTM_RNN_CPU/trace.h"
+#ifdef LSTM_PROBE
+#include "../LSTM_RNN_CPU/gate_probe.h"
+#endif
+
 // Global weight definitions
 extern fixed_type W_i[HIDDEN_SIZE][INPUT_SIZE], U_i[HIDDEN_SIZE][HIDDEN_SIZE], b_i[HIDDEN_SIZE];
 extern fixed_type W_f[HIDDEN_SIZE][INPUT_SIZE], U_f[HIDDEN_SIZE][HIDDEN_SIZE], b_f[HIDDEN_SIZE];
 extern fixed_type W_c[HIDDEN_SIZE][INPUT_SIZE], U_c[HIDDEN_SIZE][HIDDEN_SIZE], b_c[HIDDEN_SIZE];
 extern fixed_type W_o[HIDDEN_SIZE][INPUT_SIZE], U_o[HIDDEN_SIZE][HIDDEN_SIZE], b_o[HIDDEN_SIZE];
 
-// Function to save weights to a file
+// Gate tensors in the weight container's split layout, gate order WEIGHT_GATE_ORDER
+static fixed_type *const gate_W[4] = {&W_i[0][0], &W_f[0][0], &W_c[0][0], &W_o[0][0]};
+static fixed_type *const gate_U[4] = {&U_i[0][0], &U_f[0][0], &U_c[0][0], &U_o[0][0]};
+static fixed_type *const gate_b[4] = {b_i, b_f, b_c, b_o};
+
+// Function to save weights to a file (ap_fixed<64, 32> values are exact in double)
 void save_weights_to_file() {
-    std::ofstream weight_file("weights.dat", std::ios::binary);
-    if (!weight_file.is_open()) {
-        std::cerr << "Error: Could not open weights file for saving!" << std::endl;
-        return;
+    WeightFileWriter writer(WEIGHT_MODEL_LSTM, WEIGHT_F64, WEIGHT_LAYOUT_SPLIT, INPUT_SIZE, HIDDEN_SIZE, INPUT_SIZE);
+    writer.set_fixed_format(64, 32);
+    bool ok = true;
+    for (int g = 0; g < 4 && ok; g++) {
+        const std::string gate(1, WEIGHT_GATE_ORDER[g]);
+        ok = writer.add(("W_" + gate).c_str(), gate_W[g], HIDDEN_SIZE, INPUT_SIZE) &&
+             writer.add(("U_" + gate).c_str(), gate_U[g], HIDDEN_SIZE, HIDDEN_SIZE) &&
+             writer.add(("b_" + gate).c_str(), gate_b[g], 1, HIDDEN_SIZE);
+    }
+    if (!ok || !writer.save("weights.dat")) {
+        std::cerr << "Error: Could not save weights file!" << std::endl;
     }
-    weight_file.write(reinterpret_cast<const char *>(W_i), sizeof(W_i));
-    weight_file.write(reinterpret_cast<const char *>(U_i), sizeof(U_i));
-    weight_file.write(reinterpret_cast<const char *>(b_i), sizeof(b_i));
-    weight_file.write(reinterpret_cast<const char *>(W_f), sizeof(W_f));
-    weight_file.write(reinterpret_cast<const char *>(U_f), sizeof(U_f));
-    weight_file.write(reinterpret_cast<const char *>(b_f), sizeof(b_f));
-    weight_file.write(reinterpret_cast<const char *>(W_c), sizeof(W_c));
-    weight_file.write(reinterpret_cast<const char *>(U_c), sizeof(U_c));
-    weight_file.write(reinterpret_cast<const char *>(b_c), sizeof(b_c));
-    weight_file.write(reinterpret_cast<const char *>(W_o), sizeof(W_o));
-    weight_file.write(reinterpret_cast<const char *>(U_o), sizeof(U_o));
-    weight_file.write(reinterpret_cast<const char *>(b_o), sizeof(b_o));
-    weight_file.close();
 }
 
 // Function to initialize or load weights
 void initialize_or_load_weights() {
-    std::ifstream weight_file("weights.dat", std::ios::binary);
-    if (weight_file.is_open()) {
-        weight_file.read(reinterpret_cast<char *>(W_i), sizeof(W_i));
-        weight_file.read(reinterpret_cast<char *>(U_i), sizeof(U_i));
-        weight_file.read(reinterpret_cast<char *>(b_i), sizeof(b_i));
-        weight_file.read(reinterpret_cast<char *>(W_f), sizeof(W_f));
-        weight_file.read(reinterpret_cast<char *>(U_f), sizeof(U_f));
-        weight_file.read(reinterpret_cast<char *>(b_f), sizeof(b_f));
-        weight_file.read(reinterpret_cast<char *>(W_c), sizeof(W_c));
-        weight_file.read(reinterpret_cast<char *>(U_c), sizeof(U_c));
-        weight_file.read(reinterpret_cast<char *>(b_c), sizeof(b_c));
-        weight_file.read(reinterpret_cast<char *>(W_o), sizeof(W_o));
-        weight_file.read(reinterpret_cast<char *>(U_o), sizeof(U_o));
-        weight_file.read(reinterpret_cast<char *>(b_o), sizeof(b_o));
-        weight_file.close();
-    } else {
+    WeightFile weight_file;
+    bool loaded = std::ifstream("weights.dat").good() && weight_file.open("weights.dat");
+    if (loaded) {
+        const WeightHeader &header = weight_file.header();
+        loaded = header.model == WEIGHT_MODEL_LSTM && header.input_size == INPUT_SIZE &&
+                 header.hidden_size == HIDDEN_SIZE;
+        for (int g = 0; g < 4 && loaded; g++) {
+            const std::string gate(1, WEIGHT_GATE_ORDER[g]);
+            loaded = weight_file.copy(("W_" + gate).c_str(), gate_W[g], HIDDEN_SIZE, INPUT_SIZE) &&
+                     weight_file.copy(("U_" + gate).c_str(), gate_U[g], HIDDEN_SIZE, HIDDEN_SIZE) &&
+                     weight_file.copy(("b_" + gate).c_str(), gate_b[g], 1, HIDDEN_SIZE);
+        }
+    }
+    if (!loaded) {
         std::cout << "Weights file not found. Initializing new weights..." << std::endl;
         initialize_weights_and_biases();
         save_weights_to_file();
     }
 }
 
-// Function to normalize data
-void normalize_data(const std::vector<std::vector<double>> &raw_data, std::vector<std::vector<fixed_type>> &normalized_data, std::vector<double> &means, std::vector<double> &std_devs) {
-    int num_features = raw_data[0].size();
-    int num_samples = raw_data.size();
-
-    means.resize(num_features, 0.0);
-    std_devs.resize(num_features, 0.0);
-
-    for (const auto &row : raw_data) {
-        for (int i = 0; i < num_features; ++i) {
-            means[i] += row[i];
-        }
-    }
-    for (int i = 0; i < num_features; ++i) {
-        means[i] /= num_samples;
-    }
-
-    for (const auto &row : raw_data) {
-        for (int i = 0; i < num_features; ++i) {
-            std_devs[i] += (row[i] - means[i]) * (row[i] - means[i]);
-        }
-    }
-    for (int i = 0; i < num_features; ++i) {
-        std_devs[i] = std::sqrt(std_devs[i] / num_samples);
-    }
-
-    for (const auto &row : raw_data) {
-        std::vector<fixed_type> normalized_row;
-        for (int i = 0; i < num_features; ++i) {
-            normalized_row.push_back((row[i] - means[i]) / std_devs[i]);
-        }
-        normalized_data.push_back(normalized_row);
+// Function to load data from data.txt, any layout text_ingest.h detects
+void load_data(const std::string &file_name, int &prediction_days, IngestTable<double> &raw_data) {
+    TRACE_SCOPE("parse");
+    if (ingest_text(file_name, raw_data)) {
+        prediction_days = raw_data.prediction_days;
     }
 }
 
-// Function to load data from data.txt
-void load_data(const std::string &file_name, int &prediction_days, std::vector<std::vector<double>> &raw_data) {
-    std::ifstream file(file_name);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open file " << file_name << std::endl;
-        return;
-    }
-
-    std::string line;
-    if (std::getline(file, line)) {
-        prediction_days = std::stoi(line);
-    }
-
-    std::getline(file, line); // Skip header
-    std::getline(file, line); // Skip tickers
-    std::getline(file, line); // Skip dates
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::vector<double> row;
-        std::string value;
-
-        int column = 0;
-        while (std::getline(iss, value, ',')) {
-            if (column++ == 0) continue;
-            row.push_back(std::stod(value));
-        }
-        if (!row.empty()) {
-            raw_data.push_back(row);
-        }
-    }
-    file.close();
-}
-
 int main() {
+    TraceSession trace_session;
+#ifdef LSTM_PROBE
+    // Per-timestep gates and states when LSTM_PROBE names a file; probe_decode
+    // --debug turns it into the old debug_output.dat text
+    GateProbeSession probe_session;
+#endif
     const std::string file_name = "data.txt";
     const std::string output_file_name = "out.dat";
-    const std::string debug_file_name = "debug_output.dat";
 
-    initialize_or_load_weights();
+    {
+        TRACE_SCOPE("load_weights");
+        initialize_or_load_weights();
+    }
 
     int prediction_days = 0;
-    std::vector<std::vector<double>> raw_data;
+    IngestTable<double> raw_data;
     load_data(file_name, prediction_days, raw_data);
 
-    if (raw_data.empty()) {
+    if (raw_data.rows() == 0) {
         std::cerr << "Error: No data loaded!" << std::endl;
         return -1;
     }
+    if (raw_data.num_features != INPUT_SIZE) {
+        std::cerr << "Error: Expected " << INPUT_SIZE << " values per row in " << file_name << ", found "
+                  << raw_data.num_features << "." << std::endl;
+        return -1;
+    }
 
-    std::vector<std::vector<fixed_type>> normalized_data;
-    std::vector<double> means, std_devs;
-    normalize_data(raw_data, normalized_data, means, std_devs);
-
+    // Single-pass statistics, saved next to weights.dat so a later run can
+    // normalize new bars without rescanning the history
+    OnlineNormalizer normalizer(raw_data.num_features);
     fixed_type input_seq[SEQ_LENGTH][INPUT_SIZE] = {0};
-    for (int i = 0; i < SEQ_LENGTH && i < normalized_data.size(); ++i) {
-        for (int j = 0; j < INPUT_SIZE; ++j) {
-            input_seq[i][j] = normalized_data[i][j];
+    {
+        TRACE_SCOPE("normalize");
+        normalizer.push_rows(raw_data.values.data(), raw_data.rows());
+        normalizer.save(NORMALIZER_FILE);
+        for (int i = 0; i < SEQ_LENGTH && i < (int)raw_data.rows(); ++i) {
+            normalizer.normalize(raw_data.row(i), input_seq[i]);
         }
     }
 
@@ -162,31 +121,32 @@ int main() {
 
     fixed_type i_gate[HIDDEN_SIZE], f_gate[HIDDEN_SIZE], o_gate[HIDDEN_SIZE], g_gate[HIDDEN_SIZE];
 
-    std::ofstream output_file(output_file_name), debug_file(debug_file_name);
+    std::ofstream output_file(output_file_name);
     for (int day = 0; day < prediction_days; ++day) {
         // Perform the LSTM sequence operation
-        lstm_sequence(input_seq, h, c, output_data, i_gate, f_gate, o_gate, g_gate);
-
-        // Log debug information
-        debug_file << "Day " << day + 1 << " Debug Information:\n";
-        debug_file << "Hidden States (h): ";
-        for (int i = 0; i < HIDDEN_SIZE; i++) {
-            debug_file << h[i].to_double() << " ";
+        {
+            TRACE_SCOPE("kernel_run");
+            lstm_sequence(input_seq, h, c, output_data, i_gate, f_gate, o_gate, g_gate);
         }
-        debug_file << "\nCell States (c): ";
-        for (int i = 0; i < HIDDEN_SIZE; i++) {
-            debug_file << c[i].to_double() << " ";
+
+        // Apply denormalization to each output
+        double denormalized[INPUT_SIZE];
+        {
+            TRACE_SCOPE("denormalize");
+            for (int i = 0; i < INPUT_SIZE; ++i) {
+                denormalized[i] = normalizer.denormalize(i, output_data[i].to_double());
+            }
         }
-        debug_file << "\n";
-
-        // Log predictions to the output file with denormalization
-        output_file << "Day " << day + 1 << ": ";
-        for (int i = 0; i < INPUT_SIZE; ++i) {
-            // Apply denormalization to each output
-            double denormalized_value = output_data[i].to_double() * std_devs[i] + means[i];
-            output_file << denormalized_value << " ";
+
+        // Log predictions to the output file
+        {
+            TRACE_SCOPE("output_file");
+            output_file << "Day " << day + 1 << ": ";
+            for (int i = 0; i < INPUT_SIZE; ++i) {
+                output_file << denormalized[i] << " ";
+            }
+            output_file << "\n";
         }
-        output_file << "\n";
 
         // Shift input sequence for the next prediction
         for (int i = 0; i < SEQ_LENGTH - 1; ++i) {
@@ -199,9 +159,11 @@ int main() {
         }
     }
 
-    save_weights_to_file();
+    {
+        TRACE_SCOPE("save_weights");
+        save_weights_to_file();
+    }
     output_file.close();
-    debug_file.close();
 
     return 0;
 }
\ No newline at end of file
@@ -6,10 +6,8 @@
 #include <xrt/xrt_kernel.h>
 #include <xrt/xrt_bo.h>
 
-// Define constants
-#define SEQ_LENGTH 60
-#define INPUT_SIZE 5
-#define HIDDEN_SIZE 16
+#define RNN_HOST          // sizes only, no HLS types
+#include "../rnn.h"
 
 typedef float fixed_type; // Data type for compatibility
 
@@ -19,31 +17,35 @@ void load_data(const char *filename, std::vector<fixed_type> &data) {
         std::cerr << "Error: Unable to open file " << filename << std::endl;
         exit(EXIT_FAILURE);
     }
+    const size_t start = data.size();
     fixed_type value;
     while (file >> value) {
         data.push_back(value);
     }
     file.close();
-    if (data.size() != SEQ_LENGTH * INPUT_SIZE) {
-        std::cerr << "Error: Input size mismatch. Expected " << SEQ_LENGTH * INPUT_SIZE 
-                  << ", got " << data.size() << std::endl;
+    if (data.size() - start != SEQ_LENGTH * INPUT_SIZE) {
+        std::cerr << "Error: Input size mismatch in " << filename << ". Expected " << SEQ_LENGTH * INPUT_SIZE
+                  << ", got " << data.size() - start << std::endl;
         exit(EXIT_FAILURE);
     }
 }
 
 int main(int argc, char** argv) {
-    if (argc != 3) {
-        std::cerr << "Usage: " << argv[0] << " <xclbin file> <data file>" << std::endl;
+    if (argc < 3 || argc - 2 > MAX_BATCH) {
+        std::cerr << "Usage: " << argv[0] << " <xclbin file> <data file> [data file...] (up to " << MAX_BATCH
+                  << " data files)" << std::endl;
         return EXIT_FAILURE;
     }
 
     std::string xclbin_path = argv[1];
-    std::string data_path = argv[2];
+    const int batch = argc - 2;
 
-    // Load input data
+    // Load input data, one sequence per data file, back to back
     std::vector<fixed_type> input_data;
-    load_data(data_path.c_str(), input_data);
-    std::vector<fixed_type> output_data(HIDDEN_SIZE, 0);
+    for (int s = 0; s < batch; s++) {
+        load_data(argv[2 + s], input_data);
+    }
+    std::vector<fixed_type> output_data(batch * HIDDEN_SIZE, 0);
 
     // Open the device and load the xclbin
     auto device = xrt::device(0);
@@ -55,23 +57,36 @@ int main(int argc, char** argv) {
     // Allocate device buffers
     auto in_buffer = xrt::bo(device, input_data.size() * sizeof(fixed_type), kernel.group_id(0));
     auto out_buffer = xrt::bo(device, output_data.size() * sizeof(fixed_type), kernel.group_id(1));
+    auto status_buffer = xrt::bo(device, sizeof(int), kernel.group_id(6));
 
     // Write input data to the input buffer
     in_buffer.write(input_data.data());
     in_buffer.sync(XCL_BO_SYNC_BO_TO_DEVICE);
 
-    // Run the kernel
-    auto run = kernel(in_buffer, out_buffer, SEQ_LENGTH, INPUT_SIZE, HIDDEN_SIZE);
+    // Run the kernel once for the whole batch
+    auto run = kernel(in_buffer, out_buffer, SEQ_LENGTH, INPUT_SIZE, HIDDEN_SIZE, batch, status_buffer);
     run.wait();
 
+    // The kernel rejects sizes it was not built for without touching the outputs
+    int status = -1;
+    status_buffer.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    status_buffer.read(&status);
+    if (status != RNN_STATUS_OK) {
+        std::cerr << "Error: rnn_sequence returned status " << status
+                  << (status == RNN_STATUS_BAD_ARGS ? " (sizes do not match the bitstream)" : "") << std::endl;
+        return EXIT_FAILURE;
+    }
+
     // Read output data from the output buffer
     out_buffer.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
     out_buffer.read(output_data.data());
 
     // Print output
-    std::cout << "Kernel output:" << std::endl;
-    for (int i = 0; i < HIDDEN_SIZE; i++) {
-        std::cout << "Feature[" << i << "]: " << output_data[i] << std::endl;
+    for (int s = 0; s < batch; s++) {
+        std::cout << "Kernel output for " << argv[2 + s] << ":" << std::endl;
+        for (int i = 0; i < HIDDEN_SIZE; i++) {
+            std::cout << "Feature[" << i << "]: " << output_data[s * HIDDEN_SIZE + i] << std::endl;
+        }
     }
 
     return EXIT_SUCCESS;
@@ -4,23 +4,12 @@
 */
 
 #include "rnn.h"
+#include "rnn_hw_weights.h"
 
-// Weight matrices and bias initialization
-fixed_type W[HIDDEN_SIZE][INPUT_SIZE] = {
-    {0.0543, -0.0234, 0.0675, -0.0812, 0.0398},
-    {-0.0457, 0.0321, -0.0104, 0.0932, -0.0671},
-    {0.0223, -0.0785, 0.0416, -0.0123, 0.0887},
-    {-0.0371, 0.0465, -0.0568, 0.0721, -0.0352}
-};
-
-fixed_type U[HIDDEN_SIZE][HIDDEN_SIZE] = {
-    {0.0625, -0.0492, 0.0108, -0.0715},
-    {-0.0537, 0.0304, -0.0417, 0.0552},
-    {0.0185, -0.0673, 0.0241, -0.0811},
-    {0.0456, -0.0327, 0.0732, -0.0554}
-};
-
-fixed_type b[HIDDEN_SIZE] = {0.0, 0.01, -0.02, 0.03};
+// Weight matrices and bias initialization, every hidden row (shared with the CPU reference)
+fixed_type W[HIDDEN_SIZE][INPUT_SIZE] = RNN_HW_W_INIT;
+fixed_type U[HIDDEN_SIZE][HIDDEN_SIZE] = RNN_HW_U_INIT;
+fixed_type b[HIDDEN_SIZE] = RNN_HW_B_INIT;
 
 // Function to compute one RNN cell step
 void rnn_cell(fixed_type x[INPUT_SIZE], fixed_type h_prev[HIDDEN_SIZE], fixed_type h[HIDDEN_SIZE]) {
@@ -45,32 +34,87 @@ void rnn_cell(fixed_type x[INPUT_SIZE], fixed_type h_prev[HIDDEN_SIZE], fixed_ty
     }
 }
 
-// Function to process an entire sequence with the RNN
-void rnn_sequence(fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE], fixed_type h[HIDDEN_SIZE]) {
-    #pragma HLS ARRAY_PARTITION variable=W complete dim=2
-    #pragma HLS ARRAY_PARTITION variable=U complete dim=2
-    #pragma HLS ARRAY_PARTITION variable=b complete dim=1
-    #pragma HLS ARRAY_PARTITION variable=h complete dim=1
+// Read one sequence into local memory as a single sequential burst
+static void load_sequence(const float *x_seq, int seq_length, fixed_type x_local[MAX_SEQ_LENGTH][INPUT_SIZE]) {
+    int t = 0, j = 0;
+    for (int k = 0; k < seq_length * INPUT_SIZE; k++) {
+        #pragma HLS PIPELINE II=1
+        #pragma HLS LOOP_TRIPCOUNT min=INPUT_SIZE max=MAX_SEQ_LENGTH*INPUT_SIZE
+        x_local[t][j] = x_seq[k];
+        if (++j == INPUT_SIZE) {
+            j = 0;
+            t++;
+        }
+    }
+}
 
-    fixed_type h_prev[HIDDEN_SIZE] = {0}; // Initialize hidden state to zero
+// Run one sequence from a zero state
+static void run_sequence(fixed_type x_local[MAX_SEQ_LENGTH][INPUT_SIZE], int seq_length, fixed_type h[HIDDEN_SIZE]) {
+    fixed_type h_prev[HIDDEN_SIZE];
+    #pragma HLS ARRAY_PARTITION variable=h_prev complete dim=1
+    for (int i = 0; i < HIDDEN_SIZE; i++) {
+        #pragma HLS UNROLL
+        h_prev[i] = 0;
+    }
 
     // Process each time step in the sequence
-    for (int t = 0; t < SEQ_LENGTH; t++) {
-        fixed_type x[INPUT_SIZE];
-
-        // Load input for the current time step
-        for (int i = 0; i < INPUT_SIZE; i++) {
-            x[i] = x_seq[t][i];
-        }
-
+    for (int t = 0; t < seq_length; t++) {
+        #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_SEQ_LENGTH
         // Compute the RNN cell for the current time step
-        rnn_cell(x, h_prev, h);
+        rnn_cell(x_local[t], h_prev, h);
 
         // Update h_prev for the next time step
         for (int i = 0; i < HIDDEN_SIZE; i++) {
+            #pragma HLS UNROLL
             h_prev[i] = h[i];
         }
     }
 }
 
+// Write one final hidden state as a single burst
+static void store_state(fixed_type h[HIDDEN_SIZE], float *h_out) {
+    for (int i = 0; i < HIDDEN_SIZE; i++) {
+        #pragma HLS PIPELINE II=1
+        h_out[i] = h[i].to_float();
+    }
+}
+
+// Function to process a batch of sequences with the RNN, one launch per batch
+void rnn_sequence(const float *x_seq, float *h_out, int seq_length, int input_size, int hidden_size, int batch,
+                  int *status) {
+    #pragma HLS INTERFACE m_axi port=x_seq offset=slave bundle=gmem0 max_read_burst_length=256 depth=81920
+    #pragma HLS INTERFACE m_axi port=h_out offset=slave bundle=gmem1 max_write_burst_length=16 depth=1024
+    #pragma HLS INTERFACE m_axi port=status offset=slave bundle=gmem1 depth=1
+    #pragma HLS INTERFACE s_axilite port=x_seq
+    #pragma HLS INTERFACE s_axilite port=h_out
+    #pragma HLS INTERFACE s_axilite port=seq_length
+    #pragma HLS INTERFACE s_axilite port=input_size
+    #pragma HLS INTERFACE s_axilite port=hidden_size
+    #pragma HLS INTERFACE s_axilite port=batch
+    #pragma HLS INTERFACE s_axilite port=status
+    #pragma HLS INTERFACE s_axilite port=return
+
+    #pragma HLS ARRAY_PARTITION variable=W complete dim=2
+    #pragma HLS ARRAY_PARTITION variable=U complete dim=2
+    #pragma HLS ARRAY_PARTITION variable=b complete dim=1
+
+    // The weights and local buffers are sized at build time
+    if (input_size != INPUT_SIZE || hidden_size != HIDDEN_SIZE || seq_length < 1 || seq_length > MAX_SEQ_LENGTH ||
+        batch < 1 || batch > MAX_BATCH) {
+        status[0] = RNN_STATUS_BAD_ARGS;
+        return;
+    }
 
+    fixed_type x_local[MAX_SEQ_LENGTH][INPUT_SIZE];
+    #pragma HLS ARRAY_PARTITION variable=x_local complete dim=2
+    fixed_type h[HIDDEN_SIZE];
+    #pragma HLS ARRAY_PARTITION variable=h complete dim=1
+
+    for (int s = 0; s < batch; s++) {
+        #pragma HLS LOOP_TRIPCOUNT min=1 max=MAX_BATCH
+        load_sequence(x_seq + s * seq_length * INPUT_SIZE, seq_length, x_local);
+        run_sequence(x_local, seq_length, h);
+        store_state(h, h_out + s * HIDDEN_SIZE);
+    }
+    status[0] = RNN_STATUS_OK;
+}
@@ -6,14 +6,28 @@
 #ifndef RNN_H
 #define RNN_H
 
-#include <hls_math.h>
-
-typedef ap_fixed<32, 16> fixed_type;
-
 // Define parameters
 #define INPUT_SIZE 5      // Size of each input vector x_t
 #define HIDDEN_SIZE 16    // Size of each hidden state vector h_t
 #define SEQ_LENGTH 60     // Length of the input sequence
+#define MAX_SEQ_LENGTH 256  // Longest sequence one run accepts
+#define MAX_BATCH 64        // Most sequences one run accepts
+
+// Status word rnn_sequence writes on every launch
+#define RNN_STATUS_OK 0          // h_out holds batch final states
+#define RNN_STATUS_BAD_ARGS 1    // sizes outside the build, h_out untouched
+
+// The XRT host only needs the sizes above; it defines RNN_HOST so it builds
+// without the HLS headers
+#ifndef RNN_HOST
+
+#ifdef AP_FIXED_EMU
+#include "../LSTM_RNN_CPU/ap_fixed_emu.h"   // native ap_fixed and approximate hls::exp/tanh for C-simulation
+#else
+#include <hls_math.h>
+#endif
+
+typedef ap_fixed<32, 16> fixed_type;
 
 // Declare weight matrices and bias vector for the RNN cell
 extern fixed_type W[HIDDEN_SIZE][INPUT_SIZE];   // Input weight matrix
@@ -22,6 +36,16 @@ extern fixed_type b[HIDDEN_SIZE];               // Bias vector
 
 // Function declarations
 void rnn_cell(fixed_type x[INPUT_SIZE], fixed_type h_prev[HIDDEN_SIZE], fixed_type h[HIDDEN_SIZE]);
-void rnn_sequence(fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE], fixed_type h[HIDDEN_SIZE]);
+
+// Top function. x_seq holds batch sequences of seq_length x input_size floats
+// back to back; each runs from a zero state and its final hidden state goes to
+// h_out[batch][hidden_size]. input_size and hidden_size must be the sizes the
+// bitstream was built for, and seq_length and batch at most MAX_SEQ_LENGTH and
+// MAX_BATCH. status[0] is set to RNN_STATUS_OK after a run, or to
+// RNN_STATUS_BAD_ARGS with h_out untouched for any other arguments.
+void rnn_sequence(const float *x_seq, float *h_out, int seq_length, int input_size, int hidden_size, int batch,
+                  int *status);
+
+#endif // RNN_HOST
 
 #endif // RNN_H
@@ -0,0 +1,56 @@
+#ifndef RNN_HW_WEIGHTS_H
+#define RNN_HW_WEIGHTS_H
+
+// The hand-set RNN_HW weights, 5 inputs and 16 hidden units, shared by the
+// kernel's initializers (rnn.cpp) and the CPU float reference
+// (LSTM_RNN_CPU/rnn_model.h) so the two cannot drift apart. Every row is
+// set; the first four rows of W and the top-left 4x4 block of U are the
+// original values. Plain brace initializers, usable from C++11 and HLS.
+
+#define RNN_HW_INPUT_SIZE 5
+#define RNN_HW_HIDDEN_SIZE 16
+
+#define RNN_HW_W_INIT { \
+    {0.0543, -0.0234, 0.0675, -0.0812, 0.0398}, \
+    {-0.0457, 0.0321, -0.0104, 0.0932, -0.0671}, \
+    {0.0223, -0.0785, 0.0416, -0.0123, 0.0887}, \
+    {-0.0371, 0.0465, -0.0568, 0.0721, -0.0352}, \
+    {-0.0172, -0.0663, 0.0377, -0.0486, 0.0148}, \
+    {-0.0792, -0.0765, -0.0759, -0.0149, -0.0479}, \
+    {0.0170, 0.0577, 0.0641, -0.0533, -0.0872}, \
+    {0.0274, 0.0534, 0.0394, -0.0185, 0.0700}, \
+    {-0.0320, 0.0502, 0.0662, 0.0483, 0.0341}, \
+    {0.0127, -0.0920, -0.0443, -0.0215, 0.0792}, \
+    {0.0220, -0.0257, -0.0188, -0.0886, 0.0301}, \
+    {-0.0693, 0.0788, -0.0198, -0.0464, -0.0295}, \
+    {-0.0885, -0.0277, 0.0339, 0.0333, 0.0258}, \
+    {-0.0319, -0.0913, 0.0472, 0.0950, 0.0882}, \
+    {-0.0208, 0.0444, -0.0467, 0.0295, 0.0388}, \
+    {0.0147, 0.0617, 0.0127, -0.0372, -0.0412} \
+}
+
+#define RNN_HW_U_INIT { \
+    {0.0625, -0.0492, 0.0108, -0.0715, -0.0422, 0.0123, 0.0449, -0.0428, -0.0470, -0.0326, 0.0772, -0.0201, 0.0472, -0.0710, -0.0152, -0.0284}, \
+    {-0.0537, 0.0304, -0.0417, 0.0552, -0.0105, -0.0409, 0.0913, 0.0470, 0.0856, -0.0695, -0.0298, 0.0427, 0.0928, 0.0624, -0.0119, 0.0449}, \
+    {0.0185, -0.0673, 0.0241, -0.0811, -0.0599, 0.0718, 0.0809, 0.0490, 0.0932, 0.0287, -0.0129, -0.0429, -0.0826, 0.0359, 0.0627, -0.0317}, \
+    {0.0456, -0.0327, 0.0732, -0.0554, -0.0907, -0.0141, 0.0269, -0.0803, 0.0559, -0.0562, -0.0318, -0.0855, -0.0527, -0.0119, 0.0902, 0.0756}, \
+    {0.0604, -0.0639, -0.0178, 0.0652, 0.0126, 0.0917, -0.0268, 0.0225, -0.0705, 0.0707, 0.0292, 0.0170, 0.0146, 0.0213, -0.0199, -0.0858}, \
+    {-0.0445, 0.0905, 0.0660, -0.0143, -0.0373, -0.0314, 0.0767, -0.0826, 0.0517, -0.0544, -0.0666, -0.0647, -0.0803, -0.0330, 0.0812, 0.0949}, \
+    {0.0525, -0.0283, -0.0369, 0.0223, 0.0585, 0.0181, -0.0854, 0.0921, -0.0630, 0.0851, 0.0182, 0.0362, 0.0301, 0.0692, -0.0183, -0.0248}, \
+    {-0.0412, 0.0317, 0.0277, -0.0391, -0.0377, -0.0805, 0.0386, -0.0538, 0.0219, -0.0795, -0.0474, -0.0518, -0.0767, -0.0188, 0.0442, 0.0745}, \
+    {0.0404, -0.0865, -0.0511, 0.0681, 0.0177, 0.0466, -0.0469, 0.0223, -0.0829, 0.0590, 0.0793, 0.0202, 0.0473, 0.0433, -0.0330, -0.0293}, \
+    {-0.0511, 0.0509, 0.0729, -0.0908, -0.0857, -0.0399, 0.0741, -0.0197, 0.0801, -0.0305, -0.0241, -0.0488, -0.0633, -0.0269, 0.0489, 0.0379}, \
+    {0.0933, -0.0717, -0.0911, 0.0780, 0.0910, 0.0395, -0.0651, 0.0360, -0.0512, 0.0768, 0.0855, 0.0845, 0.0920, 0.0675, -0.0434, -0.0622}, \
+    {-0.0689, 0.0240, 0.0282, -0.0654, -0.0135, -0.0109, 0.0743, -0.0300, 0.0601, -0.0620, -0.0584, -0.0490, -0.0202, -0.0772, 0.0392, 0.0328}, \
+    {0.0107, -0.0427, -0.0900, 0.0289, 0.0269, 0.0570, -0.0234, 0.0947, -0.0650, 0.0727, 0.0322, 0.0203, 0.0931, 0.0931, -0.0381, -0.0605}, \
+    {-0.0648, 0.0774, 0.0679, -0.0307, -0.0617, -0.0378, 0.0249, -0.0430, 0.0418, -0.0330, -0.0792, -0.0172, -0.0208, -0.0475, 0.0539, 0.0205}, \
+    {0.0536, -0.0233, -0.0127, 0.0692, 0.0180, 0.0369, -0.0648, 0.0738, -0.0921, 0.0361, 0.0369, 0.0759, 0.0431, 0.0642, -0.0757, -0.0349}, \
+    {-0.0548, 0.0773, 0.0677, -0.0706, -0.0591, -0.0419, 0.0910, -0.0765, 0.0809, -0.0636, -0.0572, -0.0298, -0.0364, -0.0133, 0.0261, 0.0714} \
+}
+
+#define RNN_HW_B_INIT { \
+    0.0000, 0.0100, -0.0200, 0.0300, 0.0145, -0.0226, -0.0121, 0.0112, \
+    0.0215, 0.0199, -0.0121, 0.0143, -0.0269, 0.0040, 0.0113, 0.0035 \
+}
+
+#endif // RNN_HW_WEIGHTS_H
@@ -9,6 +9,7 @@
 #include "rnn.h"          // Include the main RNN header file
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 typedef ap_fixed<32, 16> fixed_type;
 
@@ -17,12 +18,14 @@ typedef ap_fixed<32, 16> fixed_type;
 #define INPUT_SIZE 5     // Number of features per day (Open, Close, High, Low, Volume)
 #define HIDDEN_SIZE 16   // Size of the RNN hidden state
 
-// Declare input data array and hidden state
-extern fixed_type x_seq[SEQ_LENGTH][INPUT_SIZE];
-extern fixed_type h[HIDDEN_SIZE];
+// Declare input series (rows x INPUT_SIZE, as the kernel reads it) and hidden state
+extern std::vector<float> series;
+extern float h[HIDDEN_SIZE];
 
 // Function declarations
-void load_data(const char* filename);
-void predict_next_day(fixed_type input_seq[SEQ_LENGTH][INPUT_SIZE], fixed_type next_day_prediction[INPUT_SIZE]);
+int load_data(const char* filename);
+bool predict_next_day(const float* input_seq, float next_day_prediction[INPUT_SIZE]);
+bool check_against_reference(int seq_length);
+bool check_bad_arguments();
 
 #endif // TESTBENCH_H